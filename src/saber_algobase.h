@@ -121,8 +121,8 @@ OutputIter copy(InputIter first, InputIter last, OutputIter result) {
 template<class BidirectionalIter1, class BidirectionalIter2>
 BidirectionalIter2
 unchecked_copy_backward_cat(BidirectionalIter1 first, BidirectionalIter1 last,
-                   BidirectionalIter2 result, saberstl::random_access_iterator_tag) {
-    while (first != last) *result-- = *last--;
+                   BidirectionalIter2 result, saberstl::bidirectional_iterator_tag) {
+    while (first != last) *--result = *--last;
     return result;
 }
 
@@ -131,14 +131,14 @@ template<class BidirectionalIter1, class BidirectionalIter2>
 BidirectionalIter2
 unchecked_copy_backward_cat(BidirectionalIter1 first, BidirectionalIter1 last,
                    BidirectionalIter2 result, saberstl::random_access_iterator_tag) {
-    for(auto n = last - result; n > 0; n--, result--, last--) *result = *last;
+    for (auto n = last - first; n > 0; n--) *--result = *--last;
     return result;
 }
 
 template<class BidirectionalIter1, class BidirectionalIter2>
 BidirectionalIter2
 unchecked_copy_backward(BidirectionalIter1 first, BidirectionalIter1 last, BidirectionalIter2 result) {
-    return unchecked_copy_backward_cat(first, last, result);
+    return unchecked_copy_backward_cat(first, last, result, iterator_category(first));
 }
 
 // copy_backward() for trivially_copy_assignable
@@ -208,7 +208,7 @@ copy_n(InputIter first, Size n, OutputIter result) {
 template<class InputIter, class OutputIter>
 OutputIter
 unchecked_move_cat(InputIter first, InputIter last, OutputIter result, saberstl::input_iterator_tag) {
-    for (l first != last; first++, result++) *result = saberstl::move(*first);
+    for (; first != last; first++, result++) *result = saberstl::move(*first);
     return result;
 }
 
@@ -262,7 +262,7 @@ unchecked_move_backward_cat(BidirectionalIter1 first, BidirectionalIter1 last,
 // random_access_iterator_tag version
 template<class RandomIter1, class RandomIter2>
 RandomIter2
-unchecked_copy_backward_cat(RandomIter1 first, RandomIter1 last,
+unchecked_move_backward_cat(RandomIter1 first, RandomIter1 last,
                             RandomIter2 result, saberstl::random_access_iterator_tag) {
     for (auto n = last - first; n > 0; n--) {
         *--result = saberstl::move(*--last);
@@ -273,7 +273,7 @@ unchecked_copy_backward_cat(RandomIter1 first, RandomIter1 last,
 template<class BidirectionalIter1, class BidirectionalIter2>
 BidirectionalIter2
 unchecked_move_backward(BidirectionalIter1 first, BidirectionalIter1 last, BidirectionalIter2 result) {
-    return unchecked_copy_backward_cat(first, last, result, iterator_category(first));
+    return unchecked_move_backward_cat(first, last, result, iterator_category(first));
 }
 
 // specific version for trivially_copy_assignable
@@ -401,7 +401,7 @@ bool lexicographical_compare(InputIter1 first1, InputIter1 last1, InputIter2 fir
 }
 
 // Specific version for const unsigned char*
-bool lexicographical_compare(const unsigned char* first1, const unsigned char* last1, const unsigned char* first2, const unsigned char* last2) {
+inline bool lexicographical_compare(const unsigned char* first1, const unsigned char* last1, const unsigned char* first2, const unsigned char* last2) {
     const auto len1 = last1 - first1;
     const auto len2 = last2 - first2;
     // First compare the element in the same length
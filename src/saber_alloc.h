@@ -9,6 +9,20 @@
 #include <new>
 #include <cstddef>
 #include <cstdio>
+#include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+#include "saber_page_provider.h"
+#include "saber_alloc_profiler.h"
+#include "saber_alloc_debug.h"
 
 namespace saberstl {
 
@@ -22,6 +36,20 @@ union Freelist {
     char data[1];           // store the first address of the current memory part
 };
 
+/*
+ * Common part: chunk_header
+ * Every chunk obtained by the memory pool starts with a header, the chunks
+ * are linked so that the ones with no block in use can be released.
+*/
+struct chunk_header {
+    chunk_header *next;     // point to next chunk
+    size_t bytes;           // bytes of the chunk following the header
+    page_provider *provider;    // where the chunk comes from
+#ifdef SABERSTL_ALLOC_LOCK_FREE
+    std::atomic<char*> cursor;  // first byte not cut into blocks yet
+#endif
+};
+
 /*
  * Different memory range 
 */ 
@@ -37,9 +65,243 @@ enum {
 /* Memory size for small object */
 enum { ESmallObjectBytes = 4096 };
 
+/* Size of a cache line, align the data shared by threads to it */
+enum { ECacheLineBytes = 64 };
+
 /* Number of free lists */
 enum { EFreeListsNumber = 56 };
 
+/* Bytes moved between a thread cache and the shared pool at once */
+enum { ETransferBytes = 16384 };
+
+/* Bounds of the number of blocks moved at once */
+enum {
+    EMinTransferBlocks = 2,
+    EMaxTransferBlocks = 64
+};
+
+/* Slow paths of a thread between two decays of its cold batches */
+enum { EBatchDecayEvents = 256 };
+
+/*
+ * Lock-free mode of the memory pool
+ * Define SABERSTL_ALLOC_LOCK_FREE before including this file to share the
+ * free lists among threads without a lock and without thread caches. The
+ * chunks are never released in this mode, so trim() does nothing.
+*/
+
+/*
+ * Debug mode of the memory pool
+ * Define SABERSTL_ALLOC_DEBUG before including this file to guard every
+ * block with red zones and delay its reuse, see saber_alloc_debug.h.
+*/
+
+/*
+ * Statistics of the memory pool
+ * Define SABERSTL_ALLOC_STATS before including this file to count the
+ * activity of alloc, the counters are compiled out by default.
+*/
+#ifdef SABERSTL_ALLOC_STATS
+#define SABERSTL_ALLOC_STAT(expr) expr
+#else
+#define SABERSTL_ALLOC_STAT(expr)
+#endif
+
+
+/*
+ * class spin_lock: guard the shared part of the memory pool
+ * It is trivially destructible, so the blocks released by thread_local
+ * destructors while the process is exiting can still take the lock.
+*/
+class spin_lock {
+private:
+    std::atomic_flag flag_ = ATOMIC_FLAG_INIT;
+
+public:
+    void lock() noexcept {
+        while (flag_.test_and_set(std::memory_order_acquire)) {
+            std::this_thread::yield();
+        }
+    }
+
+    void unlock() noexcept {
+        flag_.clear(std::memory_order_release);
+    }
+};
+
+
+#ifdef SABERSTL_ALLOC_LOCK_FREE
+/*
+ * class lock_free_list: a free list shared by threads without a lock
+ * It is a Treiber stack. Beside the pointer, the head keeps a tag which
+ * changes on every update, so a pop that has read the next of a block
+ * taken and given back by other threads meanwhile fails and retries
+ * instead of linking a block in use (the ABA problem).
+ * The pointer takes the low 48 bits of the head on 64-bit systems, where
+ * the user space addresses are shorter than that, and 32 bits on 32-bit
+ * systems; the tag takes the rest.
+ * A pop may read the next of a block just taken by another thread, so a
+ * block pushed into the list must never be given back to the system.
+*/
+class alignas(ECacheLineBytes) lock_free_list {
+private:
+    std::atomic<uint64_t> head_;
+#ifdef SABERSTL_ALLOC_STATS
+    std::atomic<size_t> count_;     // blocks in the list
+#endif
+
+    enum : unsigned { EPointerBits = sizeof(void*) == 8 ? 48 : 32 };
+
+    static constexpr uint64_t S_pointer_mask =
+        (static_cast<uint64_t>(1) << EPointerBits) - 1;
+
+public:
+    constexpr lock_free_list() noexcept
+    : head_(0)
+#ifdef SABERSTL_ALLOC_STATS
+    , count_(0)
+#endif
+    {}
+
+    /* Push the chain [first, last] of count blocks */
+    void push(Freelist *first, Freelist *last, size_t count = 1) noexcept {
+        uint64_t old = head_.load(std::memory_order_relaxed);
+        do {
+            S_set_next(last, S_pointer(old));
+        } while (!head_.compare_exchange_weak(old, S_pack(first, old),
+                 std::memory_order_release, std::memory_order_relaxed));
+        (void)count;
+        SABERSTL_ALLOC_STAT(count_.fetch_add(count, std::memory_order_relaxed));
+    }
+
+    /* Pop a block, nullptr if the list is empty */
+    Freelist *pop() noexcept {
+        uint64_t old = head_.load(std::memory_order_acquire);
+        for (;;) {
+            Freelist *p = S_pointer(old);
+            if (p == nullptr) return nullptr;
+            Freelist *next = S_next(p);
+            if (head_.compare_exchange_weak(old, S_pack(next, old),
+                std::memory_order_acquire, std::memory_order_acquire)) {
+                SABERSTL_ALLOC_STAT(count_.fetch_sub(1, std::memory_order_relaxed));
+                return p;
+            }
+        }
+    }
+
+#ifdef SABERSTL_ALLOC_STATS
+    size_t size() const noexcept {
+        return count_.load(std::memory_order_relaxed);
+    }
+#endif
+
+private:
+    /*
+     * The next of the head is read while other threads may push it, so it
+     * is accessed atomically where the compiler offers that.
+    */
+    static Freelist *S_next(Freelist *p) noexcept {
+#if defined(__GNUC__)
+        return __atomic_load_n(&p->next, __ATOMIC_RELAXED);
+#else
+        return p->next;
+#endif
+    }
+
+    static void S_set_next(Freelist *p, Freelist *next) noexcept {
+#if defined(__GNUC__)
+        __atomic_store_n(&p->next, next, __ATOMIC_RELAXED);
+#else
+        p->next = next;
+#endif
+    }
+
+    static Freelist *S_pointer(uint64_t head) noexcept {
+        return reinterpret_cast<Freelist*>(static_cast<uintptr_t>(head & S_pointer_mask));
+    }
+
+    /* The new head points to p and has the next tag of old */
+    static uint64_t S_pack(Freelist *p, uint64_t old) noexcept {
+        return static_cast<uint64_t>(reinterpret_cast<uintptr_t>(p)) |
+               ((old | S_pointer_mask) + 1);
+    }
+};
+#endif
+
+
+#ifdef SABERSTL_ALLOC_STATS
+/*
+ * struct alloc_stats: a snapshot of the counters of alloc
+ * It is taken by alloc::statistics() and can be printed as text or JSON.
+*/
+struct alloc_class_stats {
+    size_t block_size;      // size of the blocks of this class
+    size_t allocs;          // number of allocate
+    size_t deallocs;        // number of deallocate
+    size_t in_use;          // blocks held by the users
+    size_t thread_cached;   // free blocks in the thread caches
+    size_t pool_cached;     // free blocks in the shared free list
+    size_t refills;         // batches fetched from the shared pool
+    size_t overflows;       // batches given back to the shared pool
+    size_t batch;           // largest batch of the live thread caches
+};
+
+struct alloc_stats {
+    alloc_class_stats classes[EFreeListsNumber];
+    size_t heap_bytes;          // bytes obtained for the memory pool
+    size_t pool_bytes;          // bytes of the pool not cut into blocks yet
+    size_t bytes_in_use;        // bytes of the small blocks held by the users
+    size_t bytes_cached;        // bytes of the free small blocks
+    size_t chunk_grows;         // times the memory pool grows
+    size_t chunk_releases;      // chunks released by trim
+    size_t large_allocs;        // allocate served by std::malloc
+    size_t large_deallocs;      // deallocate served by std::free
+    size_t large_bytes_in_use;  // bytes held by the std::malloc fallbacks
+    size_t threads;             // number of live thread caches
+
+    void print(std::FILE *out) const;
+    void print_json(std::FILE *out) const;
+};
+#endif
+
+/*
+ * struct node_pool: the shared part of the memory pool on a NUMA node
+ * Its free lists and memory pool are guarded by its lock. The chunks come
+ * from numa_pages(node) when the system has more than one node, so the
+ * threads running on a node take local memory.
+*/
+struct alignas(ECacheLineBytes) node_pool {
+    char *start_free;       // Start point of memory pool
+    char *end_free;         // End point of memory pool
+    size_t heap_size;       // The addent space for applying heap
+
+    Freelist *free_list[EFreeListsNumber];  // Store the freelist
+    chunk_header *chunk_list;               // Chunks of memory pool
+
+    spin_lock lock;         // Guard the free lists and pool
+
+    size_t free_bytes;      // Bytes of blocks in free lists
+    size_t trim_threshold;  // Trim automatically over this, 0 for never
+    size_t trim_mark;       // Free bytes to trigger the next trim
+    size_t node;            // NUMA node of the chunks
+
+#ifdef SABERSTL_ALLOC_STATS
+    size_t free_blocks[EFreeListsNumber];   // Blocks in free lists
+    size_t chunk_grows;                     // Times the pool grows
+    size_t chunk_releases;                  // Chunks released
+#endif
+
+    constexpr node_pool(size_t id = 0) noexcept
+    : start_free(nullptr), end_free(nullptr), heap_size(0), free_list(),
+      chunk_list(nullptr), lock(), free_bytes(0), trim_threshold(0),
+      trim_mark(0), node(id)
+#ifdef SABERSTL_ALLOC_STATS
+    , free_blocks(), chunk_grows(0), chunk_releases(0)
+#endif
+    {}
+};
+
+class thread_cache;
 
 /*
  * class alloc: to alloc the memory
@@ -47,83 +309,656 @@ enum { EFreeListsNumber = 56 };
  * std::malloc & std::free directly;
  * If the current memory is small, use memory pool to manage them. Each 
  * time alloc a large part of memory and maintain the freelist it owns.
+ *
+ * The free lists and the memory pool are shared by all threads and
+ * guarded by a lock. Every thread keeps its own cache (thread_cache) in
+ * front of them, so allocate/deallocate only visit the shared part when
+ * the cache of the current thread runs empty or grows too long.
+ * There is one shared part (node_pool) for every NUMA node, a thread uses
+ * the one of the node it runs on when its cache is created, so pin the
+ * threads to their nodes. A block goes back to the pool of the thread
+ * freeing it. On a system without NUMA there is only one pool.
+ * In the lock-free mode, the threads share lock_free_lists directly and
+ * cut the chunks by moving an atomic cursor, only growing takes the lock.
 */
 class alloc {
+    friend class thread_cache;
+
 private:
-    static char *start_free;        // Start point of memory pool
-    static char *end_free;          // End point of memory pool
-    static size_t heap_size;        // The addent space for applying heap
+    /*
+     * The shared state lives in function-local statics, so every
+     * translation unit including this header refers to the same one.
+    */
+    static node_pool *S_pools() noexcept;    // Shared part of every node
+
+    static spin_lock& S_lock() noexcept;    // Guard the list of thread caches
+
+    static std::atomic<page_provider*>& S_provider() noexcept;    // Source of chunks, nullptr for default
 
-    static Freelist *free_list[EFreeListsNumber];   // Store the freelist
+#ifdef SABERSTL_ALLOC_LOCK_FREE
+    static lock_free_list *free_stack() noexcept;               // Free lists without lock
+    static std::atomic<chunk_header*>& S_carving() noexcept;    // Chunk being cut into blocks
+#endif
+
+#ifdef SABERSTL_ALLOC_STATS
+    static thread_cache*& S_caches() noexcept;                  // Live thread caches
+    static std::atomic<size_t> *S_retired_allocs() noexcept;
+    static std::atomic<size_t> *S_retired_deallocs() noexcept;
+    static std::atomic<size_t> *S_retired_refills() noexcept;
+    static std::atomic<size_t> *S_retired_overflows() noexcept;
+    static std::atomic<size_t>& S_large_allocs() noexcept;      // malloc fallbacks
+    static std::atomic<size_t>& S_large_deallocs() noexcept;    // free fallbacks
+    static std::atomic<size_t>& S_large_bytes() noexcept;       // bytes held by fallbacks
+#endif
 
 public:
     static void *allocate(size_t n);
     static void deallocate(void *p, size_t n);
     static void *reallocate(void *p, size_t old_size, size_t new_size);
 
+    static void *allocate(size_t n, size_t align);
+    static void deallocate(void *p, size_t n, size_t align);
+
+    static void allocate_bulk(size_t n, size_t count, void **out);
+    static void deallocate_bulk(size_t n, size_t count, void **blocks);
+
+    static void *allocate_on(size_t node, size_t n);
+    static void deallocate_on(size_t node, void *p, size_t n);
+
+    static void flush_thread_cache();
+
+    static size_t trim();
+    static void set_trim_threshold(size_t bytes);
+
+    static page_provider *set_page_provider(page_provider *provider);
+
+#ifdef SABERSTL_ALLOC_STATS
+    static alloc_stats statistics();
+#endif
+
 private:
     static size_t S_align(size_t bytes);
     static size_t S_round_up(size_t bytes);
+    static size_t S_round_down(size_t bytes);
     static size_t S_freelist_index(size_t bytes);
-    static void *S_refill(size_t n);
-    static char *S_chunk_alloc(size_t size, size_t& nobj);
+    static size_t S_block_size(size_t index);
+    static size_t S_transfer_blocks(size_t bytes);
+    static void *S_allocate(size_t n);
+    static void S_deallocate(void *p, size_t n);
+    static node_pool& S_local_pool();
+    static page_provider *S_pages(const node_pool& pool);
+    static size_t S_fetch(node_pool& pool, size_t n, size_t nblock, Freelist*& chain);
+    static void S_release(node_pool& pool, size_t n, Freelist *first, Freelist *last,
+                          size_t count);
+    static void S_push_fragment(node_pool& pool, char *p, size_t bytes);
+    static Freelist *S_refill(node_pool& pool, size_t n, size_t& nblock);
+    static void S_link(void **blocks, size_t count);
+    static char *S_chunk_alloc(node_pool& pool, size_t size, size_t& nobj);
+    static chunk_header *S_trim(node_pool& pool);
+    static size_t S_trim_node(node_pool& pool);
+#ifdef SABERSTL_ALLOC_LOCK_FREE
+    static void *S_pop(size_t n);
+    static void S_pop_bulk(size_t n, size_t count, void **out, size_t& done);
+    static char *S_carve(size_t size, size_t& nblock);
+    static void S_grow(chunk_header *old, size_t need_bytes);
+#endif
+    static void *S_aligned_malloc(size_t n, size_t align);
+    static void S_aligned_free(void *p);
 };
 
 /* Initial static variables */
 
-char* alloc::start_free = nullptr;
-char* alloc::end_free = nullptr;
-size_t alloc::heap_size = 0;
-
-Freelist* alloc::free_list[EFreeListsNumber] = {
-    nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,
-    nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,
-    nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,
-    nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,
-    nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,
-    nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,
-    nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr,nullptr
+inline node_pool* alloc::S_pools() noexcept {
+    static node_pool pools[EMaxNumaNodes] = {
+        {0}, {1}, {2}, {3}, {4}, {5}, {6}, {7}
+    };
+    return pools;
+}
+
+inline spin_lock& alloc::S_lock() noexcept {
+    static spin_lock lock;
+    return lock;
+}
+
+inline std::atomic<page_provider*>& alloc::S_provider() noexcept {
+    static std::atomic<page_provider*> provider(nullptr);
+    return provider;
+}
+
+#ifdef SABERSTL_ALLOC_LOCK_FREE
+inline lock_free_list* alloc::free_stack() noexcept {
+    static lock_free_list stack[EFreeListsNumber];
+    return stack;
+}
+
+inline std::atomic<chunk_header*>& alloc::S_carving() noexcept {
+    static std::atomic<chunk_header*> carving(nullptr);
+    return carving;
+}
+#endif
+
+#ifdef SABERSTL_ALLOC_STATS
+inline thread_cache*& alloc::S_caches() noexcept {
+    static thread_cache *caches = nullptr;
+    return caches;
+}
+
+inline std::atomic<size_t>* alloc::S_retired_allocs() noexcept {
+    static std::atomic<size_t> counts[EFreeListsNumber] = {};
+    return counts;
+}
+
+inline std::atomic<size_t>* alloc::S_retired_deallocs() noexcept {
+    static std::atomic<size_t> counts[EFreeListsNumber] = {};
+    return counts;
+}
+
+inline std::atomic<size_t>* alloc::S_retired_refills() noexcept {
+    static std::atomic<size_t> counts[EFreeListsNumber] = {};
+    return counts;
+}
+
+inline std::atomic<size_t>* alloc::S_retired_overflows() noexcept {
+    static std::atomic<size_t> counts[EFreeListsNumber] = {};
+    return counts;
+}
+
+inline std::atomic<size_t>& alloc::S_large_allocs() noexcept {
+    static std::atomic<size_t> count(0);
+    return count;
+}
+
+inline std::atomic<size_t>& alloc::S_large_deallocs() noexcept {
+    static std::atomic<size_t> count(0);
+    return count;
+}
+
+inline std::atomic<size_t>& alloc::S_large_bytes() noexcept {
+    static std::atomic<size_t> bytes(0);
+    return bytes;
+}
+#endif
+
+
+/*
+ * class thread_cache: the cache of the current thread
+ * It keeps one magazine (a short free list) for every size class. When a
+ * magazine is empty, a batch of blocks is fetched from the shared pool;
+ * when it grows over two batches, one batch is given back. When the thread
+ * exits, all the cached blocks are returned to the shared pool.
+ * The batch of every class adapts to its use: it starts small and doubles
+ * on every refill or overflow, up to ETransferBytes (see S_transfer_blocks).
+ * Every EBatchDecayEvents slow paths, the classes not refilled or
+ * overflowed meanwhile halve their batch and give the extra blocks back.
+*/
+class thread_cache {
+    friend class alloc;
+
+private:
+    struct magazine {
+        Freelist *head;     // first cached block
+        size_t count;       // number of cached blocks
+        size_t batch;       // number of blocks moved at once
+        size_t events;      // slow paths since the last decay
+    };
+
+    magazine mags_[EFreeListsNumber];
+    size_t events_;         // slow paths of all classes since the last decay
+    node_pool *pool_;       // shared pool of the node of this thread
+
+#ifdef SABERSTL_ALLOC_STATS
+    /* Written only by the owner thread, read by alloc::statistics() */
+    struct counter {
+        std::atomic<size_t> allocs;
+        std::atomic<size_t> deallocs;
+        std::atomic<size_t> cached;
+        std::atomic<size_t> refills;
+        std::atomic<size_t> overflows;
+        std::atomic<size_t> batch;
+    };
+
+    counter counters_[EFreeListsNumber];
+    thread_cache *prev_;
+    thread_cache *next_;
+#endif
+
+    /* Cache of current thread */
+    static thread_cache*& S_local() noexcept {
+        static thread_local thread_cache *local = nullptr;
+        return local;
+    }
+    /* The cache of current thread has been destroyed */
+    static bool& S_exited() noexcept {
+        static thread_local bool exited = false;
+        return exited;
+    }
+
+public:
+    thread_cache() noexcept : mags_(), events_(0), pool_(&alloc::S_local_pool()) {
+        for (size_t i = 0; i < EFreeListsNumber; i++) {
+            mags_[i].batch = EMinTransferBlocks;
+            SABERSTL_ALLOC_STAT(counters_[i].batch.store(EMinTransferBlocks,
+                                std::memory_order_relaxed));
+        }
+    }
+    ~thread_cache();
+
+    void *allocate(size_t n);
+    void deallocate(void *p, size_t n);
+    void allocate_bulk(size_t n, size_t count, void **out, size_t& done);
+    void deallocate_bulk(size_t n, size_t count, void **blocks);
+    void flush();
+
+    /* Return the cache of current thread, nullptr if the thread is exiting */
+    static thread_cache *local() {
+        return S_local() != nullptr ? S_local() : S_create();
+    }
+
+    /* Return the cache of current thread if it has been created */
+    static thread_cache *current() noexcept {
+        return S_local();
+    }
+
+private:
+    void shrink(size_t index, size_t n, size_t nblock);
+    void adapt(size_t index, size_t n);
+    void decay();
+    static thread_cache *S_create();
+
+#ifdef SABERSTL_ALLOC_STATS
+    /* Only the owner writes the counter, no read-modify-write is needed */
+    static void S_add(std::atomic<size_t>& c, size_t n) noexcept {
+        c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+#endif
+
+private:
+    thread_cache(const thread_cache&);
+    void operator=(const thread_cache&);
 };
 
 /* Alloc space of size n, n > 0 */
 inline void* alloc::allocate(size_t n) {
-    Freelist *my_free_list;
-    Freelist *result;
-    if (n > static_cast<size_t>(ESmallObjectBytes)) return std::malloc(n);
-    my_free_list = free_list[S_freelist_index(n)];
-    result = my_free_list;
-    if (result == nullptr) {
-        void *r = S_refill(S_round_up(n));
-        return r;
-    }
-    my_free_list = result->next;
+#ifdef SABERSTL_ALLOC_DEBUG
+    void *result = alloc_debug::on_allocate(S_allocate(alloc_debug::raw_size(n)), n);
+#else
+    void *result = S_allocate(n);
+#endif
+    SABERSTL_ALLOC_PROFILE_HOOK(alloc_profiler::on_allocate(result, n));
     return result;
 }
 
 /* Free p points to the space of size n, p cannot be 0 */
 inline void alloc::deallocate(void *p, size_t n) {
+    SABERSTL_ALLOC_PROFILE_HOOK(alloc_profiler::on_deallocate(p));
+#ifdef SABERSTL_ALLOC_DEBUG
+    /* Check and poison p, give back the blocks leaving the quarantine */
+    alloc_debug::on_deallocate(p, n);
+    void *raw;
+    size_t raw_n;
+    while (alloc_debug::evict(raw, raw_n)) S_deallocate(raw, raw_n);
+#else
+    S_deallocate(p, n);
+#endif
+}
+
+/* Take a block of size n from the pool or the system */
+inline void* alloc::S_allocate(size_t n) {
+    void *result;
+    if (n > static_cast<size_t>(ESmallObjectBytes)) {
+        SABERSTL_ALLOC_STAT(S_large_allocs().fetch_add(1, std::memory_order_relaxed));
+        SABERSTL_ALLOC_STAT(S_large_bytes().fetch_add(n, std::memory_order_relaxed));
+        result = std::malloc(n);
+    } else {
+#ifdef SABERSTL_ALLOC_LOCK_FREE
+        SABERSTL_ALLOC_STAT(S_retired_allocs()[S_freelist_index(n)].fetch_add(1,
+                            std::memory_order_relaxed));
+        result = S_pop(n);
+#else
+        thread_cache *cache = thread_cache::local();
+        if (cache != nullptr) {
+            result = cache->allocate(n);
+        } else {
+            /* The thread is exiting, take one block from the shared pool */
+            SABERSTL_ALLOC_STAT(S_retired_allocs()[S_freelist_index(n)].fetch_add(1,
+                                std::memory_order_relaxed));
+            Freelist *block;
+            S_fetch(S_local_pool(), S_round_up(n), 1, block);
+            result = block;
+        }
+#endif
+    }
+    return result;
+}
+
+/* Give back p of size n taken by S_allocate */
+inline void alloc::S_deallocate(void *p, size_t n) {
     if (n > static_cast<size_t>(ESmallObjectBytes)) {
+        SABERSTL_ALLOC_STAT(S_large_deallocs().fetch_add(1, std::memory_order_relaxed));
+        SABERSTL_ALLOC_STAT(S_large_bytes().fetch_sub(n, std::memory_order_relaxed));
         std::free(p);
         return;
     }
+#ifdef SABERSTL_ALLOC_LOCK_FREE
+    SABERSTL_ALLOC_STAT(S_retired_deallocs()[S_freelist_index(n)].fetch_add(1,
+                        std::memory_order_relaxed));
+    Freelist *q = reinterpret_cast<Freelist*>(p);
+    free_stack()[S_freelist_index(n)].push(q, q);
+#else
+    thread_cache *cache = thread_cache::local();
+    if (cache != nullptr) {
+        cache->deallocate(p, n);
+        return;
+    }
+    SABERSTL_ALLOC_STAT(S_retired_deallocs()[S_freelist_index(n)].fetch_add(1,
+                        std::memory_order_relaxed));
     Freelist *q = reinterpret_cast<Freelist*>(p);
-    Freelist *my_free_list;
-    my_free_list = free_list[S_freelist_index(n)];
-    q->next = my_free_list;
-    my_free_list = q;
+    q->next = nullptr;
+    S_release(S_local_pool(), S_round_up(n), q, q, 1);
+#endif
 }
 
 /*
- * Realloc the space.
+ * Realloc the space, the contents up to the smaller size are kept.
  * The function receives three parameters:
- * p: pointer points to new space
+ * p: pointer points to the old space, or nullptr to only allocate
  * old_size: origin space size
  * new_size: new space size
+ * A block stays in place when the new size falls in its size class. Two
+ * large blocks are resized by std::realloc, which moves the pages of a
+ * mapped block by mremap instead of copying them. Otherwise a new block
+ * is allocated, the contents are copied and p is freed. If no memory is
+ * got, p is left untouched.
 */
 inline void* alloc::reallocate(void *p, size_t old_size, size_t new_size) {
+    if (p == nullptr) return allocate(new_size);
+#ifndef SABERSTL_ALLOC_DEBUG
+    const size_t small = static_cast<size_t>(ESmallObjectBytes);
+    if (old_size <= small && new_size <= small &&
+        S_freelist_index(old_size) == S_freelist_index(new_size)) {
+        return p;
+    }
+    if (old_size > small && new_size > small) {
+        /* p is still the caller's when realloc fails, forget it only after;
+           by its address, as the block may be gone */
+        SABERSTL_ALLOC_PROFILE_HOOK(const uintptr_t old = reinterpret_cast<uintptr_t>(p));
+        void *q = std::realloc(p, new_size);
+        if (q == nullptr) return nullptr;
+        SABERSTL_ALLOC_PROFILE_HOOK(alloc_profiler::on_deallocate_at(old));
+        SABERSTL_ALLOC_STAT(S_large_bytes().fetch_add(new_size, std::memory_order_relaxed));
+        SABERSTL_ALLOC_STAT(S_large_bytes().fetch_sub(old_size, std::memory_order_relaxed));
+        SABERSTL_ALLOC_PROFILE_HOOK(alloc_profiler::on_allocate(q, new_size));
+        return q;
+    }
+#endif
+    /* The guarded blocks of the debug mode always move to check the old one */
+    void *q = allocate(new_size);
+    if (q == nullptr) return nullptr;
+    std::memcpy(q, p, old_size < new_size ? old_size : new_size);
     deallocate(p, old_size);
-    p = allocate(new_size);
+    return q;
+}
+
+/*
+ * Alloc space of size n aligned to align, align must be a power of 2.
+ * The blocks of free lists are only aligned to EAlign128. For a larger
+ * alignment, a small request takes a block with align more bytes and
+ * keeps the address of the block just before the aligned space; a large
+ * one (such as a huge page aligned buffer) asks the system.
+*/
+inline void* alloc::allocate(size_t n, size_t align) {
+    if (align <= static_cast<size_t>(EAlign128)) return allocate(n);
+    if (n + align > static_cast<size_t>(ESmallObjectBytes)) {
+        SABERSTL_ALLOC_STAT(S_large_allocs().fetch_add(1, std::memory_order_relaxed));
+        SABERSTL_ALLOC_STAT(S_large_bytes().fetch_add(n, std::memory_order_relaxed));
+        void *p = S_aligned_malloc(n, align);
+        SABERSTL_ALLOC_PROFILE_HOOK(alloc_profiler::on_allocate(p, n));
+        return p;
+    }
+    char *raw = static_cast<char*>(allocate(n + align));
+    char *p = raw + align - (reinterpret_cast<uintptr_t>(raw) & (align - 1));
+    reinterpret_cast<char**>(p)[-1] = raw;
+    return p;
+}
+
+/* Free p allocated by allocate(n, align) */
+inline void alloc::deallocate(void *p, size_t n, size_t align) {
+    if (align <= static_cast<size_t>(EAlign128)) {
+        deallocate(p, n);
+        return;
+    }
+    if (n + align > static_cast<size_t>(ESmallObjectBytes)) {
+        SABERSTL_ALLOC_STAT(S_large_deallocs().fetch_add(1, std::memory_order_relaxed));
+        SABERSTL_ALLOC_STAT(S_large_bytes().fetch_sub(n, std::memory_order_relaxed));
+        SABERSTL_ALLOC_PROFILE_HOOK(alloc_profiler::on_deallocate(p));
+        S_aligned_free(p);
+        return;
+    }
+    deallocate(reinterpret_cast<char**>(p)[-1], n + align);
+}
+
+/*
+ * Alloc count blocks of size n into out, n > 0.
+ * The blocks are moved from the shared pool in batches as large as the
+ * rest of the request, instead of one call for each block. Either all the
+ * blocks are got, or none of them and std::bad_alloc is thrown.
+*/
+inline void alloc::allocate_bulk(size_t n, size_t count, void **out) {
+    size_t done = 0;
+#ifdef SABERSTL_ALLOC_DEBUG
+    /* Every block is guarded on its own */
+    for (; done < count; done++) {
+        out[done] = allocate(n);
+        if (out[done] == nullptr) {
+            deallocate_bulk(n, done, out);
+            throw std::bad_alloc();
+        }
+    }
+    return;
+#endif
+    try {
+        if (n > static_cast<size_t>(ESmallObjectBytes)) {
+            for (; done < count; done++) {
+                out[done] = std::malloc(n);
+                if (out[done] == nullptr) throw std::bad_alloc();
+                SABERSTL_ALLOC_STAT(S_large_allocs().fetch_add(1, std::memory_order_relaxed));
+                SABERSTL_ALLOC_STAT(S_large_bytes().fetch_add(n, std::memory_order_relaxed));
+            }
+        } else {
+#ifdef SABERSTL_ALLOC_LOCK_FREE
+            S_pop_bulk(n, count, out, done);
+#else
+            thread_cache *cache = thread_cache::local();
+            if (cache != nullptr) cache->allocate_bulk(n, count, out, done);
+            /* The thread is exiting, take the blocks from the shared pool */
+            while (done < count) {
+                Freelist *chain;
+                size_t got = S_fetch(S_local_pool(), S_round_up(n), count - done, chain);
+                SABERSTL_ALLOC_STAT(S_retired_allocs()[S_freelist_index(n)].fetch_add(got,
+                                    std::memory_order_relaxed));
+                for (; got > 0; got--) {
+                    out[done++] = chain;
+                    chain = chain->next;
+                }
+            }
+#endif
+        }
+    } catch (...) {
+        deallocate_bulk(n, done, out);
+        throw;
+    }
+#ifdef SABERSTL_ALLOC_PROFILE
+    for (size_t i = 0; i < count; i++) alloc_profiler::on_allocate(out[i], n);
+#endif
+}
+
+/*
+ * Free count blocks of size n in blocks, which come from allocate(n) or
+ * allocate_bulk(n, ...). The blocks are linked and spliced at once.
+*/
+inline void alloc::deallocate_bulk(size_t n, size_t count, void **blocks) {
+    if (count == 0) return;
+#ifdef SABERSTL_ALLOC_DEBUG
+    for (size_t i = 0; i < count; i++) deallocate(blocks[i], n);
+    return;
+#endif
+#ifdef SABERSTL_ALLOC_PROFILE
+    for (size_t i = 0; i < count; i++) alloc_profiler::on_deallocate(blocks[i]);
+#endif
+    if (n > static_cast<size_t>(ESmallObjectBytes)) {
+        for (size_t i = 0; i < count; i++) std::free(blocks[i]);
+        SABERSTL_ALLOC_STAT(S_large_deallocs().fetch_add(count, std::memory_order_relaxed));
+        SABERSTL_ALLOC_STAT(S_large_bytes().fetch_sub(n * count, std::memory_order_relaxed));
+        return;
+    }
+#ifdef SABERSTL_ALLOC_LOCK_FREE
+    SABERSTL_ALLOC_STAT(S_retired_deallocs()[S_freelist_index(n)].fetch_add(count,
+                        std::memory_order_relaxed));
+    S_link(blocks, count);
+    free_stack()[S_freelist_index(n)].push(reinterpret_cast<Freelist*>(blocks[0]),
+        reinterpret_cast<Freelist*>(blocks[count - 1]), count);
+#else
+    thread_cache *cache = thread_cache::local();
+    if (cache != nullptr) {
+        cache->deallocate_bulk(n, count, blocks);
+        return;
+    }
+    SABERSTL_ALLOC_STAT(S_retired_deallocs()[S_freelist_index(n)].fetch_add(count,
+                        std::memory_order_relaxed));
+    S_link(blocks, count);
+    S_release(S_local_pool(), S_round_up(n), reinterpret_cast<Freelist*>(blocks[0]),
+              reinterpret_cast<Freelist*>(blocks[count - 1]), count);
+#endif
+}
+
+/*
+ * Alloc space of size n from the pool of NUMA node node, whichever node
+ * current thread runs on. The block skips the thread cache, so every call
+ * takes the lock of the pool. A node the system does not have is taken
+ * modulo the nodes, so on a system without NUMA it is the only pool. The
+ * large blocks, the lock-free mode (one set of lists for all the nodes)
+ * and the debug mode fall back to allocate(n).
+*/
+inline void* alloc::allocate_on(size_t node, size_t n) {
+#if defined(SABERSTL_ALLOC_LOCK_FREE) || defined(SABERSTL_ALLOC_DEBUG)
+    (void)node;
+    return allocate(n);
+#else
+    if (n > static_cast<size_t>(ESmallObjectBytes)) return allocate(n);
+    SABERSTL_ALLOC_STAT(S_retired_allocs()[S_freelist_index(n)].fetch_add(1,
+                        std::memory_order_relaxed));
+    Freelist *block;
+    S_fetch(S_pools()[node % numa_node_count()], S_round_up(n), 1, block);
+    SABERSTL_ALLOC_PROFILE_HOOK(alloc_profiler::on_allocate(block, n));
+    return block;
+#endif
+}
+
+/* Free p allocated by allocate_on(node, n), back to the pool of node */
+inline void alloc::deallocate_on(size_t node, void *p, size_t n) {
+#if defined(SABERSTL_ALLOC_LOCK_FREE) || defined(SABERSTL_ALLOC_DEBUG)
+    (void)node;
+    deallocate(p, n);
+#else
+    if (n > static_cast<size_t>(ESmallObjectBytes)) {
+        deallocate(p, n);
+        return;
+    }
+    SABERSTL_ALLOC_PROFILE_HOOK(alloc_profiler::on_deallocate(p));
+    SABERSTL_ALLOC_STAT(S_retired_deallocs()[S_freelist_index(n)].fetch_add(1,
+                        std::memory_order_relaxed));
+    Freelist *q = reinterpret_cast<Freelist*>(p);
+    q->next = nullptr;
+    S_release(S_pools()[node % numa_node_count()], S_round_up(n), q, q, 1);
+#endif
+}
+
+/* Return all the blocks cached by current thread to the shared pool */
+inline void alloc::flush_thread_cache() {
+    thread_cache *cache = thread_cache::current();
+    if (cache != nullptr) cache->flush();
+}
+
+/*
+ * Release the chunks with no block in use to the system, return the bytes
+ * released. The blocks cached by other threads keep their chunks alive, so
+ * only the cache of current thread is flushed before. A chunk is released
+ * only when all its free blocks are back in the pool of its node.
+*/
+inline size_t alloc::trim() {
+#ifdef SABERSTL_ALLOC_LOCK_FREE
+    /* A pop may be reading a free block of any chunk */
+    return 0;
+#else
+    flush_thread_cache();
+    size_t released = 0;
+    for (size_t i = 0; i < numa_node_count(); i++) released += S_trim_node(S_pools()[i]);
+    return released;
+#endif
+}
+
+/*
+ * Trim automatically when the bytes of blocks in the free lists of a node
+ * grow over bytes since the last trim, 0 turns it off.
+*/
+inline void alloc::set_trim_threshold(size_t bytes) {
+    for (size_t i = 0; i < EMaxNumaNodes; i++) {
+        std::lock_guard<spin_lock> guard(S_pools()[i].lock);
+        S_pools()[i].trim_threshold = bytes;
+        S_pools()[i].trim_mark = S_pools()[i].free_bytes + bytes;
+    }
+}
+
+/* Ask the system for n bytes aligned to align */
+inline void* alloc::S_aligned_malloc(size_t n, size_t align) {
+#if defined(_WIN32)
+    return _aligned_malloc(n, align);
+#elif defined(__unix__) || defined(__APPLE__)
+    void *p = nullptr;
+    return posix_memalign(&p, align, n) == 0 ? p : nullptr;
+#else
+    char *raw = static_cast<char*>(std::malloc(n + align));
+    if (raw == nullptr) return nullptr;
+    char *p = raw + align - (reinterpret_cast<uintptr_t>(raw) & (align - 1));
+    reinterpret_cast<char**>(p)[-1] = raw;
     return p;
+#endif
+}
+
+inline void alloc::S_aligned_free(void *p) {
+#if defined(_WIN32)
+    _aligned_free(p);
+#elif defined(__unix__) || defined(__APPLE__)
+    std::free(p);
+#else
+    std::free(reinterpret_cast<char**>(p)[-1]);
+#endif
+}
+
+/*
+ * Set where the new chunks of all the nodes come from, such as huge_pages(),
+ * nullptr for the default: numa_pages(node) on a NUMA system, malloc_pages()
+ * otherwise. Return the old provider, nullptr for the default. The chunks
+ * already got are released to the provider they come from.
+*/
+inline page_provider* alloc::set_page_provider(page_provider *provider) {
+    return S_provider().exchange(provider, std::memory_order_acq_rel);
+}
+
+/* The pool of the node current thread runs on */
+inline node_pool& alloc::S_local_pool() {
+    return S_pools()[numa_current_node()];
+}
+
+/* Where the new chunks of pool come from */
+inline page_provider* alloc::S_pages(const node_pool& pool) {
+    page_provider *provider = S_provider().load(std::memory_order_acquire);
+    if (provider != nullptr) return provider;
+#ifndef SABERSTL_ALLOC_LOCK_FREE
+    if (numa_node_count() > 1) return numa_pages(pool.node);
+#endif
+    (void)pool;
+    return malloc_pages();
 }
 
 /* bytes correspond to the increase in size */
@@ -143,6 +978,11 @@ inline size_t alloc::S_round_up(size_t bytes) {
     return ((bytes + S_align(bytes) - 1) & ~(S_align(bytes) - 1));
 }
 
+/* Decrease the bytes to the largest interval size not more than it */
+inline size_t alloc::S_round_down(size_t bytes) {
+    return bytes & ~(S_align(bytes) - 1);
+}
+
 /* According the size of chain, choose the nth free lists */
 inline size_t alloc::S_freelist_index(size_t bytes) {
     if (bytes <= 512) {
@@ -159,51 +999,133 @@ inline size_t alloc::S_freelist_index(size_t bytes) {
     : (47 + (bytes + EAlign4096 - 2049) / EAlign4096);
 }
 
-/* Refill the free list */
-void* alloc::S_refill(size_t n) {
-    size_t nblock = 10;
-    char *c = S_chunk_alloc(n, nblock);
-    Freelist *my_free_list;
-    Freelist *result, *cur, *next;
-    /*
-     * If there is only one block,
-     * then return this block to the caller,
-     * there is no new node increasing in the free list
-    */
-    if (nblock == 1) return c;
-    /*
-     * Else return one block to the caller,
-     * and add the rest into free list as the new nodes
-    */
-    my_free_list = free_list[S_freelist_index(n)];
-    result = (Freelist*)c;
-    my_free_list = next = (Freelist*)(c + n);
-    for (size_t i = 1; ; i++) {
-        cur = next;
-        next = (Freelist*)((char*)next + n);
-        if (nblock - 1 == i) {
-            cur->next = nullptr;
-            break;
-        } else {
-            cur->next = next;
+/* The size of blocks in the nth free list, the inverse of S_freelist_index */
+inline size_t alloc::S_block_size(size_t index) {
+    if (index < 16) return (index + 1) * EAlign128;
+    size_t group = (index - 16) / 8;
+    return (static_cast<size_t>(128) << group) +
+           (index - 15 - group * 8) * (static_cast<size_t>(EAlign256) << group);
+}
+
+/* Most blocks of size n moved between thread cache and pool at once */
+inline size_t alloc::S_transfer_blocks(size_t n) {
+    size_t nblock = ETransferBytes / n;
+    if (nblock < EMinTransferBlocks) return EMinTransferBlocks;
+    if (nblock > EMaxTransferBlocks) return EMaxTransferBlocks;
+    return nblock;
+}
+
+/*
+ * Take at most nblock blocks of size n from the shared free list,
+ * refill the free list from the memory pool if it is empty.
+ * The blocks are linked as chain, return the number of them.
+*/
+inline size_t alloc::S_fetch(node_pool& pool, size_t n, size_t nblock, Freelist*& chain) {
+    std::lock_guard<spin_lock> guard(pool.lock);
+    Freelist **my_free_list = pool.free_list + S_freelist_index(n);
+    if (*my_free_list == nullptr) {
+        chain = S_refill(pool, n, nblock);
+        return nblock;
+    }
+    Freelist *last = *my_free_list;
+    size_t count = 1;
+    for (; count < nblock && last->next != nullptr; count++) {
+        last = last->next;
+    }
+    chain = *my_free_list;
+    *my_free_list = last->next;
+    last->next = nullptr;
+    pool.free_bytes -= count * n;
+    if (pool.trim_mark > pool.free_bytes + pool.trim_threshold) {
+        pool.trim_mark = pool.free_bytes + pool.trim_threshold;
+    }
+    SABERSTL_ALLOC_STAT(pool.free_blocks[S_freelist_index(n)] -= count);
+    return count;
+}
+
+/* Put the chain [first, last] of count blocks of size n back to the shared free list */
+inline void alloc::S_release(node_pool& pool, size_t n, Freelist *first, Freelist *last,
+                             size_t count) {
+    bool trim_due = false;
+    {
+        std::lock_guard<spin_lock> guard(pool.lock);
+        Freelist **my_free_list = pool.free_list + S_freelist_index(n);
+        last->next = *my_free_list;
+        *my_free_list = first;
+        pool.free_bytes += count * n;
+        SABERSTL_ALLOC_STAT(pool.free_blocks[S_freelist_index(n)] += count);
+        if (pool.trim_threshold != 0 && pool.free_bytes > pool.trim_mark) {
+            /* Move the mark now, so the other threads do not trim too */
+            pool.trim_mark = pool.free_bytes + pool.trim_threshold;
+            trim_due = true;
         }
     }
+    /* Not under the lock taken above, a trim holds it again only to unlink */
+    if (trim_due) S_trim_node(pool);
+}
+
+/*
+ * Cut the fragment [p, p + bytes) into blocks and add them into free lists.
+ * Every block must exactly match the size of its list, so take the largest
+ * interval size not more than the rest each time.
+*/
+inline void alloc::S_push_fragment(node_pool& pool, char *p, size_t bytes) {
+    while (bytes >= static_cast<size_t>(EAlign128)) {
+        size_t block = S_round_down(bytes);
+#ifdef SABERSTL_ALLOC_LOCK_FREE
+        (void)pool;
+        Freelist *q = reinterpret_cast<Freelist*>(p);
+        free_stack()[S_freelist_index(block)].push(q, q);
+#else
+        Freelist **my_free_list = pool.free_list + S_freelist_index(block);
+        reinterpret_cast<Freelist*>(p)->next = *my_free_list;
+        *my_free_list = reinterpret_cast<Freelist*>(p);
+        pool.free_bytes += block;
+        SABERSTL_ALLOC_STAT(pool.free_blocks[S_freelist_index(block)]++);
+#endif
+        p += block;
+        bytes -= block;
+    }
+}
+
+/*
+ * Refill the free list.
+ * Take nblock blocks of size n from the memory pool and link them as a
+ * chain, nblock is modified when the pool cannot offer so much blocks.
+*/
+inline Freelist* alloc::S_refill(node_pool& pool, size_t n, size_t& nblock) {
+    char *c = S_chunk_alloc(pool, n, nblock);
+    Freelist *result, *cur;
+    result = cur = (Freelist*)c;
+    for (size_t i = 1; i < nblock; i++) {
+        cur->next = (Freelist*)((char*)cur + n);
+        cur = cur->next;
+    }
+    cur->next = nullptr;
     return result;
 }
 
+/* Link the count blocks as a chain in their order, count > 0 */
+inline void alloc::S_link(void **blocks, size_t count) {
+    for (size_t i = 1; i < count; i++) {
+        reinterpret_cast<Freelist*>(blocks[i - 1])->next = reinterpret_cast<Freelist*>(blocks[i]);
+    }
+    reinterpret_cast<Freelist*>(blocks[count - 1])->next = nullptr;
+}
+
 /*
  * Take space from memory pool to free list.
  * When the condition is interrupted, we will modify nblock
 */
-char* alloc::S_chunk_alloc(size_t size, size_t& nblock) {
+inline char* alloc::S_chunk_alloc(node_pool& pool, size_t size, size_t& nblock) {
     char *result;
     size_t need_bytes = size * nblock;
-    size_t pool_bytes = end_free - start_free;
+    size_t pool_bytes = pool.end_free - pool.start_free;
 
     /* If the remaining of memory pool is enough, return it */
     if (pool_bytes >= need_bytes) {
-        result = start_free;
-        start_free += need_bytes;
+        result = pool.start_free;
+        pool.start_free += need_bytes;
         return result;
     }
     /*
@@ -213,46 +1135,601 @@ char* alloc::S_chunk_alloc(size_t size, size_t& nblock) {
     else if (pool_bytes >= size) {
         nblock = pool_bytes / size;
         need_bytes = size * nblock;
-        result = start_free;
-        start_free += need_bytes;
+        result = pool.start_free;
+        pool.start_free += need_bytes;
         return result;
     }
     /* If the remaining of memory pool is less than one block space */
     else {
         /* If the memory pool has remaining space, add the space into free list */
         if (pool_bytes > 0) {
-            Freelist *my_free_list = free_list[S_freelist_index(pool_bytes)];
-            ((Freelist*)start_free)->next = my_free_list;
-            my_free_list = (Freelist*)start_free;
+            S_push_fragment(pool, pool.start_free, pool_bytes);
         }
 
-        /* Apply space for heap */
-        size_t bytes_to_get = (need_bytes << 1) + S_round_up(heap_size >> 4);
-        start_free = (char*)std::malloc(bytes_to_get);
+        /* Apply space for heap, the provider may round the chunk up */
+        size_t bytes_to_get = (need_bytes << 1) + S_round_up(pool.heap_size >> 4);
+        size_t chunk_bytes = sizeof(chunk_header) + bytes_to_get;
+        page_provider *provider = S_pages(pool);
+        chunk_header *chunk = (chunk_header*)provider->allocate_pages(chunk_bytes);
+        pool.start_free = pool.end_free = nullptr;
 
         /* If the space of heap is not enough */
-        if (!start_free) {
-            Freelist *my_free_list, *p;
+        if (!chunk) {
+            Freelist **my_free_list, *p;
             /* Try to find the unused space, and free list with enough size of block */
             for (size_t i = size; i <= ESmallObjectBytes; i+= S_align(i)) {
-                my_free_list = free_list[S_freelist_index(i)];
-                p = my_free_list;
+                my_free_list = pool.free_list + S_freelist_index(i);
+                p = *my_free_list;
                 if (p) {
-                    my_free_list = p->next;
-                    start_free = (char*)p;
-                    end_free = start_free + 1;
-                    return S_chunk_alloc(size, nblock);
+                    *my_free_list = p->next;
+                    pool.free_bytes -= S_round_up(i);
+                    SABERSTL_ALLOC_STAT(pool.free_blocks[S_freelist_index(i)]--);
+                    pool.start_free = (char*)p;
+                    pool.end_free = pool.start_free + S_round_up(i);
+                    return S_chunk_alloc(pool, size, nblock);
                 }
             }
             std::printf("out of memory");
-            end_free = nullptr;
+            pool.end_free = nullptr;
             throw std::bad_alloc();
         }
-        end_free = start_free + bytes_to_get;
-        heap_size += bytes_to_get;
-        return S_chunk_alloc(size, nblock);
+        chunk->next = pool.chunk_list;
+        chunk->bytes = (chunk_bytes - sizeof(chunk_header)) & ~(size_t)(EAlign128 - 1);
+        chunk->provider = provider;
+        pool.chunk_list = chunk;
+        pool.start_free = (char*)(chunk + 1);
+        pool.end_free = pool.start_free + chunk->bytes;
+        pool.heap_size += chunk->bytes;
+        SABERSTL_ALLOC_STAT(pool.chunk_grows++);
+        return S_chunk_alloc(pool, size, nblock);
+    }
+}
+
+#ifdef SABERSTL_ALLOC_LOCK_FREE
+/*
+ * Alloc a block of size n from the lock-free lists, n > 0.
+ * When the list is empty, a batch of blocks is cut from the chunk, one is
+ * returned and the others are pushed into the list at once.
+*/
+inline void* alloc::S_pop(size_t n) {
+    lock_free_list& list = free_stack()[S_freelist_index(n)];
+    Freelist *result = list.pop();
+    if (result != nullptr) return result;
+    n = S_round_up(n);
+    size_t nblock = S_transfer_blocks(n);
+    char *c = S_carve(n, nblock);
+    SABERSTL_ALLOC_STAT(S_retired_refills()[S_freelist_index(n)].fetch_add(1,
+                        std::memory_order_relaxed));
+    if (nblock > 1) {
+        Freelist *first = reinterpret_cast<Freelist*>(c + n);
+        Freelist *cur = first;
+        for (size_t i = 2; i < nblock; i++) {
+            cur->next = reinterpret_cast<Freelist*>(reinterpret_cast<char*>(cur) + n);
+            cur = cur->next;
+        }
+        list.push(first, cur, nblock - 1);
+    }
+    return c;
+}
+
+/*
+ * Alloc count blocks of size n into out, done counts the blocks got.
+ * The free blocks are popped one by one, the rest of the request is cut
+ * from the chunk at once.
+*/
+inline void alloc::S_pop_bulk(size_t n, size_t count, void **out, size_t& done) {
+    size_t index = S_freelist_index(n);
+    lock_free_list& list = free_stack()[index];
+    while (done < count) {
+        Freelist *p = list.pop();
+        if (p == nullptr) break;
+        out[done++] = p;
+        SABERSTL_ALLOC_STAT(S_retired_allocs()[index].fetch_add(1, std::memory_order_relaxed));
+    }
+    n = S_round_up(n);
+    while (done < count) {
+        size_t nblock = count - done;
+        char *c = S_carve(n, nblock);
+        SABERSTL_ALLOC_STAT(S_retired_allocs()[index].fetch_add(nblock,
+                            std::memory_order_relaxed));
+        for (size_t i = 0; i < nblock; i++) out[done++] = c + i * n;
+    }
+}
+
+/*
+ * Cut at most nblock blocks of size size from the chunk by moving its
+ * cursor with compare_exchange, nblock is modified when the chunk cannot
+ * offer so much blocks. Grow a new chunk when it cannot offer one.
+*/
+inline char* alloc::S_carve(size_t size, size_t& nblock) {
+    for (;;) {
+        chunk_header *chunk = S_carving().load(std::memory_order_acquire);
+        if (chunk != nullptr) {
+            char *end = reinterpret_cast<char*>(chunk + 1) + chunk->bytes;
+            char *cur = chunk->cursor.load(std::memory_order_relaxed);
+            while (static_cast<size_t>(end - cur) >= size) {
+                size_t count = static_cast<size_t>(end - cur) / size;
+                if (count > nblock) count = nblock;
+                if (chunk->cursor.compare_exchange_weak(cur, cur + count * size,
+                    std::memory_order_relaxed, std::memory_order_relaxed)) {
+                    nblock = count;
+                    return cur;
+                }
+            }
+        }
+        S_grow(chunk, size * nblock);
+    }
+}
+
+/*
+ * Replace the chunk old being cut by a new one, unless another thread has
+ * done it. The rest of old is added into the free lists. Chunks are only
+ * added under the lock of the pool, taking blocks never waits for it.
+*/
+inline void alloc::S_grow(chunk_header *old, size_t need_bytes) {
+    node_pool& pool = S_pools()[0];
+    std::lock_guard<spin_lock> guard(pool.lock);
+    if (S_carving().load(std::memory_order_relaxed) != old) return;
+    if (old != nullptr) {
+        char *end = reinterpret_cast<char*>(old + 1) + old->bytes;
+        char *rest = old->cursor.exchange(end, std::memory_order_relaxed);
+        S_push_fragment(pool, rest, static_cast<size_t>(end - rest));
+    }
+
+    size_t bytes_to_get = (need_bytes << 1) + S_round_up(pool.heap_size >> 4);
+    size_t chunk_bytes = sizeof(chunk_header) + bytes_to_get;
+    page_provider *provider = S_pages(pool);
+    chunk_header *chunk = (chunk_header*)provider->allocate_pages(chunk_bytes);
+    if (!chunk) throw std::bad_alloc();
+    chunk->next = pool.chunk_list;
+    chunk->bytes = (chunk_bytes - sizeof(chunk_header)) & ~(size_t)(EAlign128 - 1);
+    chunk->provider = provider;
+    new (&chunk->cursor) std::atomic<char*>(reinterpret_cast<char*>(chunk + 1));
+    pool.chunk_list = chunk;
+    pool.heap_size += chunk->bytes;
+    SABERSTL_ALLOC_STAT(pool.chunk_grows++);
+    S_carving().store(chunk, std::memory_order_release);
+}
+#endif
+
+/* The usage of a chunk found by S_trim */
+struct chunk_usage {
+    chunk_header *chunk;    // the chunk
+    size_t free_bytes;      // bytes of the chunk not in use
+};
+
+/* Order chunk_usage by the address of chunk */
+inline int chunk_usage_compare(const void *lhs, const void *rhs) {
+    const char *l = (const char*)((const chunk_usage*)lhs)->chunk;
+    const char *r = (const char*)((const chunk_usage*)rhs)->chunk;
+    return l < r ? -1 : (r < l ? 1 : 0);
+}
+
+/* Find the chunk containing p in the sorted usage, return nullptr if not found */
+inline chunk_usage* chunk_usage_find(chunk_usage *usage, size_t n, const char *p) {
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if ((const char*)(usage[mid].chunk + 1) <= p) lo = mid + 1;
+        else hi = mid;
+    }
+    if (lo == 0) return nullptr;
+    chunk_usage *u = usage + lo - 1;
+    const char *begin = (const char*)(u->chunk + 1);
+    return p < begin + u->chunk->bytes ? u : nullptr;
+}
+
+/* Check whether all the bytes of the chunk are free */
+inline bool chunk_usage_idle(const chunk_usage *u) {
+    return u != nullptr && u->free_bytes == u->chunk->bytes;
+}
+
+/*
+ * Unlink the chunks of pool with no block in use, its lock must be held.
+ * Sum the bytes of free blocks and the rest of memory pool in every chunk,
+ * the chunks with all bytes free are removed from the free lists and the
+ * chunk list, and returned chained by next for the caller to give back.
+*/
+inline chunk_header* alloc::S_trim(node_pool& pool) {
+    size_t nchunk = 0;
+    for (chunk_header *c = pool.chunk_list; c != nullptr; c = c->next) nchunk++;
+    if (nchunk == 0) return nullptr;
+    chunk_usage *usage = (chunk_usage*)std::malloc(nchunk * sizeof(chunk_usage));
+    if (usage == nullptr) return nullptr;
+    size_t k = 0;
+    for (chunk_header *c = pool.chunk_list; c != nullptr; c = c->next, k++) {
+        usage[k].chunk = c;
+        usage[k].free_bytes = 0;
+    }
+    std::qsort(usage, nchunk, sizeof(chunk_usage), chunk_usage_compare);
+
+    /* Sum the free bytes of every chunk */
+    for (size_t i = 0; i < EFreeListsNumber; i++) {
+        for (Freelist *p = pool.free_list[i]; p != nullptr; p = p->next) {
+            chunk_usage *u = chunk_usage_find(usage, nchunk, (char*)p);
+            if (u != nullptr) u->free_bytes += S_block_size(i);
+        }
+    }
+    if (pool.start_free != pool.end_free) {
+        chunk_usage *u = chunk_usage_find(usage, nchunk, pool.start_free);
+        if (u != nullptr) u->free_bytes += pool.end_free - pool.start_free;
+    }
+
+    /* Remove the blocks of idle chunks from the free lists */
+    for (size_t i = 0; i < EFreeListsNumber; i++) {
+        Freelist **pp = pool.free_list + i;
+        while (*pp != nullptr) {
+            if (chunk_usage_idle(chunk_usage_find(usage, nchunk, (char*)*pp))) {
+                *pp = (*pp)->next;
+                pool.free_bytes -= S_block_size(i);
+                SABERSTL_ALLOC_STAT(pool.free_blocks[i]--);
+            } else {
+                pp = &(*pp)->next;
+            }
+        }
+    }
+    if (pool.start_free != pool.end_free &&
+        chunk_usage_idle(chunk_usage_find(usage, nchunk, pool.start_free))) {
+        pool.start_free = pool.end_free = nullptr;
+    }
+
+    /* Take the idle chunks out of the pool */
+    chunk_header *idle = nullptr;
+    for (chunk_header **pc = &pool.chunk_list; *pc != nullptr; ) {
+        chunk_header *c = *pc;
+        if (chunk_usage_idle(chunk_usage_find(usage, nchunk, (char*)(c + 1)))) {
+            *pc = c->next;
+            c->next = idle;
+            idle = c;
+            pool.heap_size -= c->bytes;
+            SABERSTL_ALLOC_STAT(pool.chunk_releases++);
+        } else {
+            pc = &c->next;
+        }
+    }
+    std::free(usage);
+    return idle;
+}
+
+/*
+ * Trim a node and restart its automatic trim. The pages are given back
+ * after the lock is left, the system calls do not hold up the threads
+ * waiting for the pool.
+*/
+inline size_t alloc::S_trim_node(node_pool& pool) {
+    chunk_header *idle;
+    {
+        std::lock_guard<spin_lock> guard(pool.lock);
+        idle = S_trim(pool);
+        if (pool.trim_threshold != 0) pool.trim_mark = pool.free_bytes + pool.trim_threshold;
+    }
+    size_t released = 0;
+    while (idle != nullptr) {
+        chunk_header *c = idle;
+        idle = c->next;
+        released += c->bytes;
+        c->provider->release_pages(c, sizeof(chunk_header) + c->bytes);
+    }
+    return released;
+}
+
+/* ======================= thread_cache ======================= */
+
+/* Give all the cached blocks back when the thread exits */
+inline thread_cache::~thread_cache() {
+    flush();
+#ifdef SABERSTL_ALLOC_STATS
+    {
+        /* Keep the counters of this thread in the retired totals */
+        std::lock_guard<spin_lock> guard(alloc::S_lock());
+        for (size_t i = 0; i < EFreeListsNumber; i++) {
+            alloc::S_retired_allocs()[i].fetch_add(counters_[i].allocs.load(
+                std::memory_order_relaxed), std::memory_order_relaxed);
+            alloc::S_retired_deallocs()[i].fetch_add(counters_[i].deallocs.load(
+                std::memory_order_relaxed), std::memory_order_relaxed);
+            alloc::S_retired_refills()[i].fetch_add(counters_[i].refills.load(
+                std::memory_order_relaxed), std::memory_order_relaxed);
+            alloc::S_retired_overflows()[i].fetch_add(counters_[i].overflows.load(
+                std::memory_order_relaxed), std::memory_order_relaxed);
+        }
+        if (prev_ != nullptr) prev_->next_ = next_;
+        else alloc::S_caches() = next_;
+        if (next_ != nullptr) next_->prev_ = prev_;
+    }
+#endif
+    S_local() = nullptr;
+    S_exited() = true;
+}
+
+/* Alloc a block of size n from the magazine, n > 0 */
+inline void* thread_cache::allocate(size_t n) {
+    size_t index = alloc::S_freelist_index(n);
+    magazine& mag = mags_[index];
+    if (mag.head == nullptr) {
+        n = alloc::S_round_up(n);
+        mag.count = alloc::S_fetch(*pool_, n, mag.batch, mag.head);
+        SABERSTL_ALLOC_STAT(S_add(counters_[index].refills, 1));
+        adapt(index, n);
+    }
+    Freelist *result = mag.head;
+    mag.head = result->next;
+    mag.count--;
+    SABERSTL_ALLOC_STAT(S_add(counters_[index].allocs, 1));
+    SABERSTL_ALLOC_STAT(counters_[index].cached.store(mag.count,
+                        std::memory_order_relaxed));
+    return result;
+}
+
+/* Put the block p of size n into the magazine */
+inline void thread_cache::deallocate(void *p, size_t n) {
+    size_t index = alloc::S_freelist_index(n);
+    magazine& mag = mags_[index];
+    Freelist *q = reinterpret_cast<Freelist*>(p);
+    q->next = mag.head;
+    mag.head = q;
+    mag.count++;
+    if (mag.count > (mag.batch << 1)) {
+        n = alloc::S_round_up(n);
+        shrink(index, n, mag.batch);
+        SABERSTL_ALLOC_STAT(S_add(counters_[index].overflows, 1));
+        adapt(index, n);
+    }
+    SABERSTL_ALLOC_STAT(S_add(counters_[index].deallocs, 1));
+    SABERSTL_ALLOC_STAT(counters_[index].cached.store(mag.count,
+                        std::memory_order_relaxed));
+}
+
+/*
+ * Alloc count blocks of size n into out, done counts the blocks got.
+ * An empty magazine is refilled with as many blocks as the rest of the
+ * request needs, at least one batch.
+*/
+inline void thread_cache::allocate_bulk(size_t n, size_t count, void **out, size_t& done) {
+    size_t index = alloc::S_freelist_index(n);
+    magazine& mag = mags_[index];
+    n = alloc::S_round_up(n);
+    while (done < count) {
+        if (mag.head == nullptr) {
+            size_t nblock = mag.batch;
+            if (nblock < count - done) nblock = count - done;
+            mag.count = alloc::S_fetch(*pool_, n, nblock, mag.head);
+            SABERSTL_ALLOC_STAT(S_add(counters_[index].refills, 1));
+            adapt(index, n);
+        }
+        size_t first = done;
+        for (; done < count && mag.head != nullptr; done++) {
+            out[done] = mag.head;
+            mag.head = mag.head->next;
+        }
+        mag.count -= done - first;
+        SABERSTL_ALLOC_STAT(S_add(counters_[index].allocs, done - first));
+    }
+    SABERSTL_ALLOC_STAT(counters_[index].cached.store(mag.count,
+                        std::memory_order_relaxed));
+}
+
+/*
+ * Put count blocks of size n into the magazine. The part over two batches
+ * is given back to the shared pool at once, leaving one batch cached.
+*/
+inline void thread_cache::deallocate_bulk(size_t n, size_t count, void **blocks) {
+    size_t index = alloc::S_freelist_index(n);
+    magazine& mag = mags_[index];
+    n = alloc::S_round_up(n);
+    size_t give = 0;
+    if (mag.count + count > (mag.batch << 1)) {
+        give = mag.count + count - mag.batch;
+        if (give > count) give = count;
+    }
+    alloc::S_link(blocks, count);
+    if (give < count) {
+        reinterpret_cast<Freelist*>(blocks[count - 1])->next = mag.head;
+        mag.head = reinterpret_cast<Freelist*>(blocks[give]);
+        mag.count += count - give;
+    }
+    if (give > 0) {
+        alloc::S_release(*pool_, n, reinterpret_cast<Freelist*>(blocks[0]),
+                         reinterpret_cast<Freelist*>(blocks[give - 1]), give);
+        SABERSTL_ALLOC_STAT(S_add(counters_[index].overflows, 1));
+        adapt(index, n);
+    }
+    SABERSTL_ALLOC_STAT(S_add(counters_[index].deallocs, count));
+    SABERSTL_ALLOC_STAT(counters_[index].cached.store(mag.count,
+                        std::memory_order_relaxed));
+}
+
+/* Return all the cached blocks to the shared pool, the batches start over */
+inline void thread_cache::flush() {
+    for (size_t i = 0; i < EFreeListsNumber; i++) {
+        magazine& mag = mags_[i];
+        mag.batch = EMinTransferBlocks;
+        mag.events = 0;
+        SABERSTL_ALLOC_STAT(counters_[i].batch.store(mag.batch, std::memory_order_relaxed));
+        if (mag.head == nullptr) continue;
+        Freelist *last = mag.head;
+        while (last->next != nullptr) last = last->next;
+        /* Every block in the magazine i has the same size */
+        alloc::S_release(*pool_, alloc::S_block_size(i), mag.head, last, mag.count);
+        mag.head = nullptr;
+        mag.count = 0;
+        SABERSTL_ALLOC_STAT(counters_[i].cached.store(0, std::memory_order_relaxed));
+    }
+}
+
+/*
+ * Class index (block size n) has taken a slow path, double its batch up
+ * to the cap, and decay the batches of the cold classes from time to time.
+*/
+inline void thread_cache::adapt(size_t index, size_t n) {
+    magazine& mag = mags_[index];
+    size_t cap = alloc::S_transfer_blocks(n);
+    mag.batch = (mag.batch << 1) < cap ? (mag.batch << 1) : cap;
+    mag.events++;
+    SABERSTL_ALLOC_STAT(counters_[index].batch.store(mag.batch, std::memory_order_relaxed));
+    if (++events_ >= EBatchDecayEvents) decay();
+}
+
+/*
+ * Halve the batches of the classes with no slow path since the last
+ * decay, and give their cached blocks over one batch back.
+*/
+inline void thread_cache::decay() {
+    for (size_t i = 0; i < EFreeListsNumber; i++) {
+        magazine& mag = mags_[i];
+        if (mag.events == 0 && mag.batch > EMinTransferBlocks) {
+            mag.batch = (mag.batch >> 1) > EMinTransferBlocks
+                ? (mag.batch >> 1) : static_cast<size_t>(EMinTransferBlocks);
+            if (mag.count > mag.batch) {
+                shrink(i, alloc::S_block_size(i), mag.count - mag.batch);
+            }
+            SABERSTL_ALLOC_STAT(counters_[i].batch.store(mag.batch,
+                                std::memory_order_relaxed));
+            SABERSTL_ALLOC_STAT(counters_[i].cached.store(mag.count,
+                                std::memory_order_relaxed));
+        }
+        mag.events = 0;
+    }
+    events_ = 0;
+}
+
+/* Give nblock blocks of magazine index (block size n) back to the shared pool */
+inline void thread_cache::shrink(size_t index, size_t n, size_t nblock) {
+    magazine& mag = mags_[index];
+    Freelist *first = mag.head;
+    Freelist *last = first;
+    for (size_t i = 1; i < nblock; i++) last = last->next;
+    mag.head = last->next;
+    mag.count -= nblock;
+    alloc::S_release(*pool_, n, first, last, nblock);
+}
+
+/* Create the cache of current thread at the first use */
+inline thread_cache* thread_cache::S_create() {
+    if (S_exited()) return nullptr;
+    static thread_local thread_cache cache;
+    S_local() = &cache;
+#ifdef SABERSTL_ALLOC_STATS
+    std::lock_guard<spin_lock> guard(alloc::S_lock());
+    cache.prev_ = nullptr;
+    cache.next_ = alloc::S_caches();
+    if (alloc::S_caches() != nullptr) alloc::S_caches()->prev_ = &cache;
+    alloc::S_caches() = &cache;
+#endif
+    return S_local();
+}
+
+/* ======================= statistics ======================= */
+
+#ifdef SABERSTL_ALLOC_STATS
+/*
+ * Take a snapshot of the counters, it can be called from any thread.
+ * The counters of other threads are read without stopping them, so the
+ * numbers of a busy pool are close to but not exactly consistent.
+*/
+inline alloc_stats alloc::statistics() {
+    alloc_stats s = {};
+    std::lock_guard<spin_lock> guard(S_lock());
+    for (size_t i = 0; i < EFreeListsNumber; i++) {
+        alloc_class_stats& c = s.classes[i];
+        c.block_size = S_block_size(i);
+        c.allocs = S_retired_allocs()[i].load(std::memory_order_relaxed);
+        c.deallocs = S_retired_deallocs()[i].load(std::memory_order_relaxed);
+        c.refills = S_retired_refills()[i].load(std::memory_order_relaxed);
+        c.overflows = S_retired_overflows()[i].load(std::memory_order_relaxed);
+#ifdef SABERSTL_ALLOC_LOCK_FREE
+        c.pool_cached = free_stack()[i].size();
+#endif
+    }
+    for (thread_cache *t = S_caches(); t != nullptr; t = t->next_) {
+        for (size_t i = 0; i < EFreeListsNumber; i++) {
+            alloc_class_stats& c = s.classes[i];
+            c.allocs += t->counters_[i].allocs.load(std::memory_order_relaxed);
+            c.deallocs += t->counters_[i].deallocs.load(std::memory_order_relaxed);
+            c.thread_cached += t->counters_[i].cached.load(std::memory_order_relaxed);
+            c.refills += t->counters_[i].refills.load(std::memory_order_relaxed);
+            c.overflows += t->counters_[i].overflows.load(std::memory_order_relaxed);
+            size_t batch = t->counters_[i].batch.load(std::memory_order_relaxed);
+            if (batch > c.batch) c.batch = batch;
+        }
+        s.threads++;
+    }
+    for (size_t n = 0; n < numa_node_count(); n++) {
+        node_pool& pool = S_pools()[n];
+        std::lock_guard<spin_lock> pool_guard(pool.lock);
+        s.heap_bytes += pool.heap_size;
+#ifndef SABERSTL_ALLOC_LOCK_FREE
+        s.pool_bytes += pool.end_free - pool.start_free;
+        for (size_t i = 0; i < EFreeListsNumber; i++) {
+            s.classes[i].pool_cached += pool.free_blocks[i];
+        }
+#endif
+        s.chunk_grows += pool.chunk_grows;
+        s.chunk_releases += pool.chunk_releases;
+    }
+    for (size_t i = 0; i < EFreeListsNumber; i++) {
+        alloc_class_stats& c = s.classes[i];
+        c.in_use = c.allocs > c.deallocs ? c.allocs - c.deallocs : 0;
+        s.bytes_in_use += c.in_use * c.block_size;
+        s.bytes_cached += (c.thread_cached + c.pool_cached) * c.block_size;
+    }
+#ifdef SABERSTL_ALLOC_LOCK_FREE
+    chunk_header *chunk = S_carving().load(std::memory_order_acquire);
+    if (chunk != nullptr) {
+        s.pool_bytes = reinterpret_cast<char*>(chunk + 1) + chunk->bytes -
+                       chunk->cursor.load(std::memory_order_relaxed);
+    }
+#endif
+    s.large_allocs = S_large_allocs().load(std::memory_order_relaxed);
+    s.large_deallocs = S_large_deallocs().load(std::memory_order_relaxed);
+    s.large_bytes_in_use = S_large_bytes().load(std::memory_order_relaxed);
+    return s;
+}
+
+/* Print the snapshot as a human readable table */
+inline void alloc_stats::print(std::FILE *out) const {
+    std::fprintf(out, "saberstl alloc statistics\n");
+    std::fprintf(out, "  heap bytes:         %zu\n", heap_bytes);
+    std::fprintf(out, "  pool bytes:         %zu\n", pool_bytes);
+    std::fprintf(out, "  bytes in use:       %zu\n", bytes_in_use);
+    std::fprintf(out, "  bytes cached:       %zu\n", bytes_cached);
+    std::fprintf(out, "  chunk grows:        %zu\n", chunk_grows);
+    std::fprintf(out, "  chunk releases:     %zu\n", chunk_releases);
+    std::fprintf(out, "  large allocs:       %zu\n", large_allocs);
+    std::fprintf(out, "  large deallocs:     %zu\n", large_deallocs);
+    std::fprintf(out, "  large bytes in use: %zu\n", large_bytes_in_use);
+    std::fprintf(out, "  threads:            %zu\n", threads);
+    std::fprintf(out, "  %5s %12s %12s %10s %14s %12s %10s %10s %6s\n", "size",
+                 "allocs", "deallocs", "in_use", "thread_cached", "pool_cached",
+                 "refills", "overflows", "batch");
+    for (size_t i = 0; i < EFreeListsNumber; i++) {
+        const alloc_class_stats& c = classes[i];
+        if (c.allocs == 0 && c.pool_cached == 0) continue;
+        std::fprintf(out, "  %5zu %12zu %12zu %10zu %14zu %12zu %10zu %10zu %6zu\n",
+                     c.block_size, c.allocs, c.deallocs, c.in_use, c.thread_cached,
+                     c.pool_cached, c.refills, c.overflows, c.batch);
+    }
+}
+
+/* Print the snapshot as a JSON object */
+inline void alloc_stats::print_json(std::FILE *out) const {
+    std::fprintf(out, "{\"heap_bytes\":%zu,\"pool_bytes\":%zu,"
+                 "\"bytes_in_use\":%zu,\"bytes_cached\":%zu,\"chunk_grows\":%zu,"
+                 "\"chunk_releases\":%zu,\"large_allocs\":%zu,\"large_deallocs\":%zu,"
+                 "\"large_bytes_in_use\":%zu,\"threads\":%zu,\"classes\":[",
+                 heap_bytes, pool_bytes, bytes_in_use, bytes_cached, chunk_grows,
+                 chunk_releases, large_allocs, large_deallocs, large_bytes_in_use, threads);
+    for (size_t i = 0; i < EFreeListsNumber; i++) {
+        const alloc_class_stats& c = classes[i];
+        std::fprintf(out, "%s{\"size\":%zu,\"allocs\":%zu,\"deallocs\":%zu,"
+                     "\"in_use\":%zu,\"thread_cached\":%zu,\"pool_cached\":%zu,"
+                     "\"refills\":%zu,\"overflows\":%zu,\"batch\":%zu}",
+                     i == 0 ? "" : ",", c.block_size, c.allocs, c.deallocs,
+                     c.in_use, c.thread_cached, c.pool_cached, c.refills,
+                     c.overflows, c.batch);
     }
+    std::fprintf(out, "]}\n");
 }
+#endif
 
 } // saberstl
 
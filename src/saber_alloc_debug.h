@@ -0,0 +1,255 @@
+#ifndef SABERSTL_ALLOC_DEBUG_H
+#define SABERSTL_ALLOC_DEBUG_H
+
+/*
+ * This header file contains the class alloc_debug, which guards the blocks
+ * of alloc with red zones and canaries, poisons the freed blocks and keeps
+ * them in a quarantine for a while, to catch overflows, double frees and
+ * writes after free near the place they happen.
+ *
+ * Define SABERSTL_ALLOC_DEBUG before including saber_alloc.h to turn it
+ * on, it is compiled out by default.
+*/
+
+#ifdef SABERSTL_ALLOC_DEBUG
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <thread>
+
+namespace saberstl {
+
+/* Bytes of the red zone on each side of a block */
+enum { EDebugRedZoneBytes = 16 };
+
+/* Default bytes of the freed blocks held in the quarantine */
+enum { EDebugQuarantineBytes = 1024 * 1024 };
+
+/* Most blocks held in the quarantine */
+enum { EDebugQuarantineBlocks = 4096 };
+
+/* Patterns of the new blocks, the red zones and the freed blocks */
+enum : unsigned char {
+    EDebugNewByte = 0xCD,
+    EDebugRedZoneByte = 0xFD,
+    EDebugFreedByte = 0xDD
+};
+
+/*
+ * class alloc_debug
+ * A guarded block is laid out as
+ *   | header | red zone | n bytes for the user | red zone |
+ * The header keeps n and a canary made from the address of the block and
+ * its state, so a free checks the size, the state and both red zones. The
+ * freed block is filled with EDebugFreedByte and waits in a FIFO until the
+ * quarantine is over its limit; the pattern is checked again when it
+ * leaves, then the block goes back to the pool. Any violation prints the
+ * block and aborts.
+*/
+class alloc_debug {
+private:
+    struct header {
+        size_t size;        // bytes asked by the user
+        uintptr_t canary;   // address of the block mixed with its state
+    };
+
+    struct entry {
+        char *block;        // the block for the user
+        size_t size;        // bytes asked by the user
+    };
+
+    enum : uintptr_t {
+        ELiveMagic = 0x5AB3A11C,
+        EFreedMagic = 0x0DEADF4E
+    };
+
+    /* Bytes before the block for the user, a multiple of the alignment */
+    enum { EFrontBytes = (sizeof(header) + EDebugRedZoneBytes + 15) & ~15 };
+
+    /* The quarantine lives in function-local statics, shared by every translation unit */
+    static std::atomic_flag& S_lock() noexcept;
+    static entry *S_ring() noexcept;
+    static size_t& S_head() noexcept;       // the oldest entry
+    static size_t& S_count() noexcept;      // entries in the quarantine
+    static size_t& S_bytes() noexcept;      // bytes held in the quarantine
+    static size_t& S_limit() noexcept;      // most bytes held in the quarantine
+
+public:
+    /* Bytes to take from the pool for a block of n bytes */
+    static size_t raw_size(size_t n) noexcept {
+        return n + EFrontBytes + EDebugRedZoneBytes;
+    }
+
+    static void *on_allocate(void *raw, size_t n) noexcept;
+    static void on_deallocate(void *p, size_t n) noexcept;
+    static bool evict(void*& raw, size_t& raw_n) noexcept;
+    static void check(const void *p, size_t n) noexcept;
+
+    /* Hold at most bytes of freed blocks, 0 gives them back at once */
+    static void set_quarantine_bytes(size_t bytes) noexcept {
+        S_acquire();
+        S_limit() = bytes;
+        S_release();
+    }
+
+private:
+    static header *S_header(const void *p) noexcept {
+        return reinterpret_cast<header*>(const_cast<char*>(
+            static_cast<const char*>(p) - EFrontBytes));
+    }
+
+    static uintptr_t S_canary(const void *p, uintptr_t magic) noexcept {
+        return reinterpret_cast<uintptr_t>(p) ^ magic;
+    }
+
+    /* The first byte in [p, p + n) not equal to c, nullptr for none */
+    static const unsigned char *S_differ(const void *p, size_t n, unsigned char c) noexcept {
+        const unsigned char *q = static_cast<const unsigned char*>(p);
+        for (size_t i = 0; i < n; i++) {
+            if (q[i] != c) return q + i;
+        }
+        return nullptr;
+    }
+
+    static void S_acquire() noexcept {
+        while (S_lock().test_and_set(std::memory_order_acquire)) std::this_thread::yield();
+    }
+
+    static void S_release() noexcept {
+        S_lock().clear(std::memory_order_release);
+    }
+
+    static void S_fail(const char *what, const void *p, size_t n, const void *at) noexcept;
+};
+
+/* Initial static variables */
+
+inline std::atomic_flag& alloc_debug::S_lock() noexcept {
+    static std::atomic_flag lock = ATOMIC_FLAG_INIT;
+    return lock;
+}
+
+inline alloc_debug::entry* alloc_debug::S_ring() noexcept {
+    static entry ring[EDebugQuarantineBlocks] = {};
+    return ring;
+}
+
+inline size_t& alloc_debug::S_head() noexcept {
+    static size_t head = 0;
+    return head;
+}
+
+inline size_t& alloc_debug::S_count() noexcept {
+    static size_t count = 0;
+    return count;
+}
+
+inline size_t& alloc_debug::S_bytes() noexcept {
+    static size_t bytes = 0;
+    return bytes;
+}
+
+inline size_t& alloc_debug::S_limit() noexcept {
+    static size_t limit = EDebugQuarantineBytes;
+    return limit;
+}
+
+/* Guard raw of raw_size(n) bytes, return the block for the user */
+inline void* alloc_debug::on_allocate(void *raw, size_t n) noexcept {
+    if (raw == nullptr) return nullptr;
+    char *p = static_cast<char*>(raw) + EFrontBytes;
+    header *h = S_header(p);
+    h->size = n;
+    h->canary = S_canary(p, ELiveMagic);
+    char *zone = reinterpret_cast<char*>(h + 1);
+    std::memset(zone, EDebugRedZoneByte, p - zone);
+    std::memset(p, EDebugNewByte, n);
+    std::memset(p + n, EDebugRedZoneByte, EDebugRedZoneBytes);
+    return p;
+}
+
+/* Check p of n bytes in use, abort if it is broken */
+inline void alloc_debug::check(const void *p, size_t n) noexcept {
+    const header *h = S_header(p);
+    if (h->canary == S_canary(p, EFreedMagic)) S_fail("double free", p, n, h);
+    if (h->canary != S_canary(p, ELiveMagic)) {
+        S_fail("bad pointer or header overwritten", p, n, h);
+    }
+    if (h->size != n) S_fail("size differs from the allocation", p, h->size, h);
+    const char *zone = reinterpret_cast<const char*>(h + 1);
+    const unsigned char *bad = S_differ(zone, static_cast<const char*>(p) - zone,
+                                        EDebugRedZoneByte);
+    if (bad != nullptr) S_fail("buffer underflow", p, n, bad);
+    bad = S_differ(static_cast<const char*>(p) + n, EDebugRedZoneBytes, EDebugRedZoneByte);
+    if (bad != nullptr) S_fail("buffer overflow", p, n, bad);
+}
+
+/* Check p of n bytes, poison it and put it into the quarantine */
+inline void alloc_debug::on_deallocate(void *p, size_t n) noexcept {
+    check(p, n);
+    header *h = S_header(p);
+    h->canary = S_canary(p, EFreedMagic);
+    std::memset(p, EDebugFreedByte, n);
+    S_acquire();
+    while (S_count() == static_cast<size_t>(EDebugQuarantineBlocks)) {
+        /* The thread that filled it is evicting */
+        S_release();
+        std::this_thread::yield();
+        S_acquire();
+    }
+    entry& e = S_ring()[(S_head() + S_count()) % EDebugQuarantineBlocks];
+    e.block = static_cast<char*>(p);
+    e.size = n;
+    S_count()++;
+    S_bytes() += n;
+    S_release();
+}
+
+/*
+ * Take the oldest block out of the quarantine if it holds too much, return
+ * false if not. The block is checked for writes after free, raw and raw_n
+ * are what to give back to the pool.
+*/
+inline bool alloc_debug::evict(void*& raw, size_t& raw_n) noexcept {
+    S_acquire();
+    if (S_count() == 0 || (S_bytes() <= S_limit() &&
+        S_count() < static_cast<size_t>(EDebugQuarantineBlocks))) {
+        S_release();
+        return false;
+    }
+    entry e = S_ring()[S_head()];
+    S_head() = (S_head() + 1) % EDebugQuarantineBlocks;
+    S_count()--;
+    S_bytes() -= e.size;
+    S_release();
+    const unsigned char *bad = S_differ(e.block, e.size, EDebugFreedByte);
+    if (bad != nullptr) S_fail("write after free", e.block, e.size, bad);
+    if (S_header(e.block)->canary != S_canary(e.block, EFreedMagic)) {
+        S_fail("header of a freed block overwritten", e.block, e.size, S_header(e.block));
+    }
+    raw = e.block - EFrontBytes;
+    raw_n = raw_size(e.size);
+    return true;
+}
+
+/* Report a broken block and abort */
+inline void alloc_debug::S_fail(const char *what, const void *p, size_t n,
+                                const void *at) noexcept {
+    std::fprintf(stderr, "saberstl alloc: %s, block %p of %zu bytes", what, p, n);
+    if (at != nullptr) {
+        std::fprintf(stderr, ", at offset %td",
+                     static_cast<const char*>(at) - static_cast<const char*>(p));
+    }
+    std::fprintf(stderr, "\n");
+    std::abort();
+}
+
+} // namespace saberstl
+
+#endif // SABERSTL_ALLOC_DEBUG
+
+#endif // !SABERSTL_ALLOC_DEBUG_H
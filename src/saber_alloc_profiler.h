@@ -0,0 +1,436 @@
+#ifndef SABERSTL_ALLOC_PROFILER_H
+#define SABERSTL_ALLOC_PROFILER_H
+
+/*
+ * This header file contains the class alloc_profiler, which samples the
+ * allocations of alloc and allocator by the call stack they come from,
+ * and reports the live memory and the churn of every call site.
+ *
+ * Define SABERSTL_ALLOC_PROFILE before including saber_alloc.h or
+ * saber_allocator.h to turn it on, the hooks are compiled out by default.
+*/
+
+#ifdef SABERSTL_ALLOC_PROFILE
+#define SABERSTL_ALLOC_PROFILE_HOOK(expr) expr
+#else
+#define SABERSTL_ALLOC_PROFILE_HOOK(expr)
+#endif
+
+#ifdef SABERSTL_ALLOC_PROFILE
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <atomic>
+#include <thread>
+
+#if defined(__GLIBC__) || defined(__APPLE__)
+#include <execinfo.h>
+#define SABERSTL_HAS_BACKTRACE
+#endif
+
+namespace saberstl {
+
+/* Bytes allocated between two samples on average */
+enum { EProfileSampleBytes = 512 * 1024 };
+
+/* Frames kept for a call site */
+enum { EProfileMaxFrames = 24 };
+
+/* Number of call sites, the sites over it are counted together */
+enum { EProfileSites = 4096 };
+
+/* Number of counters that filter the frees of the sampled blocks */
+enum { EProfileFilterSlots = 4096 };
+
+/* The statistics of a call site, the numbers are estimated from the samples */
+struct alloc_site {
+    void *frames[EProfileMaxFrames];    // the call stack
+    size_t depth;                       // number of frames
+    uint64_t hash;                      // hash of the frames
+    size_t allocs;                      // objects allocated
+    size_t alloc_bytes;                 // bytes allocated
+    size_t frees;                       // objects freed
+    size_t free_bytes;                  // bytes freed
+};
+
+/*
+ * class alloc_profiler
+ * Every thread counts down the bytes it allocates, and samples the block
+ * that reaches zero. The distance to the next sample is random with the
+ * mean sample_rate(), so a sample stands for about sample_rate() bytes
+ * and the cost is paid only once in so many bytes.
+ * The sampled blocks are kept in a table until they are freed; a free
+ * looks the table up only when a counter of the filter says the block may
+ * be there. All the tables live outside the memory pool.
+*/
+class alloc_profiler {
+private:
+    struct sample {
+        void *ptr;          // the sampled block, nullptr for empty slot
+        size_t site;        // index of the call site
+        size_t bytes;       // bytes it stands for
+        size_t count;       // objects it stands for
+    };
+
+    /* The state lives in function-local statics, shared by every translation unit */
+    static std::atomic<size_t>& S_rate() noexcept;
+    static std::atomic_flag& S_lock() noexcept;
+    static std::atomic<uint32_t> *S_filter() noexcept;
+    static alloc_site *S_sites() noexcept;
+    static size_t& S_nsite() noexcept;
+    static sample*& S_samples() noexcept;
+    static size_t& S_sample_capacity() noexcept;
+    static size_t& S_nsample() noexcept;
+    static std::FILE*& S_exit_out() noexcept;
+
+    static ptrdiff_t& S_bytes_left() noexcept;
+    static uint64_t& S_seed() noexcept;
+
+public:
+    /* Called by the allocators, cheap unless the block is sampled */
+    static void on_allocate(void *p, size_t n) noexcept {
+        if (p == nullptr) return;
+        S_bytes_left() -= static_cast<ptrdiff_t>(n);
+        if (S_bytes_left() < 0) S_sample(p, n);
+    }
+
+    static void on_deallocate(void *p) noexcept {
+        on_deallocate_at(reinterpret_cast<uintptr_t>(p));
+    }
+
+    /* The same by the address, for a block realloc may have freed already */
+    static void on_deallocate_at(uintptr_t addr) noexcept {
+        if (S_filter()[S_slot(addr)].load(std::memory_order_relaxed) != 0) S_forget(addr);
+    }
+
+    /*
+     * Sample every bytes on average, 0 turns the sampling off. A thread
+     * takes the new rate at its next sample.
+    */
+    static void set_sample_rate(size_t bytes) noexcept {
+        S_rate().store(bytes, std::memory_order_relaxed);
+    }
+
+    static size_t sample_rate() noexcept {
+        return S_rate().load(std::memory_order_relaxed);
+    }
+
+    static void report(std::FILE *out, size_t top = 10);
+    static void report_at_exit(std::FILE *out = stderr);
+
+private:
+    static uint64_t S_mix(uintptr_t addr) noexcept {
+        return static_cast<uint64_t>(addr) * 0x9E3779B97F4A7C15ull;
+    }
+
+    /* The counter of the filter for the block at addr */
+    static size_t S_slot(uintptr_t addr) noexcept {
+        return static_cast<size_t>(S_mix(addr) >> 52) & (EProfileFilterSlots - 1);
+    }
+
+    /* The first slot of p in the sample table */
+    static size_t S_home(const void *p) noexcept {
+        return static_cast<size_t>(S_mix(reinterpret_cast<uintptr_t>(p)) >> 24) &
+               (S_sample_capacity() - 1);
+    }
+
+    static void S_acquire() noexcept {
+        while (S_lock().test_and_set(std::memory_order_acquire)) std::this_thread::yield();
+    }
+
+    static void S_release() noexcept {
+        S_lock().clear(std::memory_order_release);
+    }
+
+    static ptrdiff_t S_next_interval(size_t rate) noexcept;
+    static void S_sample(void *p, size_t n) noexcept;
+    static void S_forget(uintptr_t addr) noexcept;
+    static size_t S_find_site(void **frames, size_t depth) noexcept;
+    static bool S_insert(const sample& s) noexcept;
+    static bool S_grow() noexcept;
+    static void S_print_site(std::FILE *out, const alloc_site& s);
+    static void S_exit_report();
+};
+
+/* Initial static variables */
+
+inline std::atomic<size_t>& alloc_profiler::S_rate() noexcept {
+    static std::atomic<size_t> rate(EProfileSampleBytes);
+    return rate;
+}
+
+inline std::atomic_flag& alloc_profiler::S_lock() noexcept {
+    static std::atomic_flag lock = ATOMIC_FLAG_INIT;
+    return lock;
+}
+
+inline std::atomic<uint32_t>* alloc_profiler::S_filter() noexcept {
+    static std::atomic<uint32_t> filter[EProfileFilterSlots] = {};
+    return filter;
+}
+
+inline alloc_site* alloc_profiler::S_sites() noexcept {
+    static alloc_site sites[EProfileSites + 1] = {};
+    return sites;
+}
+
+inline size_t& alloc_profiler::S_nsite() noexcept {
+    static size_t nsite = 0;
+    return nsite;
+}
+
+inline alloc_profiler::sample*& alloc_profiler::S_samples() noexcept {
+    static sample *samples = nullptr;
+    return samples;
+}
+
+inline size_t& alloc_profiler::S_sample_capacity() noexcept {
+    static size_t capacity = 0;
+    return capacity;
+}
+
+inline size_t& alloc_profiler::S_nsample() noexcept {
+    static size_t nsample = 0;
+    return nsample;
+}
+
+inline std::FILE*& alloc_profiler::S_exit_out() noexcept {
+    static std::FILE *out = nullptr;
+    return out;
+}
+
+inline ptrdiff_t& alloc_profiler::S_bytes_left() noexcept {
+    static thread_local ptrdiff_t bytes_left = 0;
+    return bytes_left;
+}
+
+inline uint64_t& alloc_profiler::S_seed() noexcept {
+    static thread_local uint64_t seed = 0;
+    return seed;
+}
+
+/* A random distance to the next sample, exponential with the mean rate */
+inline ptrdiff_t alloc_profiler::S_next_interval(size_t rate) noexcept {
+    if (S_seed() == 0) {
+        S_seed() = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(&S_seed())) | 1;
+    }
+    /* xorshift64 */
+    S_seed() ^= S_seed() << 13;
+    S_seed() ^= S_seed() >> 7;
+    S_seed() ^= S_seed() << 17;
+    double u = (static_cast<double>(S_seed() >> 11) + 1.0) / 9007199254740993.0;
+    double d = -std::log(u) * static_cast<double>(rate);
+    return d < static_cast<double>(PTRDIFF_MAX >> 1)
+        ? static_cast<ptrdiff_t>(d) : (PTRDIFF_MAX >> 1);
+}
+
+/*
+ * The countdown of current thread reaches zero at p. A new thread starts
+ * at zero, so its first call only draws the distance.
+*/
+inline void alloc_profiler::S_sample(void *p, size_t n) noexcept {
+    bool first = S_seed() == 0;
+    size_t rate = sample_rate();
+    if (rate == 0) {
+        S_bytes_left() = PTRDIFF_MAX >> 1;
+        return;
+    }
+    S_bytes_left() = S_next_interval(rate);
+    if (first) return;
+
+    sample s;
+    s.ptr = p;
+    s.bytes = n < rate ? rate : n;
+    s.count = s.bytes / n;
+    void *frames[EProfileMaxFrames + 1];
+    size_t depth = 0;
+#ifdef SABERSTL_HAS_BACKTRACE
+    int got = backtrace(frames, EProfileMaxFrames + 1);
+    depth = got > 1 ? static_cast<size_t>(got) - 1 : 0;   // skip S_sample
+#endif
+    S_acquire();
+    s.site = S_find_site(frames + 1, depth);
+    if (S_insert(s)) {
+        alloc_site& site = S_sites()[s.site];
+        site.allocs += s.count;
+        site.alloc_bytes += s.bytes;
+        S_filter()[S_slot(reinterpret_cast<uintptr_t>(p))].fetch_add(1, std::memory_order_relaxed);
+    }
+    S_release();
+}
+
+/* p may be sampled, remove it from the table and count the free to its site */
+inline void alloc_profiler::S_forget(uintptr_t addr) noexcept {
+    S_acquire();
+    size_t mask = S_sample_capacity() - 1;
+    size_t i = S_samples() != nullptr ? S_home(reinterpret_cast<void*>(addr)) : 0;
+    for (; S_samples() != nullptr && S_samples()[i].ptr != nullptr; i = (i + 1) & mask) {
+        if (reinterpret_cast<uintptr_t>(S_samples()[i].ptr) != addr) continue;
+        alloc_site& site = S_sites()[S_samples()[i].site];
+        site.frees += S_samples()[i].count;
+        site.free_bytes += S_samples()[i].bytes;
+        S_filter()[S_slot(addr)].fetch_sub(1, std::memory_order_relaxed);
+        S_nsample()--;
+        /* Move the following samples back, so no probe meets a hole */
+        size_t hole = i;
+        for (size_t j = (i + 1) & mask; S_samples()[j].ptr != nullptr; j = (j + 1) & mask) {
+            size_t home = S_home(S_samples()[j].ptr);
+            if (((j - home) & mask) >= ((j - hole) & mask)) {
+                S_samples()[hole] = S_samples()[j];
+                hole = j;
+            }
+        }
+        S_samples()[hole].ptr = nullptr;
+        break;
+    }
+    S_release();
+}
+
+/* Find or add the site of the frames, the lock must be held */
+inline size_t alloc_profiler::S_find_site(void **frames, size_t depth) noexcept {
+    uint64_t h = 1469598103934665603ull;    // FNV-1a
+    for (size_t i = 0; i < depth; i++) {
+        h ^= static_cast<uint64_t>(reinterpret_cast<uintptr_t>(frames[i]));
+        h *= 1099511628211ull;
+    }
+    size_t i = static_cast<size_t>(h) & (EProfileSites - 1);
+    for (size_t probe = 0; probe < EProfileSites; probe++, i = (i + 1) & (EProfileSites - 1)) {
+        alloc_site& s = S_sites()[i];
+        if (s.hash == 0) {
+            if (S_nsite() + 1 >= EProfileSites) break;    // keep the table sparse
+            s.hash = h | 1;
+            s.depth = depth;
+            for (size_t k = 0; k < depth; k++) s.frames[k] = frames[k];
+            S_nsite()++;
+            return i;
+        }
+        if (s.hash == (h | 1) && s.depth == depth) {
+            size_t k = 0;
+            while (k < depth && s.frames[k] == frames[k]) k++;
+            if (k == depth) return i;
+        }
+    }
+    return EProfileSites;   // the site of all the others
+}
+
+/* Add a sample into the table, the lock must be held */
+inline bool alloc_profiler::S_insert(const sample& s) noexcept {
+    if ((S_nsample() + 1) * 2 > S_sample_capacity() && !S_grow()) return false;
+    size_t mask = S_sample_capacity() - 1;
+    size_t i = S_home(s.ptr);
+    while (S_samples()[i].ptr != nullptr) i = (i + 1) & mask;
+    S_samples()[i] = s;
+    S_nsample()++;
+    return true;
+}
+
+/* Double the sample table, the lock must be held */
+inline bool alloc_profiler::S_grow() noexcept {
+    size_t capacity = S_sample_capacity() == 0 ? 1024 : S_sample_capacity() << 1;
+    sample *samples = static_cast<sample*>(std::calloc(capacity, sizeof(sample)));
+    if (samples == nullptr) return false;
+    sample *old = S_samples();
+    size_t old_capacity = S_sample_capacity();
+    S_samples() = samples;
+    S_sample_capacity() = capacity;
+    for (size_t i = 0; i < old_capacity; i++) {
+        if (old[i].ptr == nullptr) continue;
+        size_t j = S_home(old[i].ptr);
+        while (samples[j].ptr != nullptr) j = (j + 1) & (capacity - 1);
+        samples[j] = old[i];
+    }
+    std::free(old);
+    return true;
+}
+
+inline void alloc_profiler::S_print_site(std::FILE *out, const alloc_site& s) {
+    std::fprintf(out, "  live %zu bytes in %zu objects, allocated %zu bytes in %zu objects\n",
+                 s.alloc_bytes - s.free_bytes, s.allocs - s.frees, s.alloc_bytes, s.allocs);
+    if (s.depth == 0) {
+        std::fprintf(out, "    (no call stack)\n");
+        return;
+    }
+#ifdef SABERSTL_HAS_BACKTRACE
+    char **names = backtrace_symbols(const_cast<void* const*>(s.frames),
+                                     static_cast<int>(s.depth));
+    for (size_t i = 0; i < s.depth; i++) {
+        if (names != nullptr) std::fprintf(out, "    %s\n", names[i]);
+        else std::fprintf(out, "    %p\n", s.frames[i]);
+    }
+    std::free(names);
+#endif
+}
+
+/* Order the sites by their live bytes, then by the bytes allocated */
+inline int alloc_site_live_compare(const void *lhs, const void *rhs) {
+    const alloc_site *l = *(const alloc_site* const*)lhs;
+    const alloc_site *r = *(const alloc_site* const*)rhs;
+    size_t lb = l->alloc_bytes - l->free_bytes, rb = r->alloc_bytes - r->free_bytes;
+    return lb > rb ? -1 : (lb < rb ? 1 : 0);
+}
+
+inline int alloc_site_churn_compare(const void *lhs, const void *rhs) {
+    const alloc_site *l = *(const alloc_site* const*)lhs;
+    const alloc_site *r = *(const alloc_site* const*)rhs;
+    return l->alloc_bytes > r->alloc_bytes ? -1 : (l->alloc_bytes < r->alloc_bytes ? 1 : 0);
+}
+
+/*
+ * Print the top sites by live bytes (the leaks when called at exit) and
+ * by bytes allocated (the churn). It can be called from any thread.
+*/
+inline void alloc_profiler::report(std::FILE *out, size_t top) {
+    S_acquire();
+    const alloc_site **sites = static_cast<const alloc_site**>(
+        std::malloc((EProfileSites + 1) * sizeof(alloc_site*)));
+    if (sites == nullptr) {
+        S_release();
+        return;
+    }
+    size_t n = 0;
+    size_t live = 0, total = 0;
+    for (size_t i = 0; i <= EProfileSites; i++) {
+        if (S_sites()[i].allocs == 0) continue;
+        sites[n++] = S_sites() + i;
+        live += S_sites()[i].alloc_bytes - S_sites()[i].free_bytes;
+        total += S_sites()[i].alloc_bytes;
+    }
+    std::fprintf(out, "saberstl allocation profile, one sample in %zu bytes\n", sample_rate());
+    std::fprintf(out, "  sites: %zu, live bytes: %zu, allocated bytes: %zu\n", n, live, total);
+
+    std::qsort(sites, n, sizeof(alloc_site*), alloc_site_live_compare);
+    std::fprintf(out, "live heap by site:\n");
+    for (size_t i = 0; i < n && i < top; i++) {
+        if (sites[i]->alloc_bytes == sites[i]->free_bytes) break;
+        S_print_site(out, *sites[i]);
+    }
+    std::qsort(sites, n, sizeof(alloc_site*), alloc_site_churn_compare);
+    std::fprintf(out, "churn by site:\n");
+    for (size_t i = 0; i < n && i < top; i++) {
+        S_print_site(out, *sites[i]);
+    }
+    std::free(sites);
+    S_release();
+}
+
+/* Print the report into out when the program exits */
+inline void alloc_profiler::report_at_exit(std::FILE *out) {
+    S_acquire();
+    bool registered = S_exit_out() != nullptr;
+    S_exit_out() = out;
+    S_release();
+    if (!registered) std::atexit(S_exit_report);
+}
+
+inline void alloc_profiler::S_exit_report() {
+    if (S_exit_out() != nullptr) report(S_exit_out());
+}
+
+} // namespace saberstl
+
+#endif // SABERSTL_ALLOC_PROFILE
+
+#endif // !SABERSTL_ALLOC_PROFILER_H
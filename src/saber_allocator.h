@@ -5,13 +5,51 @@
  * The template class 'allocator'
  * To manage memory's alloc and free, 
  * And to manage the object's construction, destruction
+ *
+ * The template class 'pool_allocator' has the same interface, but takes
+ * the small blocks from the memory pool alloc instead of ::operator new
 */
 
+#include <new>
+#include <cstddef>
+#include <cstdint>
+
 #include "saber_construct.h"
 #include "saber_util.h"
 
+#include "saber_alloc.h"
+
 namespace saberstl {
 
+/*
+ * Get memory aligned to align from ::operator new, align must be a power
+ * of 2. Before C++17 there is no aligned ::operator new, so take align
+ * more bytes and keep the address got just before the aligned space.
+*/
+inline void* aligned_operator_new(size_t bytes, size_t align) {
+    if (align <= alignof(std::max_align_t)) return ::operator new(bytes);
+#ifdef __cpp_aligned_new
+    return ::operator new(bytes, std::align_val_t(align));
+#else
+    char* raw = static_cast<char*>(::operator new(bytes + align));
+    char* p = raw + align - (reinterpret_cast<uintptr_t>(raw) & (align - 1));
+    reinterpret_cast<char**>(p)[-1] = raw;
+    return p;
+#endif
+}
+
+inline void aligned_operator_delete(void* ptr, size_t align) {
+    if (align <= alignof(std::max_align_t)) {
+        ::operator delete(ptr);
+        return;
+    }
+#ifdef __cpp_aligned_new
+    ::operator delete(ptr, std::align_val_t(align));
+#else
+    ::operator delete(reinterpret_cast<char**>(ptr)[-1]);
+#endif
+}
+
 /*
  * Template class: allocator
 */ 
@@ -24,13 +62,24 @@ public:
     typedef T&          reference;
     typedef const T&    const_reference;
     typedef size_t      size_type;
+    typedef ptrdiff_t   difference_type;
+
+    template <class U>
+    struct rebind {
+        typedef allocator<U> other;
+    };
 
 public:
     static T* allocate();
     static T* allocate(size_type n);
+    static T* allocate(size_type n, size_type align);
 
     static void deallocate(T* ptr);
     static void deallocate(T* ptr, size_type n);
+    static void deallocate(T* ptr, size_type n, size_type align);
+
+    static void allocate_bulk(T** out, size_type count);
+    static void deallocate_bulk(T** ptrs, size_type count);
 
     static void construct(T* ptr);
     static void construct(T* ptr, const T& value);
@@ -41,29 +90,85 @@ public:
 
     static void destory(T* ptr);
     static void destory(T* first, T* last);
+
+private:
+    static void* S_allocate(size_type bytes, size_type align);
+    static void S_deallocate(void* ptr, size_type bytes, size_type align);
 };
 
 template<class T>
 T* allocator<T>::allocate() {
-    return static_cast<T*>(::operator new(sizeof(T)));
+    return static_cast<T*>(S_allocate(sizeof(T), alignof(T)));
 }
 
 template<class T>
 T* allocator<T>::allocate(size_type n) {
     if (n == 0) return nullptr;
-    return static_cast<T*>(::operator new(n * sizeof(T)));
+    return static_cast<T*>(S_allocate(n * sizeof(T), alignof(T)));
+}
+
+/* Alloc n objects aligned to align (not less than alignof(T)), such as a cache line */
+template<class T>
+T* allocator<T>::allocate(size_type n, size_type align) {
+    if (n == 0) return nullptr;
+    return static_cast<T*>(S_allocate(n * sizeof(T), align < alignof(T) ? alignof(T) : align));
 }
 
+/* ptr must come from allocate() */
 template<class T>
 void allocator<T>::deallocate(T* ptr) {
     if (ptr == nullptr) return;
-    ::operator delete(ptr);
+    S_deallocate(ptr, sizeof(T), alignof(T));
+}
+
+/* ptr must come from allocate(n) with the same n */
+template<class T>
+void allocator<T>::deallocate(T* ptr, size_type n) {
+    if (ptr == nullptr) return;
+    S_deallocate(ptr, n * sizeof(T), alignof(T));
 }
 
+/* ptr must come from allocate(n, align) with the same n and align */
 template<class T>
-void allocator<T>::deallocate(T* ptr, size_type /*size*/) {
+void allocator<T>::deallocate(T* ptr, size_type n, size_type align) {
     if (ptr == nullptr) return;
-    ::operator delete(ptr);
+    S_deallocate(ptr, n * sizeof(T), align < alignof(T) ? alignof(T) : align);
+}
+
+/* Alloc count objects into out, either all of them or none */
+template<class T>
+void allocator<T>::allocate_bulk(T** out, size_type count) {
+    size_type i = 0;
+    try {
+        for (; i < count; i++) out[i] = static_cast<T*>(S_allocate(sizeof(T), alignof(T)));
+    } catch (...) {
+        deallocate_bulk(out, i);
+        throw;
+    }
+}
+
+/* Every object of ptrs must come from allocate() or allocate_bulk() */
+template<class T>
+void allocator<T>::deallocate_bulk(T** ptrs, size_type count) {
+    for (size_type i = 0; i < count; i++) S_deallocate(ptrs[i], sizeof(T), alignof(T));
+}
+
+template<class T>
+void* allocator<T>::S_allocate(size_type bytes, size_type align) {
+    void* p = aligned_operator_new(bytes, align);
+#ifdef SABERSTL_ALLOC_PROFILE
+    alloc_profiler::on_allocate(p, bytes);
+#endif
+    return p;
+}
+
+template<class T>
+void allocator<T>::S_deallocate(void* ptr, size_type bytes, size_type align) {
+    (void)bytes;
+#ifdef SABERSTL_ALLOC_PROFILE
+    alloc_profiler::on_deallocate(ptr);
+#endif
+    aligned_operator_delete(ptr, align);
 }
 
 template<class T>
@@ -97,6 +202,175 @@ void allocator<T>::destory(T* first, T* last) {
     saberstl::destory(first, last);
 }
 
+/* allocator has no state, all the allocators are equal */
+template <class T, class U>
+bool operator==(const allocator<T>&, const allocator<U>&) noexcept {
+    return true;
+}
+
+template <class T, class U>
+bool operator!=(const allocator<T>&, const allocator<U>&) noexcept {
+    return false;
+}
+
+/*
+ * Template class: pool_allocator
+ * Has the same interface as allocator, but the blocks come from alloc,
+ * which finds the free list by the size, so deallocate must get the same
+ * size and alignment as allocate. Requests above ESmallObjectBytes go to
+ * alloc's malloc path.
+*/
+template <class T>
+class pool_allocator {
+public:
+    typedef T           value_type;
+    typedef T*          pointer;
+    typedef const T*    const_pointer;
+    typedef T&          reference;
+    typedef const T&    const_reference;
+    typedef size_t      size_type;
+    typedef ptrdiff_t   difference_type;
+
+    template <class U>
+    struct rebind {
+        typedef pool_allocator<U> other;
+    };
+
+public:
+    static T* allocate();
+    static T* allocate(size_type n);
+    static T* allocate(size_type n, size_type align);
+
+    static void deallocate(T* ptr);
+    static void deallocate(T* ptr, size_type n);
+    static void deallocate(T* ptr, size_type n, size_type align);
+
+    static void allocate_bulk(T** out, size_type count);
+    static void deallocate_bulk(T** ptrs, size_type count);
+
+    static void construct(T* ptr);
+    static void construct(T* ptr, const T& value);
+    static void construct(T* ptr, T&& value);
+
+    template<class... Args>
+    static void construct(T* ptr, Args&& ...args);
+
+    static void destory(T* ptr);
+    static void destory(T* first, T* last);
+
+private:
+    static void* S_allocate(size_type bytes, size_type align);
+};
+
+template<class T>
+T* pool_allocator<T>::allocate() {
+    return static_cast<T*>(S_allocate(sizeof(T), alignof(T)));
+}
+
+template<class T>
+T* pool_allocator<T>::allocate(size_type n) {
+    if (n == 0) return nullptr;
+    return static_cast<T*>(S_allocate(n * sizeof(T), alignof(T)));
+}
+
+template<class T>
+T* pool_allocator<T>::allocate(size_type n, size_type align) {
+    if (n == 0) return nullptr;
+    return static_cast<T*>(S_allocate(n * sizeof(T), align < alignof(T) ? alignof(T) : align));
+}
+
+template<class T>
+void pool_allocator<T>::deallocate(T* ptr) {
+    if (ptr == nullptr) return;
+    alloc::deallocate(ptr, sizeof(T), alignof(T));
+}
+
+template<class T>
+void pool_allocator<T>::deallocate(T* ptr, size_type n) {
+    if (ptr == nullptr) return;
+    alloc::deallocate(ptr, n * sizeof(T), alignof(T));
+}
+
+template<class T>
+void pool_allocator<T>::deallocate(T* ptr, size_type n, size_type align) {
+    if (ptr == nullptr) return;
+    alloc::deallocate(ptr, n * sizeof(T), align < alignof(T) ? alignof(T) : align);
+}
+
+/* Alloc count objects into out, either all of them or none, in batches from alloc */
+template<class T>
+void pool_allocator<T>::allocate_bulk(T** out, size_type count) {
+    if (alignof(T) <= static_cast<size_t>(EAlign128)) {
+        alloc::allocate_bulk(sizeof(T), count, reinterpret_cast<void**>(out));
+        return;
+    }
+    size_type i = 0;
+    try {
+        for (; i < count; i++) out[i] = static_cast<T*>(S_allocate(sizeof(T), alignof(T)));
+    } catch (...) {
+        deallocate_bulk(out, i);
+        throw;
+    }
+}
+
+template<class T>
+void pool_allocator<T>::deallocate_bulk(T** ptrs, size_type count) {
+    if (alignof(T) <= static_cast<size_t>(EAlign128)) {
+        alloc::deallocate_bulk(sizeof(T), count, reinterpret_cast<void**>(ptrs));
+        return;
+    }
+    for (size_type i = 0; i < count; i++) alloc::deallocate(ptrs[i], sizeof(T), alignof(T));
+}
+
+template<class T>
+void* pool_allocator<T>::S_allocate(size_type bytes, size_type align) {
+    void* p = alloc::allocate(bytes, align);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+template<class T>
+void pool_allocator<T>::construct(T* ptr) {
+    saberstl::construct(ptr);
+}
+
+template<class T>
+void pool_allocator<T>::construct(T* ptr, const T& value) {
+    saberstl::construct(ptr, value);
+}
+
+template<class T>
+void pool_allocator<T>::construct(T* ptr, T&& value) {
+    saberstl::construct(ptr, saberstl::move(value));
+}
+
+template<class T>
+template<class ...Args>
+void pool_allocator<T>::construct(T* ptr, Args&& ...args) {
+    saberstl::construct(ptr, saberstl::forward<Args>(args)...);
+}
+
+template<class T>
+void pool_allocator<T>::destory(T* ptr) {
+    saberstl::destory(ptr);
+}
+
+template<class T>
+void pool_allocator<T>::destory(T* first, T* last) {
+    saberstl::destory(first, last);
+}
+
+/* pool_allocator has no state either, the memory pool is shared */
+template <class T, class U>
+bool operator==(const pool_allocator<T>&, const pool_allocator<U>&) noexcept {
+    return true;
+}
+
+template <class T, class U>
+bool operator!=(const pool_allocator<T>&, const pool_allocator<U>&) noexcept {
+    return false;
+}
+
 }; // namespace saberstl
 
 #endif // !SABERSTL__ALLOCATOR_H
\ No newline at end of file
@@ -0,0 +1,259 @@
+#ifndef SABERSTL_ARENA_H
+#define SABERSTL_ARENA_H
+
+/*
+ * This header file contains a class monotonic_arena, which hands out memory
+ * by bumping a pointer and frees everything at once, and the template class
+ * arena_allocator, which adapts it to the interface of allocator
+*/
+
+#include <new>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#include "saber_construct.h"
+#include "saber_util.h"
+
+namespace saberstl {
+
+/* Size of the first block of an arena */
+enum { EArenaInitBytes = 4096 };
+
+/* Blocks stop doubling when they reach this size */
+enum { EArenaMaxGrowBytes = 1 << 24 };
+
+/*
+ * class monotonic_arena
+ * Memory is taken from a chain of blocks by bumping a pointer, deallocate
+ * does nothing. reset() rewinds the arena and keeps the largest block for
+ * reuse, release() gives all the blocks back.
+*/
+class monotonic_arena {
+private:
+    struct block {
+        block *next;        // previous block
+        size_t size;        // bytes following the header
+    };
+
+    block *head_;           // the current block
+    char *cur_;             // first free byte of the current block
+    char *end_;             // end of the current block
+    size_t next_size_;      // size of the next block
+    size_t used_;           // bytes handed out since the last reset
+
+public:
+    explicit monotonic_arena(size_t initial_size = EArenaInitBytes) noexcept
+    : head_(nullptr), cur_(nullptr), end_(nullptr),
+      next_size_(initial_size == 0 ? 1 : initial_size), used_(0) {}
+
+    ~monotonic_arena() {
+        release();
+    }
+
+public:
+    void *allocate(size_t n, size_t align = alignof(std::max_align_t));
+    void deallocate(void *, size_t) noexcept {}
+
+    void reset() noexcept;
+    void release() noexcept;
+
+    /* Bytes handed out since the last reset */
+    size_t bytes_used() const noexcept { return used_; }
+    size_t bytes_reserved() const noexcept;
+
+private:
+    void *allocate_slow(size_t n, size_t align);
+
+private:
+    monotonic_arena(const monotonic_arena&);
+    void operator=(const monotonic_arena&);
+};
+
+/* Alloc n bytes aligned to align, align must be a power of 2 */
+inline void* monotonic_arena::allocate(size_t n, size_t align) {
+    size_t pad = static_cast<size_t>(-reinterpret_cast<uintptr_t>(cur_)) & (align - 1);
+    if (cur_ != nullptr && static_cast<size_t>(end_ - cur_) >= n + pad) {
+        char *result = cur_ + pad;
+        cur_ = result + n;
+        used_ += n;
+        return result;
+    }
+    return allocate_slow(n, align);
+}
+
+/* The current block is used up, chain a new one at least twice as large */
+inline void* monotonic_arena::allocate_slow(size_t n, size_t align) {
+    size_t size = next_size_;
+    if (size < n + align) size = n + align;
+    block *b = static_cast<block*>(std::malloc(sizeof(block) + size));
+    if (b == nullptr) throw std::bad_alloc();
+    b->next = head_;
+    b->size = size;
+    head_ = b;
+    cur_ = reinterpret_cast<char*>(b + 1);
+    end_ = cur_ + size;
+    if (next_size_ < static_cast<size_t>(EArenaMaxGrowBytes)) next_size_ <<= 1;
+    return allocate(n, align);
+}
+
+/*
+ * Drop all the objects, keep the largest block for reuse. It is usually
+ * the current one, but an oversized block taken for a single large object
+ * earlier may be larger.
+*/
+inline void monotonic_arena::reset() noexcept {
+    if (head_ == nullptr) return;
+    block *keep = head_;
+    for (block *b = head_->next; b != nullptr; b = b->next) {
+        if (b->size > keep->size) keep = b;
+    }
+    block *b = head_;
+    while (b != nullptr) {
+        block *next = b->next;
+        if (b != keep) std::free(b);
+        b = next;
+    }
+    keep->next = nullptr;
+    head_ = keep;
+    cur_ = reinterpret_cast<char*>(keep + 1);
+    end_ = cur_ + keep->size;
+    used_ = 0;
+}
+
+/* Drop all the objects and give all the blocks back */
+inline void monotonic_arena::release() noexcept {
+    block *b = head_;
+    while (b != nullptr) {
+        block *next = b->next;
+        std::free(b);
+        b = next;
+    }
+    head_ = nullptr;
+    cur_ = end_ = nullptr;
+    used_ = 0;
+}
+
+/* Bytes of all the blocks */
+inline size_t monotonic_arena::bytes_reserved() const noexcept {
+    size_t bytes = 0;
+    for (block *b = head_; b != nullptr; b = b->next) bytes += b->size;
+    return bytes;
+}
+
+
+/*
+ * Template class: arena_allocator
+ * Has the same interface as allocator, but takes the memory from the
+ * monotonic_arena it refers to. deallocate does nothing, the memory comes
+ * back when the arena is reset or released.
+*/
+template <class T>
+class arena_allocator {
+public:
+    typedef T           value_type;
+    typedef T*          pointer;
+    typedef const T*    const_pointer;
+    typedef T&          reference;
+    typedef const T&    const_reference;
+    typedef size_t      size_type;
+    typedef ptrdiff_t   difference_type;
+
+    template <class U>
+    struct rebind {
+        typedef arena_allocator<U> other;
+    };
+
+private:
+    monotonic_arena *arena_;
+
+public:
+    explicit arena_allocator(monotonic_arena& arena) noexcept : arena_(&arena) {}
+
+    template <class U>
+    arena_allocator(const arena_allocator<U>& other) noexcept : arena_(other.arena()) {}
+
+    monotonic_arena *arena() const noexcept { return arena_; }
+
+public:
+    T* allocate();
+    T* allocate(size_type n);
+
+    void deallocate(T* ptr);
+    void deallocate(T* ptr, size_type n);
+
+    static void construct(T* ptr);
+    static void construct(T* ptr, const T& value);
+    static void construct(T* ptr, T&& value);
+
+    template<class... Args>
+    static void construct(T* ptr, Args&& ...args);
+
+    static void destory(T* ptr);
+    static void destory(T* first, T* last);
+};
+
+template<class T>
+T* arena_allocator<T>::allocate() {
+    return static_cast<T*>(arena_->allocate(sizeof(T), alignof(T)));
+}
+
+template<class T>
+T* arena_allocator<T>::allocate(size_type n) {
+    if (n == 0) return nullptr;
+    return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T)));
+}
+
+template<class T>
+void arena_allocator<T>::deallocate(T* /*ptr*/) {
+}
+
+template<class T>
+void arena_allocator<T>::deallocate(T* /*ptr*/, size_type /*size*/) {
+}
+
+template<class T>
+void arena_allocator<T>::construct(T* ptr) {
+    saberstl::construct(ptr);
+}
+
+template<class T>
+void arena_allocator<T>::construct(T* ptr, const T& value) {
+    saberstl::construct(ptr, value);
+}
+
+template<class T>
+void arena_allocator<T>::construct(T* ptr, T&& value) {
+    saberstl::construct(ptr, saberstl::move(value));
+}
+
+template<class T>
+template<class ...Args>
+void arena_allocator<T>::construct(T* ptr, Args&& ...args) {
+    saberstl::construct(ptr, saberstl::forward<Args>(args)...);
+}
+
+template<class T>
+void arena_allocator<T>::destory(T* ptr) {
+    saberstl::destory(ptr);
+}
+
+template<class T>
+void arena_allocator<T>::destory(T* first, T* last) {
+    saberstl::destory(first, last);
+}
+
+/* Two arena_allocators are equal when they share the arena */
+template <class T, class U>
+bool operator==(const arena_allocator<T>& lhs, const arena_allocator<U>& rhs) noexcept {
+    return lhs.arena() == rhs.arena();
+}
+
+template <class T, class U>
+bool operator!=(const arena_allocator<T>& lhs, const arena_allocator<U>& rhs) noexcept {
+    return lhs.arena() != rhs.arena();
+}
+
+} // namespace saberstl
+
+#endif // !SABERSTL_ARENA_H
@@ -4,7 +4,9 @@
 // Template Class: basic_string
 
 #include <iostream>
+#include <type_traits>
 
+#include "saber_string_view.h"
 #include "saber_iterator.h"
 #include "saber_memory.h"
 #include "saber_functional.h"
@@ -12,322 +14,1168 @@
 
 namespace saberstl {
 
-// char_traits
+// Initialize the minimize buffer size of the basic_string on the heap
+#define STRING_INTI_SIZE 32
+
+// Keeps the allocator of a basic_string. An empty allocator, such as
+// saberstl::allocator, is not stored and takes no space in the string
+template <class Allocator, bool = std::is_empty<Allocator>::value>
+class basic_string_alloc {
+protected:
+    basic_string_alloc() noexcept {}
+    explicit basic_string_alloc(const Allocator&) noexcept {}
 
-template <class CharType>
-struct char_traits {
-    typedef CharType char_type;
+    Allocator data_alloc() const noexcept { return Allocator(); }
+    void swap_alloc(basic_string_alloc&) noexcept {}
+};
+
+template <class Allocator>
+class basic_string_alloc<Allocator, false> {
+private:
+    Allocator alloc_;
 
-    static size_t length(const char_type* str) {
-        size_t len = 0;
-        for (; *str != char_type(0); str++) len++;
-        return len;
+protected:
+    basic_string_alloc() noexcept : alloc_() {}
+    explicit basic_string_alloc(const Allocator& a) noexcept : alloc_(a) {}
+
+    Allocator& data_alloc() noexcept { return alloc_; }
+    const Allocator& data_alloc() const noexcept { return alloc_; }
+    void swap_alloc(basic_string_alloc& rhs) noexcept {
+        Allocator tmp = alloc_;
+        alloc_ = rhs.alloc_;
+        rhs.alloc_ = tmp;
     }
+};
 
-    static int compare(const char_type* s1, const char_type* s2, size_t n) {
-        for (; n != 0; n--, s1++, s2++) {
-            if (*s1 < *s2) return -1;
-            if (*s1 > *s2) return 1;
-        }
-        return 0;
+// template class basic_string
+// Parameter 1 represents the type of string;
+// Parameter 2 represents the solution of extraction type of string, default using saberstl::char_traits
+// Parameter 3 represents the allocator of the buffer, default using saberstl::allocator;
+// a stateful one such as polymorphic_allocator is kept in the string
+//
+// Small string optimization: a short string lives in the object itself, in
+// the space of the buffer pointer, the size and the capacity of a long one,
+// up to 22 chars on 64-bit systems. The last byte of the object is the tag:
+// it keeps the size of a short string, or has the high bit set as a part of
+// the capacity of a long one. Only a long string owns a buffer on the heap.
+template <class CharType, class CharTraits = saberstl::char_traits<CharType>,
+          class Allocator = saberstl::allocator<CharType>>
+class basic_string : private basic_string_alloc<Allocator> {
+public:
+    typedef CharTraits                                  traits_type;
+    typedef CharTraits                                  char_traits;
+
+    typedef Allocator                                   allocator_type;
+    typedef Allocator                                   data_allocator;
+
+    typedef typename allocator_type::value_type         value_type;
+    typedef typename allocator_type::pointer            pointer;
+    typedef typename allocator_type::const_pointer      const_pointer;
+    typedef typename allocator_type::reference          reference;
+    typedef typename allocator_type::const_reference    const_reference;
+    typedef typename allocator_type::size_type          size_type;
+    typedef typename allocator_type::difference_type    difference_type;
+
+    typedef value_type*                                 iterator;
+    typedef const value_type*                           const_iterator;
+    typedef saberstl::reverse_iterator<iterator>        reverse_iterator;
+    typedef saberstl::reverse_iterator<const_iterator>  const_reverse_iterator;
+    typedef saberstl::reverse_iterator<const_iterator>  const_reverser_iterator;
+
+    typedef basic_string_view<CharType, CharTraits>     string_view_type;
+
+    allocator_type get_allocator() const noexcept {
+        return this->data_alloc();
     }
 
-    static char_type* copy(char_type* dst, const char_type* src, size_t n) {
-        SABERSTL_DEBUG(src + n <= dst || dst + n <= src);
-        char_type* r = dst;
-        for (; n != 0; n--, dst++, src++) {
-            *dst = *src;
-        }
-        return r;
-    }
-
-    static char_type* move(char_type* dst, const char_type* src, size_t n) {
-        char_type* r = dst;
-        if (dst < src) {
-            for (; n != 0; n--, dst++, src++) 
-                *dst = *src;
-        } else if (src < dst) {
-            dst += n;
-            src += n;
-            for (; n != 0; n--) 
-                *--dst = *--src;
-        }
-        return r;
+    static_assert(std::is_pod<CharType>::value, 
+                  "Character type of basic_string must be a POD");
+    static_assert(std::is_same<CharType, typename traits_type::char_type>::value,
+                  "Character must be same as traits_type::char_type");
+
+public:
+    // Handle the last point value, ex:
+    // if (str.find('a') != string::npos) { /* do something */ }
+    static constexpr size_type npos = static_cast<size_type>(-1);
+
+private:
+    // The layout of a long string
+    struct long_rep {
+        pointer buffer;     // Store the initial address of string
+        size_type size;     // Store the size of string
+        size_type cap;      // Store the capacity of string, its last byte is the tag
+    };
+
+    enum : size_t {
+        // Slots of a short string, the last byte is left to the tag
+        ESsoSlots = (sizeof(long_rep) - 1) / sizeof(CharType),
+        // Most characters of a short string, one slot is left to the end
+        ESsoCapacity = ESsoSlots - 1
+    };
+
+    // The bit of the tag set by a long string
+    enum : unsigned char { ELongTag = 0x80 };
+
+    static_assert(ESsoSlots >= 1, "Character type of basic_string is too large");
+
+    union rep {
+        long_rep l;                 // a long string
+        value_type s[ESsoSlots];    // a short string
+    };
+
+    typedef basic_string_alloc<Allocator> alloc_base;
+
+    rep rep_;   // Store the short string or the long one
+
+public:
+    
+    basic_string() noexcept {
+        try_init();
+    }
+    explicit basic_string(const allocator_type& a) noexcept : alloc_base(a) {
+        try_init();
     }
 
-    static char_type* fill(char_type* dst, char_type ch, size_t count) {
-        char_type* r = dst;
-        for (; count > 0; count--, dst++) 
-            *dst = ch;
-        return r;
+    basic_string(size_type n, value_type ch, const allocator_type& a = allocator_type())
+    : alloc_base(a) {
+        fill_init(n, ch);
     }
-}; // struct char_traits
 
-// Partialized char_traits<char>
-template <>
-struct char_traits<char> {
+    basic_string(const basic_string& other, size_type pos,
+                 const allocator_type& a = allocator_type()) : alloc_base(a) {
+        THROW_OUT_OF_RANGE_IF(pos > other.size(), "basic_string<Char, Traits>'s pos out of range");
+        init_from(other.data(), pos, other.size() - pos);
+    }
+    basic_string(const basic_string& other, size_type pos, size_type count,
+                 const allocator_type& a = allocator_type()) : alloc_base(a) {
+        THROW_OUT_OF_RANGE_IF(pos > other.size(), "basic_string<Char, Traits>'s pos out of range");
+        init_from(other.data(), pos, saberstl::min(count, other.size() - pos));
+    }
 
-    typedef char char_type;
+    basic_string(const_pointer str, const allocator_type& a = allocator_type()) : alloc_base(a) {
+        init_from(str, 0, char_traits::length(str));
+    }
+    basic_string(const_pointer str, size_type count, const allocator_type& a = allocator_type())
+    : alloc_base(a) {
+        init_from(str, 0, count);
+    }
 
-    static size_t length(const char_type* str) noexcept {
-        return std::strlen(str);
+    explicit basic_string(string_view_type str, const allocator_type& a = allocator_type())
+    : alloc_base(a) {
+        init_from(str.data(), 0, str.size());
+    }
+    basic_string(string_view_type str, size_type pos, size_type count,
+                 const allocator_type& a = allocator_type()) : alloc_base(a) {
+        THROW_OUT_OF_RANGE_IF(pos > str.size(), "basic_string<Char, Traits>'s pos out of range");
+        init_from(str.data(), pos, saberstl::min(count, str.size() - pos));
     }
 
-    static int compare(const char_type* s1, const char_type* s2, size_t n) noexcept {
-        return std::memcmp(s1, s2, n);
+    template <class Iter, typename std::enable_if<
+      saberstl::is_input_iterator<Iter>::value, int>::type = 0>
+    basic_string(Iter first, Iter last, const allocator_type& a = allocator_type())
+    : alloc_base(a) {
+        copy_init(first, last, iterator_category(first));
     }
 
-    static char_type* copy(char_type* dst, const char_type* src, size_t n) noexcept {
-        SABERSTL_DEBUG(src + n <= dst || dst + n <= src);
-        return static_cast<char_type*>(std::memcpy(dst, src, n));
+    // A short string is copied as it is, without looking at its size.
+    // The copy takes the allocator select_on_container_copy_construction
+    // gives, if the allocator has it
+    basic_string(const basic_string& rhs)
+    : alloc_base(S_copy_alloc(rhs.get_allocator(), 0)) {
+        if (rhs.is_long()) init_from(rhs.data(), 0, rhs.size());
+        else rep_ = rhs.rep_;
+    }
+    basic_string(const basic_string& rhs, const allocator_type& a) : alloc_base(a) {
+        if (rhs.is_long()) init_from(rhs.data(), 0, rhs.size());
+        else rep_ = rhs.rep_;
     }
 
-    static char_type* move(char_type* dst, const char_type* src, size_t n) noexcept {
-        return static_cast<char_type*>(std::memmove(dst, src, n));
+    basic_string(basic_string && rhs) noexcept
+    : alloc_base(rhs.get_allocator()), rep_(rhs.rep_) {
+        rhs.try_init();
     }
 
-    static char_type* fill(char_type* dst, char_type ch, size_t count) noexcept {
-        return static_cast<char_type*>(std::memset(dst, ch, count));
+    basic_string& operator=(const basic_string& rhs);
+    basic_string& operator=(basic_string&& rhs) noexcept(std::is_empty<Allocator>::value);
+
+    basic_string& operator=(const_pointer str);
+    basic_string& operator=(value_type ch);
+    basic_string& operator=(string_view_type str) {
+        return assign(str);
     }
-    
-}; // struct char_traits<char>
 
-// Partialized char_traits<wchar_t>
-template <>
-struct char_traits<wchar_t> {
-    
-    typedef wchar_t char_type;
+    ~basic_string() {
+        destory_buffer();
+    }
 
-    static size_t length(const char_type* str) noexcept {
-        return std::wcslen(str);
+public:
+    // Iterator operations
+    iterator                begin()         noexcept { return data(); }
+    const_iterator          begin()   const noexcept { return data(); }
+    iterator                end()           noexcept { return data() + size(); }
+    const_iterator          end()     const noexcept { return data() + size(); }
+
+    reverse_iterator        rbegin()        noexcept { return reverse_iterator(end()); }
+    const_reverse_iterator  rbegin()  const noexcept { return const_reverse_iterator(end()); }
+    reverse_iterator        rend()          noexcept { return reverse_iterator(begin()); }
+    const_reverse_iterator  rend()    const noexcept { return const_reverse_iterator(begin()); }
+
+    const_iterator          cbegin()  const noexcept { return begin(); }
+    const_iterator          cend()    const noexcept { return end(); }
+    const_reverse_iterator  crbegin() const noexcept { return rbegin(); }
+    const_reverse_iterator  crend()   const noexcept { return rend(); }
+
+    // Capacity operations
+    bool      empty()    const noexcept { return size() == 0; }
+    size_type size()     const noexcept { return is_long() ? rep_.l.size : tag(); }
+    size_type length()   const noexcept { return size(); }
+    size_type capacity() const noexcept {
+        return is_long() ? S_cap_decode(rep_.l.cap) : static_cast<size_type>(ESsoCapacity);
+    }
+    size_type max_size() const noexcept {
+        return S_cap_decode(static_cast<size_type>(-1)) / sizeof(value_type) - 1;
     }
 
-    static int compare(const char_type* s1, const char_type* s2, size_t n) noexcept {
-        return std::wmemcmp(s1, s2, n);
+    void reserve(size_type n);
+    void shrink_to_fit();
+
+    // Access elements operations
+    reference operator[](size_type n) {
+        SABERSTL_DEBUG(n <= size());
+        return data()[n];
+    }
+    const_reference operator[](size_type n) const {
+        SABERSTL_DEBUG(n <= size());
+        return data()[n];
     }
 
-    static char_type* copy(char_type* dst, const char_type* src, size_t n) noexcept {
-        SABERSTL_DEBUG(src + n <= dst || dst + n <= src);
-        return static_cast<char_type*>(std::wmemcpy(dst, src, n));
+    reference at(size_type n) {
+        THROW_OUT_OF_RANGE_IF(n >= size(), "basic_string<Char, Traits>::at() subscript out of range");
+        return (*this)[n];
+    }
+    const_reference at(size_type n) const {
+        THROW_OUT_OF_RANGE_IF(n >= size(), "basic_string<Char, Traits>::at() subscript out of range");
+        return (*this)[n];
     }
 
-    static char_type* move(char_type* dst, const char_type* src, size_t n) noexcept {
-        return static_cast<char_type*>(std::wmemmove(dst, src, n));
+    reference front() {
+        SABERSTL_DEBUG(!empty());
+        return *begin();
+    }
+    const_reference front() const {
+        SABERSTL_DEBUG(!empty());
+        return *begin();
     }
 
-    static char_type* fill(char_type* dst, char_type ch, size_t count) noexcept {
-        return static_cast<char_type*>(std::wmemset(dst, ch, count));
+    reference back() {
+        SABERSTL_DEBUG(!empty());
+        return *(end() - 1);
+    }
+    const_reference back() const {
+        SABERSTL_DEBUG(!empty());
+        return *(end() - 1);
     }
 
-}; // struct char_traits<wchar_t>
+    pointer       data()        noexcept { return is_long() ? rep_.l.buffer : rep_.s; }
+    const_pointer data()  const noexcept { return is_long() ? rep_.l.buffer : rep_.s; }
+    const_pointer c_str() const noexcept { return data(); }
 
-// Partialized char_traits<char16_t>
-template <>
-struct char_traits<char16_t> {
+    // A view of the characters, valid until the string is modified
+    operator string_view_type() const noexcept { return view(); }
 
-    typedef char16_t char_type;
+    // Modify the container, the buffer is kept
+    void clear() noexcept {
+        set_size(0);
+    }
 
-        static size_t length(const char_type* str) noexcept {
-        size_t len = 0;
-        for (; *str != char_type(0); str++) len++;
-        return len;
+    // assign
+    basic_string& assign(size_type count, value_type ch) {
+        return replace_fill(0, size(), count, ch);
+    }
+    basic_string& assign(const basic_string& str) {
+        return *this = str;
+    }
+    basic_string& assign(const basic_string& str, size_type pos, size_type count = npos) {
+        THROW_OUT_OF_RANGE_IF(pos > str.size(), "basic_string<Char, Traits>'s pos out of range");
+        return replace_cstr(0, size(), str.data() + pos, saberstl::min(count, str.size() - pos));
+    }
+    basic_string& assign(basic_string&& str) noexcept {
+        return *this = saberstl::move(str);
+    }
+    basic_string& assign(const_pointer str) {
+        return replace_cstr(0, size(), str, char_traits::length(str));
+    }
+    basic_string& assign(const_pointer str, size_type count) {
+        return replace_cstr(0, size(), str, count);
+    }
+    basic_string& assign(string_view_type str) {
+        return replace_cstr(0, size(), str.data(), str.size());
+    }
+    basic_string& assign(string_view_type str, size_type pos, size_type count = npos) {
+        return assign(str.substr(pos, count));
+    }
+    template <class Iter, typename std::enable_if<
+      saberstl::is_input_iterator<Iter>::value, int>::type = 0>
+    basic_string& assign(Iter first, Iter last) {
+        return replace_copy(0, size(), first, last);
     }
 
-    static int compare(const char_type* s1, const char_type* s2, size_t n) noexcept {
-        for (; n != 0; n--, s1++, s2++) {
-            if (*s1 < *s2) return -1;
-            if (*s1 > *s2) return 1;
-        }
-        return 0;
+    // push_back / pop_back
+    void push_back(value_type ch) {
+        const size_type n = size();
+        if (n == capacity()) reallocate(grow_capacity(n + 1));
+        data()[n] = ch;
+        set_size(n + 1);
+    }
+    void pop_back() {
+        SABERSTL_DEBUG(!empty());
+        set_size(size() - 1);
     }
 
-    static char_type* copy(char_type* dst, const char_type* src, size_t n) noexcept {
-        SABERSTL_DEBUG(src + n <= dst || dst + n <= src);
-        char_type* r = dst;
-        for (; n != 0; n--, dst++, src++) {
-            *dst = *src;
-        }
-        return r;
-    }
-
-    static char_type* move(char_type* dst, const char_type* src, size_t n) noexcept {
-        char_type* r = dst;
-        if (dst < src) {
-            for (; n != 0; n--, dst++, src++) 
-                *dst = *src;
-        } else if (src < dst) {
-            dst += n;
-            src += n;
-            for (; n != 0; n--) 
-                *--dst = *--src;
-        }
-        return r;
+    // append
+    basic_string& append(size_type count, value_type ch) {
+        return replace_fill(size(), 0, count, ch);
+    }
+    basic_string& append(const basic_string& str) {
+        return replace_cstr(size(), 0, str.data(), str.size());
+    }
+    basic_string& append(const basic_string& str, size_type pos, size_type count = npos) {
+        THROW_OUT_OF_RANGE_IF(pos > str.size(), "basic_string<Char, Traits>'s pos out of range");
+        return replace_cstr(size(), 0, str.data() + pos, saberstl::min(count, str.size() - pos));
+    }
+    basic_string& append(const_pointer str) {
+        return replace_cstr(size(), 0, str, char_traits::length(str));
     }
+    basic_string& append(const_pointer str, size_type count) {
+        return replace_cstr(size(), 0, str, count);
+    }
+    basic_string& append(string_view_type str) {
+        return replace_cstr(size(), 0, str.data(), str.size());
+    }
+    basic_string& append(string_view_type str, size_type pos, size_type count = npos) {
+        return append(str.substr(pos, count));
+    }
+    template <class Iter, typename std::enable_if<
+      saberstl::is_input_iterator<Iter>::value, int>::type = 0>
+    basic_string& append(Iter first, Iter last) {
+        return replace_copy(size(), 0, first, last);
+    }
+
+    basic_string& operator+=(const basic_string& str) { return append(str); }
+    basic_string& operator+=(value_type ch) { push_back(ch); return *this; }
+    basic_string& operator+=(const_pointer str) { return append(str); }
+    basic_string& operator+=(string_view_type str) { return append(str); }
 
-    static char_type* fill(char_type* dst, char_type ch, size_t count) noexcept {
-        char_type* r = dst;
-        for (; count > 0; count--, dst++) 
-            *dst = ch;
-        return r;
+    // insert
+    basic_string& insert(size_type pos, size_type count, value_type ch) {
+        THROW_OUT_OF_RANGE_IF(pos > size(), "basic_string<Char, Traits>'s pos out of range");
+        return replace_fill(pos, 0, count, ch);
+    }
+    basic_string& insert(size_type pos, const basic_string& str) {
+        THROW_OUT_OF_RANGE_IF(pos > size(), "basic_string<Char, Traits>'s pos out of range");
+        return replace_cstr(pos, 0, str.data(), str.size());
+    }
+    basic_string& insert(size_type pos, const_pointer str) {
+        THROW_OUT_OF_RANGE_IF(pos > size(), "basic_string<Char, Traits>'s pos out of range");
+        return replace_cstr(pos, 0, str, char_traits::length(str));
+    }
+    basic_string& insert(size_type pos, const_pointer str, size_type count) {
+        THROW_OUT_OF_RANGE_IF(pos > size(), "basic_string<Char, Traits>'s pos out of range");
+        return replace_cstr(pos, 0, str, count);
+    }
+    basic_string& insert(size_type pos, string_view_type str) {
+        THROW_OUT_OF_RANGE_IF(pos > size(), "basic_string<Char, Traits>'s pos out of range");
+        return replace_cstr(pos, 0, str.data(), str.size());
     }
 
-}; // struct char_traits<char16_t> 
+    iterator insert(const_iterator pos, value_type ch) {
+        const size_type n = pos - cbegin();
+        replace_fill(n, 0, 1, ch);
+        return begin() + n;
+    }
+    iterator insert(const_iterator pos, size_type count, value_type ch) {
+        const size_type n = pos - cbegin();
+        replace_fill(n, 0, count, ch);
+        return begin() + n;
+    }
+    template <class Iter, typename std::enable_if<
+      saberstl::is_input_iterator<Iter>::value, int>::type = 0>
+    iterator insert(const_iterator pos, Iter first, Iter last) {
+        const size_type n = pos - cbegin();
+        replace_copy(n, 0, first, last);
+        return begin() + n;
+    }
 
-// Partialized char_traits<char32_t>
-template <>
-struct char_traits<char32_t> {
+    // erase
+    basic_string& erase(size_type pos = 0, size_type count = npos) {
+        THROW_OUT_OF_RANGE_IF(pos > size(), "basic_string<Char, Traits>'s pos out of range");
+        make_room(pos, saberstl::min(count, size() - pos), 0);
+        return *this;
+    }
+    iterator erase(const_iterator pos) {
+        const size_type n = pos - cbegin();
+        make_room(n, 1, 0);
+        return begin() + n;
+    }
+    iterator erase(const_iterator first, const_iterator last) {
+        const size_type n = first - cbegin();
+        make_room(n, last - first, 0);
+        return begin() + n;
+    }
 
-    typedef char32_t char_type;
+    // replace, count is clamped to the end of string
+    basic_string& replace(size_type pos, size_type count, const basic_string& str) {
+        THROW_OUT_OF_RANGE_IF(pos > size(), "basic_string<Char, Traits>'s pos out of range");
+        return replace_cstr(pos, saberstl::min(count, size() - pos), str.data(), str.size());
+    }
+    basic_string& replace(size_type pos, size_type count, const basic_string& str,
+                          size_type pos2, size_type count2 = npos) {
+        THROW_OUT_OF_RANGE_IF(pos > size() || pos2 > str.size(),
+                              "basic_string<Char, Traits>'s pos out of range");
+        return replace_cstr(pos, saberstl::min(count, size() - pos), str.data() + pos2,
+                            saberstl::min(count2, str.size() - pos2));
+    }
+    basic_string& replace(size_type pos, size_type count, const_pointer str) {
+        THROW_OUT_OF_RANGE_IF(pos > size(), "basic_string<Char, Traits>'s pos out of range");
+        return replace_cstr(pos, saberstl::min(count, size() - pos), str, char_traits::length(str));
+    }
+    basic_string& replace(size_type pos, size_type count, const_pointer str, size_type count2) {
+        THROW_OUT_OF_RANGE_IF(pos > size(), "basic_string<Char, Traits>'s pos out of range");
+        return replace_cstr(pos, saberstl::min(count, size() - pos), str, count2);
+    }
+    basic_string& replace(size_type pos, size_type count, string_view_type str) {
+        THROW_OUT_OF_RANGE_IF(pos > size(), "basic_string<Char, Traits>'s pos out of range");
+        return replace_cstr(pos, saberstl::min(count, size() - pos), str.data(), str.size());
+    }
+    basic_string& replace(size_type pos, size_type count, size_type count2, value_type ch) {
+        THROW_OUT_OF_RANGE_IF(pos > size(), "basic_string<Char, Traits>'s pos out of range");
+        return replace_fill(pos, saberstl::min(count, size() - pos), count2, ch);
+    }
 
-        static size_t length(const char_type* str) noexcept {
-        size_t len = 0;
-        for (; *str != char_type(0); str++) len++;
-        return len;
+    basic_string& replace(const_iterator first, const_iterator last, const basic_string& str) {
+        return replace_cstr(first - cbegin(), last - first, str.data(), str.size());
+    }
+    basic_string& replace(const_iterator first, const_iterator last, const_pointer str) {
+        return replace_cstr(first - cbegin(), last - first, str, char_traits::length(str));
+    }
+    basic_string& replace(const_iterator first, const_iterator last, const_pointer str,
+                          size_type count) {
+        return replace_cstr(first - cbegin(), last - first, str, count);
+    }
+    basic_string& replace(const_iterator first, const_iterator last, string_view_type str) {
+        return replace_cstr(first - cbegin(), last - first, str.data(), str.size());
+    }
+    basic_string& replace(const_iterator first, const_iterator last, size_type count,
+                          value_type ch) {
+        return replace_fill(first - cbegin(), last - first, count, ch);
+    }
+    template <class Iter, typename std::enable_if<
+      saberstl::is_input_iterator<Iter>::value, int>::type = 0>
+    basic_string& replace(const_iterator first, const_iterator last, Iter first2, Iter last2) {
+        return replace_copy(first - cbegin(), last - first, first2, last2);
     }
 
-    static int compare(const char_type* s1, const char_type* s2, size_t n) noexcept {
-        for (; n != 0; n--, s1++, s2++) {
-            if (*s1 < *s2) return -1;
-            if (*s1 > *s2) return 1;
-        }
-        return 0;
+    // resize
+    void resize(size_type count) {
+        resize(count, value_type());
+    }
+    void resize(size_type count, value_type ch) {
+        const size_type n = size();
+        if (count < n) set_size(count);
+        else replace_fill(n, 0, count - n, ch);
     }
 
-    static char_type* copy(char_type* dst, const char_type* src, size_t n) noexcept {
-        SABERSTL_DEBUG(src + n <= dst || dst + n <= src);
-        char_type* r = dst;
-        for (; n != 0; n--, dst++, src++) {
-            *dst = *src;
-        }
-        return r;
-    }
-
-    static char_type* move(char_type* dst, const char_type* src, size_t n) noexcept {
-        char_type* r = dst;
-        if (dst < src) {
-            for (; n != 0; n--, dst++, src++) 
-                *dst = *src;
-        } else if (src < dst) {
-            dst += n;
-            src += n;
-            for (; n != 0; n--) 
-                *--dst = *--src;
-        }
-        return r;
+    // Let op write into [data(), data() + count) and keep the first r
+    // characters, r = op(data(), count) <= count. The characters past the
+    // old size are not initialized before op writes them.
+    template <class Operation>
+    void resize_and_overwrite(size_type count, Operation op) {
+        if (count > capacity()) reallocate(grow_capacity(count));
+        const size_type r = static_cast<size_type>(op(data(), count));
+        SABERSTL_DEBUG(r <= count);
+        set_size(r);
     }
 
-    static char_type* fill(char_type* dst, char_type ch, size_t count) noexcept {
-        char_type* r = dst;
-        for (; count > 0; count--, dst++) 
-            *dst = ch;
-        return r;
+    // substr / copy
+    basic_string substr(size_type pos = 0, size_type count = npos) const {
+        return basic_string(*this, pos, count, this->data_alloc());
+    }
+    size_type copy(pointer dest, size_type count, size_type pos = 0) const {
+        THROW_OUT_OF_RANGE_IF(pos > size(), "basic_string<Char, Traits>'s pos out of range");
+        count = saberstl::min(count, size() - pos);
+        char_traits::copy(dest, data() + pos, count);
+        return count;
     }
 
-}; // struct char_traits<char32_t> 
+    // find / rfind, npos for none, done by the view of the string
+    size_type find(value_type ch, size_type pos = 0) const noexcept {
+        return view().find(ch, pos);
+    }
+    size_type find(const_pointer str, size_type pos, size_type count) const noexcept {
+        return view().find(str, pos, count);
+    }
+    size_type find(const_pointer str, size_type pos = 0) const noexcept {
+        return view().find(str, pos);
+    }
+    size_type find(const basic_string& str, size_type pos = 0) const noexcept {
+        return view().find(str.view(), pos);
+    }
+    size_type find(string_view_type str, size_type pos = 0) const noexcept {
+        return view().find(str, pos);
+    }
 
-// Initialize the minimize buffer size of the basic_string 
-#define STRING_INTI_SIZE 32
+    size_type rfind(value_type ch, size_type pos = npos) const noexcept {
+        return view().rfind(ch, pos);
+    }
+    size_type rfind(const_pointer str, size_type pos, size_type count) const noexcept {
+        return view().rfind(str, pos, count);
+    }
+    size_type rfind(const_pointer str, size_type pos = npos) const noexcept {
+        return view().rfind(str, pos);
+    }
+    size_type rfind(const basic_string& str, size_type pos = npos) const noexcept {
+        return view().rfind(str.view(), pos);
+    }
+    size_type rfind(string_view_type str, size_type pos = npos) const noexcept {
+        return view().rfind(str, pos);
+    }
 
-// template class basic_string
-// Parameter 1 represents the type of string;
-// Parameter 2 represents the solution of extraction type of string, default using saberstl::char_traits
-template <class CharType, class CharTraits = saberstl::char_traits<CharType>>
-class basic_string {
-public:
-    typedef CharTraits                                  traits_type;
-    typedef CharTraits                                  char_traits;
+    // find_first_of / find_first_not_of, npos for none
+    size_type find_first_of(value_type ch, size_type pos = 0) const noexcept {
+        return view().find_first_of(ch, pos);
+    }
+    size_type find_first_of(const_pointer str, size_type pos, size_type count) const noexcept {
+        return view().find_first_of(str, pos, count);
+    }
+    size_type find_first_of(const_pointer str, size_type pos = 0) const noexcept {
+        return view().find_first_of(str, pos);
+    }
+    size_type find_first_of(const basic_string& str, size_type pos = 0) const noexcept {
+        return view().find_first_of(str.view(), pos);
+    }
+    size_type find_first_of(string_view_type str, size_type pos = 0) const noexcept {
+        return view().find_first_of(str, pos);
+    }
 
-    typedef saberstl::allocator<CharType>               allocator_type;
-    typedef saberstl::allocator<CharType>               data_allocator;
+    size_type find_first_not_of(value_type ch, size_type pos = 0) const noexcept {
+        return view().find_first_not_of(ch, pos);
+    }
+    size_type find_first_not_of(const_pointer str, size_type pos, size_type count) const noexcept {
+        return view().find_first_not_of(str, pos, count);
+    }
+    size_type find_first_not_of(const_pointer str, size_type pos = 0) const noexcept {
+        return view().find_first_not_of(str, pos);
+    }
+    size_type find_first_not_of(const basic_string& str, size_type pos = 0) const noexcept {
+        return view().find_first_not_of(str.view(), pos);
+    }
+    size_type find_first_not_of(string_view_type str, size_type pos = 0) const noexcept {
+        return view().find_first_not_of(str, pos);
+    }
 
-    typedef typename allocator_type::value_type         value_type;
-    typedef typename allocator_type::pointer            pointer;
-    typedef typename allocator_type::const_pointer      const_pointer;
-    typedef typename allocator_type::reference          reference;
-    typedef typename allocator_type::const_reference    const_reference;
-    typedef typename allocator_type::difference_type    difference_type;
+    // Compare two strings
+    int compare(const basic_string& other) const;
+    int compare(const_pointer str) const;
+    int compare(string_view_type str) const noexcept {
+        return view().compare(str);
+    }
+    int compare(size_type pos, size_type count, string_view_type str) const {
+        return view().compare(pos, count, str);
+    }
 
-    typedef value_type*                                 iterator;
-    typedef const value_type*                           const_iterator;
-    typedef saberstl::reverse_iterator<iterator>        reverse_iterator;
-    typedef saberstl::reverse_iterator<const_iterator>  const_reverser_iterator;
+    // Swap the representations and the allocators, no character is copied
+    void swap(basic_string& rhs) noexcept {
+        if (this != &rhs) {
+            rep tmp = rep_;
+            rep_ = rhs.rep_;
+            rhs.rep_ = tmp;
+            this->swap_alloc(rhs);
+        }
+    }
 
-    allocator_type get_allocator() {
-        return allocator_type();
+private:
+    string_view_type view() const noexcept {
+        return string_view_type(data(), size());
     }
 
-    static_assert(std::is_pod<CharType>::value, 
-                  "Character type of basic_string must be a POD");
-    static_assert(std::is_same<CharType, typename traits_type::char_type>::value,
-                  "Character must be same as traits_type::char_type");
+    // The tag is the last byte of the object
+    unsigned char tag() const noexcept {
+        return reinterpret_cast<const unsigned char*>(&rep_)[sizeof(long_rep) - 1];
+    }
+    unsigned char& tag() noexcept {
+        return reinterpret_cast<unsigned char*>(&rep_)[sizeof(long_rep) - 1];
+    }
 
-public:
-    // Handle the last point value, ex:
-    // if (str.find('a') != string::npos) { /* do something */ }
-    static constexpr size_type npos = static_cast<size_type>(-1);
+    // The allocator of a copy
+    template <class A>
+    static auto S_copy_alloc(const A& a, int) -> decltype(a.select_on_container_copy_construction()) {
+        return a.select_on_container_copy_construction();
+    }
+    template <class A>
+    static A S_copy_alloc(const A& a, long) {
+        return a;
+    }
 
-private:
-    iterator buffer_;   // Store the initial address of string
-    size_type size_;    // Store the size of string
-    size_type cap_;     // Store the capacity of string
+    // A buffer of one allocator can be freed by the other
+    bool same_alloc(const basic_string& rhs) const noexcept {
+        return std::is_empty<Allocator>::value || this->data_alloc() == rhs.data_alloc();
+    }
 
-public:
-    
-    basic_string() noexcept {
-        try_init();
+    bool is_long() const noexcept {
+        return (tag() & ELongTag) != 0;
     }
 
-    basic_string(size_type n, value_type ch) : buffer_(nullptr), size_(0), cap_(0) {
-        fill_init();
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    // The last byte of the capacity is its lowest one
+    static size_type S_cap_encode(size_type n) noexcept {
+        return n << 8 | ELongTag;
+    }
+    static size_type S_cap_decode(size_type cap) noexcept {
+        return cap >> 8;
     }
+#else
+    // The last byte of the capacity is its highest one
+    static size_type S_cap_encode(size_type n) noexcept {
+        return n | static_cast<size_type>(ELongTag) << (sizeof(size_type) * 8 - 8);
+    }
+    static size_type S_cap_decode(size_type cap) noexcept {
+        return cap & ~(static_cast<size_type>(ELongTag) << (sizeof(size_type) * 8 - 8));
+    }
+#endif
 
-    basic_string(const basic_string& other, size_type pos)
-    : buffer_(nullptr), size_(0), cap_(0) {
-        init_from(other.buffer_, pos, other.size_ - pos);
+    // Set the size and the end of string
+    void set_size(size_type n) noexcept {
+        if (is_long()) {
+            rep_.l.size = n;
+            rep_.l.buffer[n] = value_type();
+        } else {
+            set_short(n);
+        }
     }
-    basic_string(const basic_string& other, size_type pos, size_type count) 
-    : buffer_(nullptr), size_(0), cap_(0) {
-        init_from(other.buffer_, pos, count);
+
+    void set_short(size_type n) noexcept {
+        rep_.s[n] = value_type();
+        tag() = static_cast<unsigned char>(n);
     }
 
-    basic_string(const_pointer str) : buffer_(nullptr), size_(0), cap_(0) {
-        init_from(str, 0, char_traits::length(str));
+    void set_long(pointer buffer, size_type n, size_type cap) noexcept {
+        rep_.l.buffer = buffer;
+        rep_.l.size = n;
+        rep_.l.cap = S_cap_encode(cap);
+        buffer[n] = value_type();
     }
-    basic_string(const_pointer str, size_type count) 
-    : buffer_(nullptr), size_(0), cap_(0) {
-        init_from(str, 0, count);
+
+    // Init / Destroy
+    void try_init() noexcept;
+    pointer init_storage(size_type n);
+
+    void fill_init(size_type n, value_type ch);
+
+    void init_from(const_pointer src, size_type pos, size_type count);
+
+    template <class Iter>
+    void copy_init(Iter first, Iter last, saberstl::input_iterator_tag);
+    template <class Iter>
+    void copy_init(Iter first, Iter last, saberstl::forward_iterator_tag);
+
+    void destory_buffer() noexcept;
+
+    // Move the string to a new buffer on the heap of capacity new_cap
+    void reallocate(size_type new_cap);
+
+    // Replace the content with count characters from str
+    void copy_from(const_pointer str, size_type count);
+
+    // The capacity to grow to for need characters
+    size_type grow_capacity(size_type need) const;
+
+    // Replace count1 characters at pos with room for count2 ones
+    pointer make_room(size_type pos, size_type count1, size_type count2);
+
+    // Replace count1 characters at pos with others
+    basic_string& replace_cstr(size_type pos, size_type count1, const_pointer str, size_type count2);
+    basic_string& replace_fill(size_type pos, size_type count1, size_type count2, value_type ch);
+    template <class Iter>
+    basic_string& replace_copy(size_type pos, size_type count1, Iter first, Iter last);
+    void replace_inside(size_type pos, size_type count1, const_pointer str, size_type count2);
+
+    // Compare C-style strings
+    static int compare_cstr(const_pointer s1, size_type n1, const_pointer s2, size_type n2);
+
+};
+
+/*****************************************************************************************/
+
+template <class CharType, class CharTraits, class Allocator>
+constexpr typename basic_string<CharType, CharTraits, Allocator>::size_type
+basic_string<CharType, CharTraits, Allocator>::npos;
+
+// Copy assignment operator
+template <class CharType, class CharTraits, class Allocator>
+basic_string<CharType, CharTraits, Allocator>&
+basic_string<CharType, CharTraits, Allocator>::operator=(const basic_string& rhs) {
+    if (this != &rhs) {
+        if (!is_long() && !rhs.is_long()) rep_ = rhs.rep_;
+        else copy_from(rhs.data(), rhs.size());
     }
+    return *this;
+}
 
-    template <class Iter, typename std::enable_if<
-      saberstl::is_input_iterator<Iter>::value, int>::type = 0>
-    basic_string(Iter first, Iter last) {
-        copy_init(first, last, iterator_category(first));
+// Move assignment operator, the string keeps its allocator, so the
+// characters are copied when the buffer of rhs cannot be taken
+template <class CharType, class CharTraits, class Allocator>
+basic_string<CharType, CharTraits, Allocator>&
+basic_string<CharType, CharTraits, Allocator>::operator=(basic_string&& rhs)
+  noexcept(std::is_empty<Allocator>::value) {
+    if (this != &rhs) {
+        if (!same_alloc(rhs)) return *this = rhs;
+        destory_buffer();
+        rep_ = rhs.rep_;
+        rhs.try_init();
     }
+    return *this;
+}
 
-    basic_string(const basic_string& rhs) 
-    :buffer_(nullptr), size_(0), cap_(0) {
-        init_from(rhs.buffer_, 0, rhs.size_);
+// Assign a C-style string
+template <class CharType, class CharTraits, class Allocator>
+basic_string<CharType, CharTraits, Allocator>&
+basic_string<CharType, CharTraits, Allocator>::operator=(const_pointer str) {
+    copy_from(str, char_traits::length(str));
+    return *this;
+}
+
+// Assign a character
+template <class CharType, class CharTraits, class Allocator>
+basic_string<CharType, CharTraits, Allocator>&
+basic_string<CharType, CharTraits, Allocator>::operator=(value_type ch) {
+    copy_from(&ch, 1);
+    return *this;
+}
+
+// Reserve space for at least n characters, a reserve never shrinks
+template <class CharType, class CharTraits, class Allocator>
+void basic_string<CharType, CharTraits, Allocator>::reserve(size_type n) {
+    if (n > capacity()) reallocate(n);
+}
+
+// Release the unused space, a string short enough goes back into the object
+template <class CharType, class CharTraits, class Allocator>
+void basic_string<CharType, CharTraits, Allocator>::shrink_to_fit() {
+    if (!is_long()) return;
+    size_type n = rep_.l.size;
+    if (n <= ESsoCapacity) {
+        pointer old = rep_.l.buffer;
+        size_type old_cap = S_cap_decode(rep_.l.cap);
+        char_traits::copy(rep_.s, old, n);
+        set_short(n);
+        this->data_alloc().deallocate(old, old_cap + 1);
+    } else if (n < capacity()) {
+        reallocate(n);
     }
-        
-    basic_string(basic_string && rhs) noexcept
-    : buffer_(rhs.buffer_), size_(rhs.size_), cap_(rhs.cap_) {
-        rhs.buffer_ = nullptr;
-        rhs.size_ = 0;
-        rhs.cap_ = 0;
+}
+
+// Compare with another string
+template <class CharType, class CharTraits, class Allocator>
+int basic_string<CharType, CharTraits, Allocator>::compare(const basic_string& other) const {
+    return compare_cstr(data(), size(), other.data(), other.size());
+}
+
+// Compare with a C-style string
+template <class CharType, class CharTraits, class Allocator>
+int basic_string<CharType, CharTraits, Allocator>::compare(const_pointer str) const {
+    return compare_cstr(data(), size(), str, char_traits::length(str));
+}
+
+/*****************************************************************************************/
+// Helper functions
+
+// Initialize an empty short string
+template <class CharType, class CharTraits, class Allocator>
+void basic_string<CharType, CharTraits, Allocator>::try_init() noexcept {
+    set_short(0);
+}
+
+// Get the storage of n characters for a string under construction
+template <class CharType, class CharTraits, class Allocator>
+typename basic_string<CharType, CharTraits, Allocator>::pointer
+basic_string<CharType, CharTraits, Allocator>::init_storage(size_type n) {
+    if (n <= ESsoCapacity) {
+        set_short(n);
+        return rep_.s;
     }
+    THROW_LENGTH_ERROR_IF(n > max_size(), "basic_string<Char, Traits>'s size too big");
+    pointer buffer = this->data_alloc().allocate(n + 1);
+    set_long(buffer, n, n);
+    return buffer;
+}
 
-    basic_string& operator=(const basic_string& rhs);
-    basic_string& operator=(basic_string&& rhs) noexcept;
+// fill_init function
+template <class CharType, class CharTraits, class Allocator>
+void basic_string<CharType, CharTraits, Allocator>::fill_init(size_type n, value_type ch) {
+    char_traits::fill(init_storage(n), ch, n);
+}
 
-    basic_string& operator=(const_pointer str);
-    basic_string& operator=(value_type ch);
+// init_from function
+template <class CharType, class CharTraits, class Allocator>
+void basic_string<CharType, CharTraits, Allocator>::
+init_from(const_pointer src, size_type pos, size_type count) {
+    char_traits::copy(init_storage(count), src + pos, count);
+}
 
-    ~basic_string() {
+// copy_init function
+template <class CharType, class CharTraits, class Allocator>
+template <class Iter>
+void basic_string<CharType, CharTraits, Allocator>::
+copy_init(Iter first, Iter last, saberstl::input_iterator_tag) {
+    try_init();
+    try {
+        for (; first != last; ++first) push_back(*first);
+    } catch (...) {
         destory_buffer();
+        throw;
+    }
+}
+
+template <class CharType, class CharTraits, class Allocator>
+template <class Iter>
+void basic_string<CharType, CharTraits, Allocator>::
+copy_init(Iter first, Iter last, saberstl::forward_iterator_tag) {
+    const size_type n = saberstl::distance(first, last);
+    pointer p = init_storage(n);
+    for (; first != last; ++first, ++p) *p = *first;
+}
+
+// destory_buffer function, only a long string owns a buffer
+template <class CharType, class CharTraits, class Allocator>
+void basic_string<CharType, CharTraits, Allocator>::destory_buffer() noexcept {
+    if (is_long()) {
+        this->data_alloc().deallocate(rep_.l.buffer, S_cap_decode(rep_.l.cap) + 1);
+    }
+}
+
+// reallocate function
+template <class CharType, class CharTraits, class Allocator>
+void basic_string<CharType, CharTraits, Allocator>::reallocate(size_type new_cap) {
+    THROW_LENGTH_ERROR_IF(new_cap > max_size(), "basic_string<Char, Traits>'s size too big");
+    const size_type n = size();
+    pointer buffer = this->data_alloc().allocate(new_cap + 1);
+    char_traits::copy(buffer, data(), n);
+    destory_buffer();
+    set_long(buffer, n, new_cap);
+}
+
+// copy_from function, str may point into the string itself
+template <class CharType, class CharTraits, class Allocator>
+void basic_string<CharType, CharTraits, Allocator>::copy_from(const_pointer str, size_type count) {
+    if (count <= capacity()) {
+        char_traits::move(data(), str, count);
+        set_size(count);
+    } else {
+        basic_string tmp(str, count, this->data_alloc());
+        swap(tmp);
+    }
+}
+
+// grow_capacity function, the capacity at least doubles to keep appends amortized O(1)
+template <class CharType, class CharTraits, class Allocator>
+typename basic_string<CharType, CharTraits, Allocator>::size_type
+basic_string<CharType, CharTraits, Allocator>::grow_capacity(size_type need) const {
+    THROW_LENGTH_ERROR_IF(need > max_size(), "basic_string<Char, Traits>'s size too big");
+    const size_type old = capacity();
+    if (old > max_size() / 2) return max_size();
+    return saberstl::max(saberstl::max(need, old * 2), static_cast<size_type>(STRING_INTI_SIZE));
+}
+
+// make_room function, it only reallocates when the capacity is not enough
+template <class CharType, class CharTraits, class Allocator>
+typename basic_string<CharType, CharTraits, Allocator>::pointer
+basic_string<CharType, CharTraits, Allocator>::make_room(size_type pos, size_type count1, size_type count2) {
+    const size_type n = size();
+    const size_type tail = n - pos - count1;
+    THROW_LENGTH_ERROR_IF(count2 > max_size() - (n - count1),
+                          "basic_string<Char, Traits>'s size too big");
+    const size_type new_size = n - count1 + count2;
+    if (new_size <= capacity()) {
+        pointer p = data();
+        if (count1 != count2) char_traits::move(p + pos + count2, p + pos + count1, tail);
+        set_size(new_size);
+        return p + pos;
     }
+    const size_type new_cap = grow_capacity(new_size);
+    pointer buffer = this->data_alloc().allocate(new_cap + 1);
+    const_pointer old = data();
+    char_traits::copy(buffer, old, pos);
+    char_traits::copy(buffer + pos + count2, old + pos + count1, tail);
+    destory_buffer();
+    set_long(buffer, new_size, new_cap);
+    return buffer + pos;
+}
 
+// replace_cstr function, str may point into the string itself
+template <class CharType, class CharTraits, class Allocator>
+basic_string<CharType, CharTraits, Allocator>&
+basic_string<CharType, CharTraits, Allocator>::
+replace_cstr(size_type pos, size_type count1, const_pointer str, size_type count2) {
+    const_pointer p = data();
+    const size_type n = size();
+    if (str < p || str > p + n) {
+        char_traits::copy(make_room(pos, count1, count2), str, count2);
+        return *this;
+    }
+    THROW_LENGTH_ERROR_IF(count2 > max_size() - (n - count1),
+                          "basic_string<Char, Traits>'s size too big");
+    const size_type offset = str - p;
+    if (n - count1 + count2 > capacity()) reallocate(grow_capacity(n - count1 + count2));
+    replace_inside(pos, count1, data() + offset, count2);
+    return *this;
+}
+
+// replace_fill function
+template <class CharType, class CharTraits, class Allocator>
+basic_string<CharType, CharTraits, Allocator>&
+basic_string<CharType, CharTraits, Allocator>::
+replace_fill(size_type pos, size_type count1, size_type count2, value_type ch) {
+    char_traits::fill(make_room(pos, count1, count2), ch, count2);
+    return *this;
+}
+
+// replace_copy function, the range may point into the string, so it is copied first
+template <class CharType, class CharTraits, class Allocator>
+template <class Iter>
+basic_string<CharType, CharTraits, Allocator>&
+basic_string<CharType, CharTraits, Allocator>::
+replace_copy(size_type pos, size_type count1, Iter first, Iter last) {
+    const basic_string tmp(first, last, this->data_alloc());
+    return replace_cstr(pos, count1, tmp.data(), tmp.size());
+}
+
+// replace_inside function, str points into the string and the capacity is enough
+template <class CharType, class CharTraits, class Allocator>
+void basic_string<CharType, CharTraits, Allocator>::
+replace_inside(size_type pos, size_type count1, const_pointer str, size_type count2) {
+    const size_type new_size = size() - count1 + count2;
+    const size_type tail = size() - pos - count1;
+    pointer p = data() + pos;
+    if (count2 <= count1) {
+        char_traits::move(p, str, count2);
+        char_traits::move(p + count2, p + count1, tail);
+    } else {
+        // The tail moves first, the part of str in the tail moves with it
+        char_traits::move(p + count2, p + count1, tail);
+        if (str >= p + count1) {
+            char_traits::move(p, str + (count2 - count1), count2);
+        } else if (str + count2 > p + count1) {
+            const size_type k = p + count1 - str;
+            char_traits::move(p, str, k);
+            char_traits::move(p + k, p + count2, count2 - k);
+        } else {
+            char_traits::move(p, str, count2);
+        }
+    }
+    set_size(new_size);
+}
+
+// compare_cstr function
+template <class CharType, class CharTraits, class Allocator>
+int basic_string<CharType, CharTraits, Allocator>::
+compare_cstr(const_pointer s1, size_type n1, const_pointer s2, size_type n2) {
+    auto rlen = saberstl::min(n1, n2);
+    auto res = char_traits::compare(s1, s2, rlen);
+    if (res != 0) return res;
+    if (n1 < n2) return -1;
+    if (n1 > n2) return 1;
+    return 0;
+}
+
+/*****************************************************************************************/
+// Overload comparison operators
+
+template <class CharType, class CharTraits, class Allocator>
+bool operator==(const basic_string<CharType, CharTraits, Allocator>& lhs,
+                const basic_string<CharType, CharTraits, Allocator>& rhs) {
+    return lhs.size() == rhs.size() && lhs.compare(rhs) == 0;
+}
+
+template <class CharType, class CharTraits, class Allocator>
+bool operator==(const basic_string<CharType, CharTraits, Allocator>& lhs, const CharType* rhs) {
+    return lhs.compare(rhs) == 0;
+}
+
+template <class CharType, class CharTraits, class Allocator>
+bool operator==(const CharType* lhs, const basic_string<CharType, CharTraits, Allocator>& rhs) {
+    return rhs.compare(lhs) == 0;
+}
+
+template <class CharType, class CharTraits, class Allocator>
+bool operator!=(const basic_string<CharType, CharTraits, Allocator>& lhs,
+                const basic_string<CharType, CharTraits, Allocator>& rhs) {
+    return !(lhs == rhs);
+}
+
+template <class CharType, class CharTraits, class Allocator>
+bool operator!=(const basic_string<CharType, CharTraits, Allocator>& lhs, const CharType* rhs) {
+    return !(lhs == rhs);
+}
+
+template <class CharType, class CharTraits, class Allocator>
+bool operator!=(const CharType* lhs, const basic_string<CharType, CharTraits, Allocator>& rhs) {
+    return !(lhs == rhs);
+}
+
+template <class CharType, class CharTraits, class Allocator>
+bool operator<(const basic_string<CharType, CharTraits, Allocator>& lhs,
+               const basic_string<CharType, CharTraits, Allocator>& rhs) {
+    return lhs.compare(rhs) < 0;
+}
+
+template <class CharType, class CharTraits, class Allocator>
+bool operator<=(const basic_string<CharType, CharTraits, Allocator>& lhs,
+                const basic_string<CharType, CharTraits, Allocator>& rhs) {
+    return lhs.compare(rhs) <= 0;
+}
+
+template <class CharType, class CharTraits, class Allocator>
+bool operator>(const basic_string<CharType, CharTraits, Allocator>& lhs,
+               const basic_string<CharType, CharTraits, Allocator>& rhs) {
+    return lhs.compare(rhs) > 0;
+}
+
+template <class CharType, class CharTraits, class Allocator>
+bool operator>=(const basic_string<CharType, CharTraits, Allocator>& lhs,
+                const basic_string<CharType, CharTraits, Allocator>& rhs) {
+    return lhs.compare(rhs) >= 0;
+}
+
+// Overload operator+
+// The result of two lvalues is reserved at once, and an rvalue operand is
+// reused, so a chain such as a + b + c + d builds only one string. A new
+// result takes the allocator of the string operand, the left one of two.
+template <class CharType, class CharTraits, class Allocator>
+basic_string<CharType, CharTraits, Allocator>
+operator+(const basic_string<CharType, CharTraits, Allocator>& lhs,
+          const basic_string<CharType, CharTraits, Allocator>& rhs) {
+    basic_string<CharType, CharTraits, Allocator> result(lhs.get_allocator());
+    result.reserve(lhs.size() + rhs.size());
+    result.append(lhs).append(rhs);
+    return result;
+}
+
+template <class CharType, class CharTraits, class Allocator>
+basic_string<CharType, CharTraits, Allocator>
+operator+(const CharType* lhs, const basic_string<CharType, CharTraits, Allocator>& rhs) {
+    const size_t n = CharTraits::length(lhs);
+    basic_string<CharType, CharTraits, Allocator> result(rhs.get_allocator());
+    result.reserve(n + rhs.size());
+    result.append(lhs, n).append(rhs);
+    return result;
+}
+
+template <class CharType, class CharTraits, class Allocator>
+basic_string<CharType, CharTraits, Allocator>
+operator+(CharType ch, const basic_string<CharType, CharTraits, Allocator>& rhs) {
+    basic_string<CharType, CharTraits, Allocator> result(rhs.get_allocator());
+    result.reserve(1 + rhs.size());
+    result.push_back(ch);
+    result.append(rhs);
+    return result;
+}
+
+template <class CharType, class CharTraits, class Allocator>
+basic_string<CharType, CharTraits, Allocator>
+operator+(const basic_string<CharType, CharTraits, Allocator>& lhs, const CharType* rhs) {
+    const size_t n = CharTraits::length(rhs);
+    basic_string<CharType, CharTraits, Allocator> result(lhs.get_allocator());
+    result.reserve(lhs.size() + n);
+    result.append(lhs).append(rhs, n);
+    return result;
+}
+
+template <class CharType, class CharTraits, class Allocator>
+basic_string<CharType, CharTraits, Allocator>
+operator+(const basic_string<CharType, CharTraits, Allocator>& lhs, CharType ch) {
+    basic_string<CharType, CharTraits, Allocator> result(lhs.get_allocator());
+    result.reserve(lhs.size() + 1);
+    result.append(lhs);
+    result.push_back(ch);
+    return result;
+}
+
+template <class CharType, class CharTraits, class Allocator>
+basic_string<CharType, CharTraits, Allocator>
+operator+(basic_string<CharType, CharTraits, Allocator>&& lhs,
+          const basic_string<CharType, CharTraits, Allocator>& rhs) {
+    return saberstl::move(lhs.append(rhs));
+}
+
+template <class CharType, class CharTraits, class Allocator>
+basic_string<CharType, CharTraits, Allocator>
+operator+(const basic_string<CharType, CharTraits, Allocator>& lhs,
+          basic_string<CharType, CharTraits, Allocator>&& rhs) {
+    return saberstl::move(rhs.insert(0, lhs));
+}
+
+// Keep the operand whose buffer is large enough
+template <class CharType, class CharTraits, class Allocator>
+basic_string<CharType, CharTraits, Allocator>
+operator+(basic_string<CharType, CharTraits, Allocator>&& lhs,
+          basic_string<CharType, CharTraits, Allocator>&& rhs) {
+    const size_t n = lhs.size() + rhs.size();
+    if (n > lhs.capacity() && n <= rhs.capacity()) return saberstl::move(rhs.insert(0, lhs));
+    return saberstl::move(lhs.append(rhs));
+}
+
+template <class CharType, class CharTraits, class Allocator>
+basic_string<CharType, CharTraits, Allocator>
+operator+(basic_string<CharType, CharTraits, Allocator>&& lhs, const CharType* rhs) {
+    return saberstl::move(lhs.append(rhs));
+}
+
+template <class CharType, class CharTraits, class Allocator>
+basic_string<CharType, CharTraits, Allocator>
+operator+(basic_string<CharType, CharTraits, Allocator>&& lhs, CharType ch) {
+    lhs.push_back(ch);
+    return saberstl::move(lhs);
+}
+
+template <class CharType, class CharTraits, class Allocator>
+basic_string<CharType, CharTraits, Allocator>
+operator+(const CharType* lhs, basic_string<CharType, CharTraits, Allocator>&& rhs) {
+    return saberstl::move(rhs.insert(0, lhs));
+}
+
+template <class CharType, class CharTraits, class Allocator>
+basic_string<CharType, CharTraits, Allocator>
+operator+(CharType ch, basic_string<CharType, CharTraits, Allocator>&& rhs) {
+    return saberstl::move(rhs.insert(static_cast<size_t>(0), 1, ch));
+}
+
+// Overload saberstl swap
+template <class CharType, class CharTraits, class Allocator>
+void swap(basic_string<CharType, CharTraits, Allocator>& lhs,
+          basic_string<CharType, CharTraits, Allocator>& rhs) noexcept {
+    lhs.swap(rhs);
+}
+
+// Output the string
+template <class CharType, class CharTraits, class Allocator>
+std::basic_ostream<CharType>& operator<<(std::basic_ostream<CharType>& os,
+                                         const basic_string<CharType, CharTraits, Allocator>& str) {
+    return os.write(str.data(), static_cast<std::streamsize>(str.size()));
+}
+
+// Overload hash, same as the hash of its view
+template <class CharType, class CharTraits, class Allocator>
+struct hash<basic_string<CharType, CharTraits, Allocator>> {
+    size_t operator()(const basic_string<CharType, CharTraits, Allocator>& str) const noexcept {
+        return hash<basic_string_view<CharType, CharTraits>>()(str);
+    }
 };
 
+typedef basic_string<char>      string;
+typedef basic_string<wchar_t>   wstring;
+typedef basic_string<char16_t>  u16string;
+typedef basic_string<char32_t>  u32string;
+
 } // namespace saberstl
 
-#endif // SABERSTL_BASIC_STRING_H
\ No newline at end of file
+#endif // SABERSTL_BASIC_STRING_H
@@ -0,0 +1,413 @@
+#ifndef SABERSTL_CHAR_SIMD_H
+#define SABERSTL_CHAR_SIMD_H
+
+/*
+ * This header file contains the class char_simd, the SIMD kernels behind
+ * char_traits and the find functions of basic_string for the characters
+ * of 1, 2 and 4 bytes. It picks AVX2 at runtime when the CPU has it, SSE2
+ * otherwise on x86, and scalar loops elsewhere. Define SABERSTL_SIMD_NO_AVX2
+ * in every translation unit to stay on SSE2.
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+#define SABERSTL_SIMD_SSE2
+#ifndef SABERSTL_SIMD_NO_AVX2
+#define SABERSTL_SIMD_AVX2
+#endif
+#include <immintrin.h>
+#endif
+
+namespace saberstl {
+
+/* Most characters of a set searched with SIMD, a larger set is scanned */
+enum { ESimdSetMax = 16 };
+
+/*
+ * class char_simd
+ * Every kernel compares a block of characters at once and turns the result
+ * into a bit mask with movemask, one bit for each byte, so the index of a
+ * character is the index of its first bit divided by its size. The blocks
+ * are loaded unaligned, except in length(), which must not cross into a
+ * page past the end and so reads aligned blocks only.
+*/
+class char_simd {
+private:
+    template <size_t W>
+    using width = std::integral_constant<size_t, W>;
+
+public:
+    /* The first ch in [s, s + n), nullptr for none */
+    template <class T>
+    static const T* find(const T* s, size_t n, T ch) noexcept {
+#ifdef SABERSTL_SIMD_AVX2
+        if (S_has_avx2()) return S_find_avx2(s, n, ch);
+#endif
+#ifdef SABERSTL_SIMD_SSE2
+        return S_find_sse2(s, n, ch);
+#else
+        for (size_t i = 0; i < n; i++) {
+            if (s[i] == ch) return s + i;
+        }
+        return nullptr;
+#endif
+    }
+
+    /* The last ch in [s, s + n), nullptr for none */
+    template <class T>
+    static const T* rfind(const T* s, size_t n, T ch) noexcept {
+#ifdef SABERSTL_SIMD_AVX2
+        if (S_has_avx2()) return S_rfind_avx2(s, n, ch);
+#endif
+#ifdef SABERSTL_SIMD_SSE2
+        return S_rfind_sse2(s, n, ch);
+#else
+        while (n > 0) {
+            if (s[--n] == ch) return s + n;
+        }
+        return nullptr;
+#endif
+    }
+
+    /*
+     * The first character in [s, s + n) which is in [set, set + m) if in
+     * is true, or which is not if in is false. nullptr for none.
+    */
+    template <class T>
+    static const T* find_of(const T* s, size_t n, const T* set, size_t m, bool in) noexcept {
+        if (m == 0) return in || n == 0 ? nullptr : s;
+        if (m > static_cast<size_t>(ESimdSetMax)) return S_find_of_scalar(s, n, set, m, in);
+#ifdef SABERSTL_SIMD_AVX2
+        if (S_has_avx2()) return S_find_of_avx2(s, n, set, m, in);
+#endif
+#ifdef SABERSTL_SIMD_SSE2
+        return S_find_of_sse2(s, n, set, m, in);
+#else
+        return S_find_of_scalar(s, n, set, m, in);
+#endif
+    }
+
+    /* The number of characters before the first zero */
+    template <class T>
+    static size_t length(const T* s) noexcept {
+#ifdef SABERSTL_SIMD_AVX2
+        if (S_has_avx2()) return S_length_avx2(s);
+#endif
+#ifdef SABERSTL_SIMD_SSE2
+        return S_length_sse2(s);
+#else
+        size_t len = 0;
+        for (; s[len] != T(0); len++) {}
+        return len;
+#endif
+    }
+
+    /* Compare n characters by their values */
+    template <class T>
+    static int compare(const T* s1, const T* s2, size_t n) noexcept {
+        size_t i = S_mismatch(s1, s2, n);
+        if (i == n) return 0;
+        return s1[i] < s2[i] ? -1 : 1;
+    }
+
+    template <class T>
+    static T* fill(T* dst, T ch, size_t n) noexcept {
+#ifdef SABERSTL_SIMD_AVX2
+        if (S_has_avx2()) return S_fill_avx2(dst, ch, n);
+#endif
+#ifdef SABERSTL_SIMD_SSE2
+        return S_fill_sse2(dst, ch, n);
+#else
+        for (size_t i = 0; i < n; i++) dst[i] = ch;
+        return dst;
+#endif
+    }
+
+private:
+    template <class T>
+    static size_t S_mismatch(const T* s1, const T* s2, size_t n) noexcept {
+#ifdef SABERSTL_SIMD_AVX2
+        if (S_has_avx2()) return S_mismatch_avx2(s1, s2, n);
+#endif
+#ifdef SABERSTL_SIMD_SSE2
+        return S_mismatch_sse2(s1, s2, n);
+#else
+        size_t i = 0;
+        for (; i < n && s1[i] == s2[i]; i++) {}
+        return i;
+#endif
+    }
+
+    /* Check every character against the set, with a table for bytes */
+    template <class T>
+    static const T* S_find_of_scalar(const T* s, size_t n, const T* set, size_t m, bool in) noexcept {
+        if (sizeof(T) == 1) {
+            bool table[256] = {};
+            for (size_t j = 0; j < m; j++) table[static_cast<unsigned char>(set[j])] = true;
+            for (size_t i = 0; i < n; i++) {
+                if (table[static_cast<unsigned char>(s[i])] == in) return s + i;
+            }
+            return nullptr;
+        }
+        for (size_t i = 0; i < n; i++) {
+            if ((find(set, m, s[i]) != nullptr) == in) return s + i;
+        }
+        return nullptr;
+    }
+
+#ifdef SABERSTL_SIMD_SSE2
+    static unsigned S_ctz(unsigned mask) noexcept { return __builtin_ctz(mask); }
+    static unsigned S_last_bit(unsigned mask) noexcept { return 31 - __builtin_clz(mask); }
+
+    static __m128i S_set1_128(uint32_t c, width<1>) noexcept { return _mm_set1_epi8(static_cast<char>(c)); }
+    static __m128i S_set1_128(uint32_t c, width<2>) noexcept { return _mm_set1_epi16(static_cast<short>(c)); }
+    static __m128i S_set1_128(uint32_t c, width<4>) noexcept { return _mm_set1_epi32(static_cast<int>(c)); }
+
+    static __m128i S_eq_128(__m128i a, __m128i b, width<1>) noexcept { return _mm_cmpeq_epi8(a, b); }
+    static __m128i S_eq_128(__m128i a, __m128i b, width<2>) noexcept { return _mm_cmpeq_epi16(a, b); }
+    static __m128i S_eq_128(__m128i a, __m128i b, width<4>) noexcept { return _mm_cmpeq_epi32(a, b); }
+
+    /* The bytes of the characters equal to c in the block at s */
+    template <class T>
+    static unsigned S_match_128(const T* s, __m128i c) noexcept {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+        return static_cast<unsigned>(_mm_movemask_epi8(S_eq_128(v, c, width<sizeof(T)>())));
+    }
+
+    template <class T>
+    static const T* S_find_sse2(const T* s, size_t n, T ch) noexcept {
+        const size_t lanes = 16 / sizeof(T);
+        const __m128i c = S_set1_128(static_cast<uint32_t>(ch), width<sizeof(T)>());
+        size_t i = 0;
+        for (; i + lanes <= n; i += lanes) {
+            unsigned mask = S_match_128(s + i, c);
+            if (mask != 0) return s + i + S_ctz(mask) / sizeof(T);
+        }
+        for (; i < n; i++) {
+            if (s[i] == ch) return s + i;
+        }
+        return nullptr;
+    }
+
+    template <class T>
+    static const T* S_rfind_sse2(const T* s, size_t n, T ch) noexcept {
+        const size_t lanes = 16 / sizeof(T);
+        const __m128i c = S_set1_128(static_cast<uint32_t>(ch), width<sizeof(T)>());
+        while (n >= lanes) {
+            n -= lanes;
+            unsigned mask = S_match_128(s + n, c);
+            if (mask != 0) return s + n + S_last_bit(mask) / sizeof(T);
+        }
+        while (n > 0) {
+            if (s[--n] == ch) return s + n;
+        }
+        return nullptr;
+    }
+
+    template <class T>
+    static const T* S_find_of_sse2(const T* s, size_t n, const T* set, size_t m, bool in) noexcept {
+        const size_t lanes = 16 / sizeof(T);
+        __m128i c[ESimdSetMax];
+        for (size_t j = 0; j < m; j++) {
+            c[j] = S_set1_128(static_cast<uint32_t>(set[j]), width<sizeof(T)>());
+        }
+        const unsigned flip = in ? 0u : 0xFFFFu;
+        size_t i = 0;
+        for (; i + lanes <= n; i += lanes) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i));
+            __m128i hit = S_eq_128(v, c[0], width<sizeof(T)>());
+            for (size_t j = 1; j < m; j++) {
+                hit = _mm_or_si128(hit, S_eq_128(v, c[j], width<sizeof(T)>()));
+            }
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(hit)) ^ flip;
+            if (mask != 0) return s + i + S_ctz(mask) / sizeof(T);
+        }
+        return S_find_of_scalar(s + i, n - i, set, m, in);
+    }
+
+    /* The bytes of the null characters in the aligned block at s, which may
+       pass the end of the object but never the page */
+    template <class T>
+    __attribute__((no_sanitize_address))
+    static unsigned S_zeros_128(const T* s) noexcept {
+        __m128i v = _mm_load_si128(reinterpret_cast<const __m128i*>(s));
+        return static_cast<unsigned>(_mm_movemask_epi8(
+            S_eq_128(v, _mm_setzero_si128(), width<sizeof(T)>())));
+    }
+
+    /* Read aligned blocks from the one holding s, the bytes before s are masked off */
+    template <class T>
+    static size_t S_length_sse2(const T* s) noexcept {
+        const uintptr_t offset = reinterpret_cast<uintptr_t>(s) & 15;
+        const T* p = reinterpret_cast<const T*>(reinterpret_cast<const char*>(s) - offset);
+        unsigned mask = S_zeros_128(p) & (0xFFFFu << offset);
+        while (mask == 0) {
+            p += 16 / sizeof(T);
+            mask = S_zeros_128(p);
+        }
+        return p + S_ctz(mask) / sizeof(T) - s;
+    }
+
+    template <class T>
+    static size_t S_mismatch_sse2(const T* s1, const T* s2, size_t n) noexcept {
+        const size_t lanes = 16 / sizeof(T);
+        size_t i = 0;
+        for (; i + lanes <= n; i += lanes) {
+            __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s1 + i));
+            __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s2 + i));
+            unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+                S_eq_128(a, b, width<sizeof(T)>()))) ^ 0xFFFFu;
+            if (mask != 0) return i + S_ctz(mask) / sizeof(T);
+        }
+        for (; i < n && s1[i] == s2[i]; i++) {}
+        return i;
+    }
+
+    template <class T>
+    static T* S_fill_sse2(T* dst, T ch, size_t n) noexcept {
+        const size_t lanes = 16 / sizeof(T);
+        const __m128i c = S_set1_128(static_cast<uint32_t>(ch), width<sizeof(T)>());
+        size_t i = 0;
+        for (; i + lanes <= n; i += lanes) {
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), c);
+        }
+        for (; i < n; i++) dst[i] = ch;
+        return dst;
+    }
+#endif // SABERSTL_SIMD_SSE2
+
+#ifdef SABERSTL_SIMD_AVX2
+    static bool S_has_avx2() noexcept {
+        static const bool avx2 = []() -> bool {
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") != 0;
+        }();
+        return avx2;
+    }
+
+    __attribute__((target("avx2")))
+    static __m256i S_set1_256(uint32_t c, width<1>) noexcept { return _mm256_set1_epi8(static_cast<char>(c)); }
+    __attribute__((target("avx2")))
+    static __m256i S_set1_256(uint32_t c, width<2>) noexcept { return _mm256_set1_epi16(static_cast<short>(c)); }
+    __attribute__((target("avx2")))
+    static __m256i S_set1_256(uint32_t c, width<4>) noexcept { return _mm256_set1_epi32(static_cast<int>(c)); }
+
+    __attribute__((target("avx2")))
+    static __m256i S_eq_256(__m256i a, __m256i b, width<1>) noexcept { return _mm256_cmpeq_epi8(a, b); }
+    __attribute__((target("avx2")))
+    static __m256i S_eq_256(__m256i a, __m256i b, width<2>) noexcept { return _mm256_cmpeq_epi16(a, b); }
+    __attribute__((target("avx2")))
+    static __m256i S_eq_256(__m256i a, __m256i b, width<4>) noexcept { return _mm256_cmpeq_epi32(a, b); }
+
+    template <class T>
+    __attribute__((target("avx2")))
+    static unsigned S_match_256(const T* s, __m256i c) noexcept {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s));
+        return static_cast<unsigned>(_mm256_movemask_epi8(S_eq_256(v, c, width<sizeof(T)>())));
+    }
+
+    template <class T>
+    __attribute__((target("avx2")))
+    static const T* S_find_avx2(const T* s, size_t n, T ch) noexcept {
+        const size_t lanes = 32 / sizeof(T);
+        const __m256i c = S_set1_256(static_cast<uint32_t>(ch), width<sizeof(T)>());
+        size_t i = 0;
+        for (; i + lanes <= n; i += lanes) {
+            unsigned mask = S_match_256(s + i, c);
+            if (mask != 0) return s + i + S_ctz(mask) / sizeof(T);
+        }
+        return S_find_sse2(s + i, n - i, ch);
+    }
+
+    template <class T>
+    __attribute__((target("avx2")))
+    static const T* S_rfind_avx2(const T* s, size_t n, T ch) noexcept {
+        const size_t lanes = 32 / sizeof(T);
+        const __m256i c = S_set1_256(static_cast<uint32_t>(ch), width<sizeof(T)>());
+        while (n >= lanes) {
+            n -= lanes;
+            unsigned mask = S_match_256(s + n, c);
+            if (mask != 0) return s + n + S_last_bit(mask) / sizeof(T);
+        }
+        return S_rfind_sse2(s, n, ch);
+    }
+
+    template <class T>
+    __attribute__((target("avx2")))
+    static const T* S_find_of_avx2(const T* s, size_t n, const T* set, size_t m, bool in) noexcept {
+        const size_t lanes = 32 / sizeof(T);
+        __m256i c[ESimdSetMax];
+        for (size_t j = 0; j < m; j++) {
+            c[j] = S_set1_256(static_cast<uint32_t>(set[j]), width<sizeof(T)>());
+        }
+        const unsigned flip = in ? 0u : 0xFFFFFFFFu;
+        size_t i = 0;
+        for (; i + lanes <= n; i += lanes) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i));
+            __m256i hit = S_eq_256(v, c[0], width<sizeof(T)>());
+            for (size_t j = 1; j < m; j++) {
+                hit = _mm256_or_si256(hit, S_eq_256(v, c[j], width<sizeof(T)>()));
+            }
+            unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(hit)) ^ flip;
+            if (mask != 0) return s + i + S_ctz(mask) / sizeof(T);
+        }
+        return S_find_of_sse2(s + i, n - i, set, m, in);
+    }
+
+    template <class T>
+    __attribute__((target("avx2"), no_sanitize_address))
+    static unsigned S_zeros_256(const T* s) noexcept {
+        __m256i v = _mm256_load_si256(reinterpret_cast<const __m256i*>(s));
+        return static_cast<unsigned>(_mm256_movemask_epi8(
+            S_eq_256(v, _mm256_setzero_si256(), width<sizeof(T)>())));
+    }
+
+    template <class T>
+    __attribute__((target("avx2")))
+    static size_t S_length_avx2(const T* s) noexcept {
+        const uintptr_t offset = reinterpret_cast<uintptr_t>(s) & 31;
+        const T* p = reinterpret_cast<const T*>(reinterpret_cast<const char*>(s) - offset);
+        unsigned mask = S_zeros_256(p) & (0xFFFFFFFFu << offset);
+        while (mask == 0) {
+            p += 32 / sizeof(T);
+            mask = S_zeros_256(p);
+        }
+        return p + S_ctz(mask) / sizeof(T) - s;
+    }
+
+    template <class T>
+    __attribute__((target("avx2")))
+    static size_t S_mismatch_avx2(const T* s1, const T* s2, size_t n) noexcept {
+        const size_t lanes = 32 / sizeof(T);
+        size_t i = 0;
+        for (; i + lanes <= n; i += lanes) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s1 + i));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s2 + i));
+            unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(
+                S_eq_256(a, b, width<sizeof(T)>()))) ^ 0xFFFFFFFFu;
+            if (mask != 0) return i + S_ctz(mask) / sizeof(T);
+        }
+        return i + S_mismatch_sse2(s1 + i, s2 + i, n - i);
+    }
+
+    template <class T>
+    __attribute__((target("avx2")))
+    static T* S_fill_avx2(T* dst, T ch, size_t n) noexcept {
+        const size_t lanes = 32 / sizeof(T);
+        const __m256i c = S_set1_256(static_cast<uint32_t>(ch), width<sizeof(T)>());
+        size_t i = 0;
+        for (; i + lanes <= n; i += lanes) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), c);
+        }
+        S_fill_sse2(dst + i, ch, n - i);
+        return dst;
+    }
+#endif // SABERSTL_SIMD_AVX2
+};
+
+} // namespace saberstl
+
+#endif // !SABERSTL_CHAR_SIMD_H
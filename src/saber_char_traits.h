@@ -0,0 +1,276 @@
+#ifndef SABERSTL_CHAR_TRAITS_H
+#define SABERSTL_CHAR_TRAITS_H
+
+// Template Struct: char_traits, shared by basic_string and basic_string_view
+
+#include <cstddef>
+#include <cstring>
+#include <cwchar>
+
+#include "saber_char_simd.h"
+#include "saber_execptdef.h"
+
+namespace saberstl {
+
+// char_traits
+// Beside the standard members, find, rfind and find_of serve the find
+// functions of basic_string. The specializations use the C library or the
+// SIMD kernels of char_simd.
+
+template <class CharType>
+struct char_traits {
+    typedef CharType char_type;
+
+    static size_t length(const char_type* str) {
+        size_t len = 0;
+        for (; *str != char_type(0); str++) len++;
+        return len;
+    }
+
+    static int compare(const char_type* s1, const char_type* s2, size_t n) {
+        for (; n != 0; n--, s1++, s2++) {
+            if (*s1 < *s2) return -1;
+            if (*s1 > *s2) return 1;
+        }
+        return 0;
+    }
+
+    static char_type* copy(char_type* dst, const char_type* src, size_t n) {
+        SABERSTL_DEBUG(src + n <= dst || dst + n <= src);
+        char_type* r = dst;
+        for (; n != 0; n--, dst++, src++) {
+            *dst = *src;
+        }
+        return r;
+    }
+
+    static char_type* move(char_type* dst, const char_type* src, size_t n) {
+        char_type* r = dst;
+        if (dst < src) {
+            for (; n != 0; n--, dst++, src++) 
+                *dst = *src;
+        } else if (src < dst) {
+            dst += n;
+            src += n;
+            for (; n != 0; n--) 
+                *--dst = *--src;
+        }
+        return r;
+    }
+
+    static char_type* fill(char_type* dst, char_type ch, size_t count) {
+        char_type* r = dst;
+        for (; count > 0; count--, dst++) 
+            *dst = ch;
+        return r;
+    }
+
+    // The first ch in [str, str + n), nullptr for none
+    static const char_type* find(const char_type* str, size_t n, char_type ch) {
+        for (; n != 0; n--, str++) {
+            if (*str == ch) return str;
+        }
+        return nullptr;
+    }
+
+    // The last ch in [str, str + n), nullptr for none
+    static const char_type* rfind(const char_type* str, size_t n, char_type ch) {
+        while (n != 0) {
+            if (str[--n] == ch) return str + n;
+        }
+        return nullptr;
+    }
+
+    // The first character in (in = true) or not in (in = false) [set, set + m)
+    static const char_type* find_of(const char_type* str, size_t n,
+                                    const char_type* set, size_t m, bool in) {
+        for (; n != 0; n--, str++) {
+            if ((find(set, m, *str) != nullptr) == in) return str;
+        }
+        return nullptr;
+    }
+}; // struct char_traits
+
+// Partialized char_traits<char>
+template <>
+struct char_traits<char> {
+
+    typedef char char_type;
+
+    static size_t length(const char_type* str) noexcept {
+        return std::strlen(str);
+    }
+
+    static int compare(const char_type* s1, const char_type* s2, size_t n) noexcept {
+        if (n == 0) return 0;
+        return std::memcmp(s1, s2, n);
+    }
+
+    static char_type* copy(char_type* dst, const char_type* src, size_t n) noexcept {
+        if (n == 0) return dst;
+        SABERSTL_DEBUG(src + n <= dst || dst + n <= src);
+        return static_cast<char_type*>(std::memcpy(dst, src, n));
+    }
+
+    static char_type* move(char_type* dst, const char_type* src, size_t n) noexcept {
+        if (n == 0) return dst;
+        return static_cast<char_type*>(std::memmove(dst, src, n));
+    }
+
+    static char_type* fill(char_type* dst, char_type ch, size_t count) noexcept {
+        return static_cast<char_type*>(std::memset(dst, ch, count));
+    }
+
+    static const char_type* find(const char_type* str, size_t n, char_type ch) noexcept {
+        if (n == 0) return nullptr;
+        return static_cast<const char_type*>(std::memchr(str, ch, n));
+    }
+
+    static const char_type* rfind(const char_type* str, size_t n, char_type ch) noexcept {
+        return char_simd::rfind(str, n, ch);
+    }
+
+    static const char_type* find_of(const char_type* str, size_t n,
+                                    const char_type* set, size_t m, bool in) noexcept {
+        return char_simd::find_of(str, n, set, m, in);
+    }
+    
+}; // struct char_traits<char>
+
+// Partialized char_traits<wchar_t>
+template <>
+struct char_traits<wchar_t> {
+    
+    typedef wchar_t char_type;
+
+    static size_t length(const char_type* str) noexcept {
+        return std::wcslen(str);
+    }
+
+    static int compare(const char_type* s1, const char_type* s2, size_t n) noexcept {
+        if (n == 0) return 0;
+        return std::wmemcmp(s1, s2, n);
+    }
+
+    static char_type* copy(char_type* dst, const char_type* src, size_t n) noexcept {
+        if (n == 0) return dst;
+        SABERSTL_DEBUG(src + n <= dst || dst + n <= src);
+        return static_cast<char_type*>(std::wmemcpy(dst, src, n));
+    }
+
+    static char_type* move(char_type* dst, const char_type* src, size_t n) noexcept {
+        if (n == 0) return dst;
+        return static_cast<char_type*>(std::wmemmove(dst, src, n));
+    }
+
+    static char_type* fill(char_type* dst, char_type ch, size_t count) noexcept {
+        return static_cast<char_type*>(std::wmemset(dst, ch, count));
+    }
+
+    static const char_type* find(const char_type* str, size_t n, char_type ch) noexcept {
+        if (n == 0) return nullptr;
+        return std::wmemchr(str, ch, n);
+    }
+
+    static const char_type* rfind(const char_type* str, size_t n, char_type ch) noexcept {
+        return char_simd::rfind(str, n, ch);
+    }
+
+    static const char_type* find_of(const char_type* str, size_t n,
+                                    const char_type* set, size_t m, bool in) noexcept {
+        return char_simd::find_of(str, n, set, m, in);
+    }
+
+}; // struct char_traits<wchar_t>
+
+// Partialized char_traits<char16_t>
+template <>
+struct char_traits<char16_t> {
+
+    typedef char16_t char_type;
+
+    static size_t length(const char_type* str) noexcept {
+        return char_simd::length(str);
+    }
+
+    static int compare(const char_type* s1, const char_type* s2, size_t n) noexcept {
+        return char_simd::compare(s1, s2, n);
+    }
+
+    static char_type* copy(char_type* dst, const char_type* src, size_t n) noexcept {
+        if (n == 0) return dst;
+        SABERSTL_DEBUG(src + n <= dst || dst + n <= src);
+        return static_cast<char_type*>(std::memcpy(dst, src, n * sizeof(char_type)));
+    }
+
+    static char_type* move(char_type* dst, const char_type* src, size_t n) noexcept {
+        if (n == 0) return dst;
+        return static_cast<char_type*>(std::memmove(dst, src, n * sizeof(char_type)));
+    }
+
+    static char_type* fill(char_type* dst, char_type ch, size_t count) noexcept {
+        return char_simd::fill(dst, ch, count);
+    }
+
+    static const char_type* find(const char_type* str, size_t n, char_type ch) noexcept {
+        return char_simd::find(str, n, ch);
+    }
+
+    static const char_type* rfind(const char_type* str, size_t n, char_type ch) noexcept {
+        return char_simd::rfind(str, n, ch);
+    }
+
+    static const char_type* find_of(const char_type* str, size_t n,
+                                    const char_type* set, size_t m, bool in) noexcept {
+        return char_simd::find_of(str, n, set, m, in);
+    }
+
+}; // struct char_traits<char16_t> 
+
+// Partialized char_traits<char32_t>
+template <>
+struct char_traits<char32_t> {
+
+    typedef char32_t char_type;
+
+    static size_t length(const char_type* str) noexcept {
+        return char_simd::length(str);
+    }
+
+    static int compare(const char_type* s1, const char_type* s2, size_t n) noexcept {
+        return char_simd::compare(s1, s2, n);
+    }
+
+    static char_type* copy(char_type* dst, const char_type* src, size_t n) noexcept {
+        if (n == 0) return dst;
+        SABERSTL_DEBUG(src + n <= dst || dst + n <= src);
+        return static_cast<char_type*>(std::memcpy(dst, src, n * sizeof(char_type)));
+    }
+
+    static char_type* move(char_type* dst, const char_type* src, size_t n) noexcept {
+        if (n == 0) return dst;
+        return static_cast<char_type*>(std::memmove(dst, src, n * sizeof(char_type)));
+    }
+
+    static char_type* fill(char_type* dst, char_type ch, size_t count) noexcept {
+        return char_simd::fill(dst, ch, count);
+    }
+
+    static const char_type* find(const char_type* str, size_t n, char_type ch) noexcept {
+        return char_simd::find(str, n, ch);
+    }
+
+    static const char_type* rfind(const char_type* str, size_t n, char_type ch) noexcept {
+        return char_simd::rfind(str, n, ch);
+    }
+
+    static const char_type* find_of(const char_type* str, size_t n,
+                                    const char_type* set, size_t m, bool in) noexcept {
+        return char_simd::find_of(str, n, set, m, in);
+    }
+
+}; // struct char_traits<char32_t>
+
+} // namespace saberstl
+
+#endif // !SABERSTL_CHAR_TRAITS_H
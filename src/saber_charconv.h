@@ -0,0 +1,765 @@
+#ifndef SABERSTL_CHARCONV_H
+#define SABERSTL_CHARCONV_H
+
+// Functions: to_chars, from_chars, append_chars, to_string
+//
+// Conversions between numbers and text that never allocate and do not
+// depend on the locale. The integers are written two digits at a time from
+// a table of digit pairs. The floating point numbers are written with the
+// fewest digits that read back to the same value, found by the algorithm
+// of Ryu (Ulf Adams, 2018), in the shorter of the fixed and the scientific
+// forms like std::to_chars.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <limits>
+#include <system_error>
+#include <type_traits>
+
+#include "saber_basic_string.h"
+
+namespace saberstl {
+
+// The results of to_chars and from_chars, ec is std::errc() on success
+struct to_chars_result {
+    char* ptr;
+    std::errc ec;
+};
+
+struct from_chars_result {
+    const char* ptr;
+    std::errc ec;
+};
+
+// Most characters written for a number, with the sign
+enum { EMaxIntegerChars = 66, EMaxDoubleChars = 24 };
+
+// class charconv
+// The kernels behind the free functions.
+class charconv {
+public:
+    // A decimal number, digits * 10^exponent
+    // A decimal number, digits * 10^exponent, and the binary number it
+    // stands for, mantissa * 2^binary_exponent
+    struct decimal {
+        uint64_t digits;
+        int exponent;
+        uint64_t mantissa;
+        int binary_exponent;
+    };
+
+    // Number of decimal digits of v, at least 1
+    static unsigned digits10(uint64_t v) noexcept {
+        unsigned n = 1;
+        for (;;) {
+            if (v < 10) return n;
+            if (v < 100) return n + 1;
+            if (v < 1000) return n + 2;
+            if (v < 10000) return n + 3;
+            v /= 10000;
+            n += 4;
+        }
+    }
+
+    // Write the len digits of v at first, len == digits10(v)
+    template <class UInt>
+    static void write_digits(char* first, UInt v, unsigned len) noexcept {
+        char* p = first + len;
+        while (v >= 100) {
+            const unsigned i = static_cast<unsigned>(v % 100) * 2;
+            v /= 100;
+            p -= 2;
+            std::memcpy(p, S_digit_pairs() + i, 2);
+        }
+        if (v >= 10) {
+            std::memcpy(p - 2, S_digit_pairs() + static_cast<unsigned>(v) * 2, 2);
+        } else {
+            p[-1] = static_cast<char>('0' + v);
+        }
+    }
+
+    // The shortest decimal that reads back to the double or float of the
+    // bits, which must be finite and not zero
+    static decimal shortest(uint64_t bits, unsigned mantissa_bits, unsigned exponent_bits) noexcept;
+
+    // Write d in the shorter of the fixed and the scientific forms, nullptr if it does not fit
+    static char* write_decimal(char* first, char* last, decimal d) noexcept;
+
+private:
+    static unsigned S_exact_integer(const decimal& d, char* end) noexcept;
+
+    static const char* S_digit_pairs() noexcept {
+        return "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+               "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+               "8081828384858687888990919293949596979899";
+    }
+
+    /*********************************************************************************/
+    // The tables of Ryu: 5^i and 2^k / 5^i cut to EPow5Bits bits, in two
+    // words each. They are computed once from big integers instead of being
+    // spelled out.
+
+    enum { EPow5Bits = 125, EPow5InvBits = 125 };
+    enum { EPow5Count = 326, EPow5InvCount = 342 };
+
+    struct tables {
+        uint64_t pow5[EPow5Count][2];
+        uint64_t pow5_inv[EPow5InvCount][2];
+        tables() noexcept;
+    };
+
+    static const tables& S_tables() noexcept {
+        static const tables t;
+        return t;
+    }
+
+    // A small unsigned big integer in 32-bit limbs, enough for 2^1024
+    struct big {
+        enum { ELimbs = 34 };
+        uint32_t limb[ELimbs];
+        unsigned size;
+
+        explicit big(uint32_t v) noexcept : limb(), size(1) { limb[0] = v; }
+
+        void mul_small(uint32_t m) noexcept {
+            uint64_t carry = 0;
+            for (unsigned i = 0; i < size; i++) {
+                carry += static_cast<uint64_t>(limb[i]) * m;
+                limb[i] = static_cast<uint32_t>(carry);
+                carry >>= 32;
+            }
+            if (carry != 0) limb[size++] = static_cast<uint32_t>(carry);
+        }
+        // Divide by d, return the remainder
+        uint32_t div_small(uint32_t d) noexcept {
+            uint64_t rem = 0;
+            for (unsigned i = size; i-- > 0;) {
+                rem = (rem << 32) | limb[i];
+                limb[i] = static_cast<uint32_t>(rem / d);
+                rem %= d;
+            }
+            while (size > 1 && limb[size - 1] == 0) size--;
+            return static_cast<uint32_t>(rem);
+        }
+        bool is_zero() const noexcept { return size == 1 && limb[0] == 0; }
+        unsigned bit_length() const noexcept {
+            unsigned n = (size - 1) * 32;
+            for (uint32_t top = limb[size - 1]; top != 0; top >>= 1) n++;
+            return n;
+        }
+        // The low 128 bits of this >> shift
+        void bits_at(unsigned shift, uint64_t out[2]) const noexcept {
+            out[0] = out[1] = 0;
+            for (unsigned b = 0; b < 128; b += 32) {
+                const unsigned pos = shift + b;
+                const unsigned i = pos / 32, off = pos % 32;
+                uint64_t w = i < size ? limb[i] : 0;
+                if (off != 0 && i + 1 < size) w |= static_cast<uint64_t>(limb[i + 1]) << 32;
+                const uint32_t part = static_cast<uint32_t>(w >> off);
+                out[b / 64] |= static_cast<uint64_t>(part) << (b % 64);
+            }
+        }
+    };
+
+    /*********************************************************************************/
+
+    // ceil(log2(5^e)), 1 for e == 0, 0 <= e <= 3528
+    static int S_pow5_bits(int e) noexcept {
+        return static_cast<int>((static_cast<uint32_t>(e) * 1217359) >> 19) + 1;
+    }
+    // floor(log10(2^e)), 0 <= e <= 1650
+    static int S_log10_pow2(int e) noexcept {
+        return static_cast<int>((static_cast<uint32_t>(e) * 78913) >> 18);
+    }
+    // floor(log10(5^e)), 0 <= e <= 2620
+    static int S_log10_pow5(int e) noexcept {
+        return static_cast<int>((static_cast<uint32_t>(e) * 732923) >> 20);
+    }
+
+    static unsigned S_pow5_factor(uint64_t v) noexcept {
+        unsigned count = 0;
+        while (v % 5 == 0) {
+            v /= 5;
+            count++;
+        }
+        return count;
+    }
+
+    // The high 64 bits of a * b, the low ones go to lo
+    static uint64_t S_mul128(uint64_t a, uint64_t b, uint64_t& lo) noexcept {
+#if defined(__SIZEOF_INT128__)
+        __extension__ typedef unsigned __int128 uint128;
+        const uint128 p = static_cast<uint128>(a) * b;
+        lo = static_cast<uint64_t>(p);
+        return static_cast<uint64_t>(p >> 64);
+#else
+        const uint64_t a0 = static_cast<uint32_t>(a), a1 = a >> 32;
+        const uint64_t b0 = static_cast<uint32_t>(b), b1 = b >> 32;
+        const uint64_t p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+        const uint64_t mid = (p00 >> 32) + static_cast<uint32_t>(p01) + static_cast<uint32_t>(p10);
+        lo = (mid << 32) | static_cast<uint32_t>(p00);
+        return p11 + (mid >> 32) + (p01 >> 32) + (p10 >> 32);
+#endif
+    }
+
+    // (m * mul) >> j for 64 < j < 128
+    static uint64_t S_mul_shift(uint64_t m, const uint64_t* mul, int j) noexcept {
+        uint64_t lo0, lo1;
+        const uint64_t hi0 = S_mul128(m, mul[0], lo0);
+        uint64_t hi1 = S_mul128(m, mul[1], lo1);
+        const uint64_t sum = hi0 + lo1;
+        if (sum < hi0) hi1++;
+        const int dist = j - 64;
+        return (hi1 << (64 - dist)) | (sum >> dist);
+    }
+};
+
+/*****************************************************************************************/
+
+inline charconv::tables::tables() noexcept {
+    // pow5[i] is 5^i with EPow5Bits bits
+    big p(1);
+    for (int i = 0; i < EPow5Count; i++) {
+        const int bits = static_cast<int>(p.bit_length());
+        if (bits >= EPow5Bits) {
+            p.bits_at(bits - EPow5Bits, pow5[i]);
+        } else {
+            uint64_t v[2];
+            p.bits_at(0, v);
+            const int sh = EPow5Bits - bits;
+            pow5[i][1] = sh >= 64 ? v[0] << (sh - 64) : (v[1] << sh) | (sh == 0 ? 0 : v[0] >> (64 - sh));
+            pow5[i][0] = sh >= 64 ? 0 : v[0] << sh;
+        }
+        p.mul_small(5);
+    }
+    // pow5_inv[i] is floor(2^(pow5_bits(i) - 1 + EPow5InvBits) / 5^i) + 1, cut from
+    // floor(2^1024 / 5^i), which is divided by 5 once per step
+    enum { ETop = 1024 };
+    big q(0);
+    q.size = ETop / 32 + 1;
+    q.limb[ETop / 32] = 1;
+    for (int i = 0; i < EPow5InvCount; i++) {
+        const int shift = ETop - (S_pow5_bits(i) - 1 + EPow5InvBits);
+        q.bits_at(shift, pow5_inv[i]);
+        if (++pow5_inv[i][0] == 0) pow5_inv[i][1]++;
+        q.div_small(5);
+    }
+}
+
+// Ryu: scale the value and the halfway points to its neighbours by a power
+// of 10 with the tables, then drop the digits while the interval between
+// the halfway points still holds a number
+inline charconv::decimal
+charconv::shortest(uint64_t bits, unsigned mantissa_bits, unsigned exponent_bits) noexcept {
+    const tables& t = S_tables();
+    const int bias = (1 << (exponent_bits - 1)) - 1;
+    const uint64_t ieee_mantissa = bits & ((static_cast<uint64_t>(1) << mantissa_bits) - 1);
+    const unsigned ieee_exponent = static_cast<unsigned>(
+        (bits >> mantissa_bits) & ((1u << exponent_bits) - 1));
+
+    int e2;
+    uint64_t m2;
+    if (ieee_exponent == 0) {
+        e2 = 1 - bias - static_cast<int>(mantissa_bits) - 2;
+        m2 = ieee_mantissa;
+    } else {
+        e2 = static_cast<int>(ieee_exponent) - bias - static_cast<int>(mantissa_bits) - 2;
+        m2 = (static_cast<uint64_t>(1) << mantissa_bits) | ieee_mantissa;
+    }
+    const bool accept_bounds = (m2 & 1) == 0;
+
+    // The value and its neighbours are mv, mp = mv + 2 and mm = mv - 1 - mm_shift, times 2^e2
+    const uint64_t mv = 4 * m2;
+    const unsigned mm_shift = ieee_mantissa != 0 || ieee_exponent <= 1;
+
+    uint64_t vr, vp, vm;
+    int e10;
+    bool vm_trailing_zeros = false, vr_trailing_zeros = false;
+    if (e2 >= 0) {
+        const int q = S_log10_pow2(e2) - (e2 > 3);
+        e10 = q;
+        const int k = EPow5InvBits + S_pow5_bits(q) - 1;
+        const int i = -e2 + q + k;
+        vr = S_mul_shift(4 * m2, t.pow5_inv[q], i);
+        vp = S_mul_shift(4 * m2 + 2, t.pow5_inv[q], i);
+        vm = S_mul_shift(4 * m2 - 1 - mm_shift, t.pow5_inv[q], i);
+        if (q <= 21) {
+            // Only one of mp, mv and mm can be a multiple of 5
+            if (mv % 5 == 0) {
+                vr_trailing_zeros = S_pow5_factor(mv) >= static_cast<unsigned>(q);
+            } else if (accept_bounds) {
+                vm_trailing_zeros = S_pow5_factor(mv - 1 - mm_shift) >= static_cast<unsigned>(q);
+            } else {
+                vp -= S_pow5_factor(mv + 2) >= static_cast<unsigned>(q);
+            }
+        }
+    } else {
+        const int q = S_log10_pow5(-e2) - (-e2 > 1);
+        e10 = q + e2;
+        const int i = -e2 - q;
+        const int k = S_pow5_bits(i) - EPow5Bits;
+        const int j = q - k;
+        vr = S_mul_shift(4 * m2, t.pow5[i], j);
+        vp = S_mul_shift(4 * m2 + 2, t.pow5[i], j);
+        vm = S_mul_shift(4 * m2 - 1 - mm_shift, t.pow5[i], j);
+        if (q <= 1) {
+            // mv has at least q trailing binary zeros
+            vr_trailing_zeros = true;
+            if (accept_bounds) vm_trailing_zeros = mm_shift == 1;
+            else --vp;
+        } else if (q < 63) {
+            vr_trailing_zeros = (mv & ((static_cast<uint64_t>(1) << q) - 1)) == 0;
+        }
+    }
+
+    // Drop the digits that the interval does not need
+    int removed = 0;
+    unsigned last_removed = 0;
+    uint64_t output;
+    if (vm_trailing_zeros || vr_trailing_zeros) {
+        while (vp / 10 > vm / 10) {
+            vm_trailing_zeros &= vm % 10 == 0;
+            vr_trailing_zeros &= last_removed == 0;
+            last_removed = static_cast<unsigned>(vr % 10);
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        if (vm_trailing_zeros) {
+            while (vm % 10 == 0) {
+                vr_trailing_zeros &= last_removed == 0;
+                last_removed = static_cast<unsigned>(vr % 10);
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+                removed++;
+            }
+        }
+        // Round half to even when the dropped digits are exactly 5000...
+        if (vr_trailing_zeros && last_removed == 5 && vr % 2 == 0) last_removed = 4;
+        output = vr + ((vr == vm && (!accept_bounds || !vm_trailing_zeros)) || last_removed >= 5);
+    } else {
+        bool round_up = false;
+        while (vp / 10 > vm / 10) {
+            round_up = vr % 10 >= 5;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+        output = vr + (vr == vm || round_up);
+    }
+    decimal d;
+    d.digits = output;
+    d.exponent = e10 + removed;
+    d.mantissa = m2;
+    d.binary_exponent = e2 + 2;
+    return d;
+}
+
+// Fixed form when it is not longer than the scientific one, like std::to_chars
+inline char* charconv::write_decimal(char* first, char* last, decimal d) noexcept {
+    const int len = static_cast<int>(digits10(d.digits));
+    const int sci_exp = d.exponent + len - 1;
+    const int abs_exp = sci_exp < 0 ? -sci_exp : sci_exp;
+    const int sci_len = len + (len > 1) + 2 + (abs_exp >= 100 ? 3 : 2);
+    int fixed_len;
+    if (d.exponent >= 0) fixed_len = len + d.exponent;
+    else if (len + d.exponent > 0) fixed_len = len + 1;
+    else fixed_len = 2 - d.exponent;
+
+    if (fixed_len <= sci_len) {
+        // Like printf, an integer in the fixed form has all its exact digits
+        // instead of zeros after the shortest ones
+        char exact[32];
+        if (d.exponent > 0) fixed_len = static_cast<int>(S_exact_integer(d, exact + sizeof(exact)));
+        if (last - first < fixed_len) return nullptr;
+        if (d.exponent > 0) {
+            std::memcpy(first, exact + sizeof(exact) - fixed_len, fixed_len);
+        } else if (d.exponent == 0) {
+            write_digits(first, d.digits, len);
+        } else if (len + d.exponent > 0) {
+            // The point goes inside the digits
+            const int int_len = len + d.exponent;
+            write_digits(first + 1, d.digits, len);
+            std::memmove(first, first + 1, int_len);
+            first[int_len] = '.';
+        } else {
+            first[0] = '0';
+            first[1] = '.';
+            std::memset(first + 2, '0', -(len + d.exponent));
+            write_digits(first + 2 - (len + d.exponent), d.digits, len);
+        }
+        return first + fixed_len;
+    }
+
+    if (last - first < sci_len) return nullptr;
+    write_digits(first + 1, d.digits, len);
+    first[0] = first[1];
+    char* p = first + 1;
+    if (len > 1) {
+        first[1] = '.';
+        p = first + len + 1;
+    }
+    *p++ = 'e';
+    *p++ = sci_exp < 0 ? '-' : '+';
+    if (abs_exp >= 100) {
+        *p++ = static_cast<char>('0' + abs_exp / 100);
+        std::memcpy(p, S_digit_pairs() + (abs_exp % 100) * 2, 2);
+    } else {
+        std::memcpy(p, S_digit_pairs() + abs_exp * 2, 2);
+    }
+    return first + sci_len;
+}
+
+// Write the digits of the integer d stands for backwards from end, return their number
+inline unsigned charconv::S_exact_integer(const decimal& d, char* end) noexcept {
+    big b(static_cast<uint32_t>(d.mantissa));
+    b.limb[1] = static_cast<uint32_t>(d.mantissa >> 32);
+    if (b.limb[1] != 0) b.size = 2;
+    for (int e = d.binary_exponent; e > 0; e -= 31) {
+        b.mul_small(1u << (e < 31 ? e : 31));
+    }
+    for (int e = -d.binary_exponent; e > 0; e -= 31) {
+        b.div_small(1u << (e < 31 ? e : 31));
+    }
+    char* p = end;
+    do {
+        *--p = static_cast<char>('0' + b.div_small(10));
+    } while (!b.is_zero());
+    return static_cast<unsigned>(end - p);
+}
+
+/*****************************************************************************************/
+// to_chars
+
+// Integers in base 10 by default, or in base 2 to 36 with lower case letters
+template <class Int, typename std::enable_if<
+  std::is_integral<Int>::value && !std::is_same<Int, bool>::value, int>::type = 0>
+to_chars_result to_chars(char* first, char* last, Int value, int base = 10) noexcept {
+    typedef typename std::make_unsigned<Int>::type UInt;
+    SABERSTL_DEBUG(base >= 2 && base <= 36);
+    UInt u = static_cast<UInt>(value);
+    if (value < 0) {
+        if (first == last) return { last, std::errc::value_too_large };
+        *first++ = '-';
+        u = static_cast<UInt>(0) - u;
+    }
+    if (base == 10) {
+        const unsigned len = charconv::digits10(u);
+        if (last - first < static_cast<ptrdiff_t>(len)) return { last, std::errc::value_too_large };
+        // Divide 32-bit numbers in 32 bits
+        if (sizeof(UInt) > 4 && u <= 0xFFFFFFFFu) charconv::write_digits(first, static_cast<uint32_t>(u), len);
+        else charconv::write_digits(first, u, len);
+        return { first + len, std::errc() };
+    }
+    char buf[sizeof(UInt) * 8];
+    char* p = buf + sizeof(buf);
+    do {
+        const unsigned digit = static_cast<unsigned>(u % static_cast<unsigned>(base));
+        *--p = "0123456789abcdefghijklmnopqrstuvwxyz"[digit];
+        u /= static_cast<unsigned>(base);
+    } while (u != 0);
+    const ptrdiff_t len = buf + sizeof(buf) - p;
+    if (last - first < len) return { last, std::errc::value_too_large };
+    std::memcpy(first, p, len);
+    return { first + len, std::errc() };
+}
+
+to_chars_result to_chars(char*, char*, bool, int = 10) = delete;
+
+// The shortest text that from_chars reads back to the same value
+inline to_chars_result to_chars(char* first, char* last, double value) noexcept {
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const bool sign = (bits >> 63) != 0;
+    const uint64_t mantissa = bits & ((static_cast<uint64_t>(1) << 52) - 1);
+    const unsigned exponent = static_cast<unsigned>((bits >> 52) & 0x7FF);
+    char* p = first;
+    if (sign) {
+        if (p == last) return { last, std::errc::value_too_large };
+        *p++ = '-';
+    }
+    if (exponent == 0x7FF) {
+        const char* text = mantissa != 0 ? "nan" : "inf";
+        if (last - p < 3) return { last, std::errc::value_too_large };
+        std::memcpy(p, text, 3);
+        return { p + 3, std::errc() };
+    }
+    if (exponent == 0 && mantissa == 0) {
+        if (p == last) return { last, std::errc::value_too_large };
+        *p = '0';
+        return { p + 1, std::errc() };
+    }
+    char* end = charconv::write_decimal(p, last, charconv::shortest(bits, 52, 11));
+    if (end == nullptr) return { last, std::errc::value_too_large };
+    return { end, std::errc() };
+}
+
+inline to_chars_result to_chars(char* first, char* last, float value) noexcept {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const bool sign = (bits >> 31) != 0;
+    const uint32_t mantissa = bits & ((1u << 23) - 1);
+    const unsigned exponent = (bits >> 23) & 0xFF;
+    char* p = first;
+    if (sign) {
+        if (p == last) return { last, std::errc::value_too_large };
+        *p++ = '-';
+    }
+    if (exponent == 0xFF) {
+        const char* text = mantissa != 0 ? "nan" : "inf";
+        if (last - p < 3) return { last, std::errc::value_too_large };
+        std::memcpy(p, text, 3);
+        return { p + 3, std::errc() };
+    }
+    if (exponent == 0 && mantissa == 0) {
+        if (p == last) return { last, std::errc::value_too_large };
+        *p = '0';
+        return { p + 1, std::errc() };
+    }
+    char* end = charconv::write_decimal(p, last, charconv::shortest(bits, 23, 8));
+    if (end == nullptr) return { last, std::errc::value_too_large };
+    return { end, std::errc() };
+}
+
+/*****************************************************************************************/
+// from_chars
+
+// An optional '-' then digits in base, no prefix; value is kept unless it succeeds
+template <class Int, typename std::enable_if<
+  std::is_integral<Int>::value && !std::is_same<Int, bool>::value, int>::type = 0>
+from_chars_result from_chars(const char* first, const char* last, Int& value, int base = 10) noexcept {
+    typedef typename std::make_unsigned<Int>::type UInt;
+    SABERSTL_DEBUG(base >= 2 && base <= 36);
+    const char* p = first;
+    bool neg = false;
+    if (std::is_signed<Int>::value && p != last && *p == '-') {
+        neg = true;
+        p++;
+    }
+    const char* digits = p;
+    UInt u = 0;
+    bool overflow = false;
+    const UInt max_div = static_cast<UInt>(-1) / static_cast<UInt>(base);
+    const unsigned max_mod = static_cast<unsigned>(static_cast<UInt>(-1) % static_cast<UInt>(base));
+    for (; p != last; p++) {
+        unsigned digit;
+        const unsigned char c = static_cast<unsigned char>(*p);
+        if (c >= '0' && c <= '9') digit = c - '0';
+        else if (c >= 'a' && c <= 'z') digit = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'Z') digit = c - 'A' + 10;
+        else break;
+        if (digit >= static_cast<unsigned>(base)) break;
+        if (u > max_div || (u == max_div && digit > max_mod)) overflow = true;
+        u = static_cast<UInt>(u * static_cast<UInt>(base) + digit);
+    }
+    if (p == digits) return { first, std::errc::invalid_argument };
+    if (overflow) return { p, std::errc::result_out_of_range };
+    if (std::is_signed<Int>::value) {
+        const UInt limit = static_cast<UInt>(static_cast<UInt>(-1) >> 1) + (neg ? 1 : 0);
+        if (u > limit) return { p, std::errc::result_out_of_range };
+        value = neg ? static_cast<Int>(static_cast<UInt>(0) - u) : static_cast<Int>(u);
+    } else {
+        value = static_cast<Int>(u);
+    }
+    return { p, std::errc() };
+}
+
+// class float_parser
+// Reads [-]digits[.digits][(e|E)[+|-]digits], inf, infinity or nan in any
+// case. Up to 19 digits whose value and power of 10 are exact in T are
+// scaled by one multiplication or division, which rounds correctly; the
+// rest are given to strtod or strtof as digits and an exponent without a
+// point, so the locale does not matter. Those digits are kept in a buffer
+// on the stack: past EMaxParseDigits they are dropped, and a last digit 1
+// stands for any nonzero one among them, which decides the rounding the
+// same way as all of them would.
+class float_parser {
+public:
+    // Significant digits given to strtod, more than the 767 a double may need
+    enum { EMaxParseDigits = 800 };
+
+    template <class T>
+    static from_chars_result parse(const char* first, const char* last, T& value) noexcept;
+
+private:
+    static double S_strto(const char* s, char** end, double) noexcept { return std::strtod(s, end); }
+    static float S_strto(const char* s, char** end, float) noexcept { return std::strtof(s, end); }
+
+    static bool S_match(const char* p, const char* last, const char* word) noexcept {
+        for (; *word != '\0'; p++, word++) {
+            if (p == last || (*p | 0x20) != *word) return false;
+        }
+        return true;
+    }
+
+    // Most digits and power of 10 exact in T
+    static uint64_t S_exact_digits(double) noexcept { return static_cast<uint64_t>(1) << 53; }
+    static uint64_t S_exact_digits(float) noexcept { return static_cast<uint64_t>(1) << 24; }
+    static int S_exact_pow10(double) noexcept { return 22; }
+    static int S_exact_pow10(float) noexcept { return 10; }
+};
+
+template <class T>
+from_chars_result float_parser::parse(const char* first, const char* last, T& value) noexcept {
+    static const T pow10[] = {
+        T(1e0), T(1e1), T(1e2), T(1e3), T(1e4), T(1e5), T(1e6), T(1e7), T(1e8), T(1e9), T(1e10),
+        T(1e11), T(1e12), T(1e13), T(1e14), T(1e15), T(1e16), T(1e17), T(1e18), T(1e19), T(1e20),
+        T(1e21), T(1e22)
+    };
+    const char* p = first;
+    const bool neg = p != last && *p == '-';
+    if (neg) p++;
+
+    if (S_match(p, last, "inf")) {
+        p += S_match(p, last, "infinity") ? 8 : 3;
+        value = neg ? -std::numeric_limits<T>::infinity() : std::numeric_limits<T>::infinity();
+        return { p, std::errc() };
+    }
+    if (S_match(p, last, "nan")) {
+        value = neg ? -std::numeric_limits<T>::quiet_NaN() : std::numeric_limits<T>::quiet_NaN();
+        return { p + 3, std::errc() };
+    }
+
+    // The digits without leading zeros, the point is told by the exponent
+    const char* start = p;
+    uint64_t mantissa = 0;
+    int digits = 0;                 // significant digits seen
+    int dropped = 0;                // digits of the integer part beyond 19
+    int frac = 0;                   // significant digits after the point, up to 19
+    bool any = false;
+    for (; p != last && *p >= '0' && *p <= '9'; p++) {
+        any = true;
+        if (digits == 0 && *p == '0') continue;
+        if (digits < 19) mantissa = mantissa * 10 + (*p - '0');
+        else dropped++;
+        digits++;
+    }
+    if (p != last && *p == '.') {
+        p++;
+        for (; p != last && *p >= '0' && *p <= '9'; p++) {
+            any = true;
+            if (digits == 0 && *p == '0') {
+                frac++;
+                continue;
+            }
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (*p - '0');
+                frac++;
+            }
+            digits++;
+        }
+    }
+    if (!any) return { first, std::errc::invalid_argument };
+    const char* digits_end = p;
+
+    long exp = 0;
+    if (p != last && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        bool exp_neg = false;
+        if (q != last && (*q == '+' || *q == '-')) exp_neg = *q++ == '-';
+        if (q != last && *q >= '0' && *q <= '9') {
+            for (; q != last && *q >= '0' && *q <= '9'; q++) {
+                if (exp < 100000) exp = exp * 10 + (*q - '0');
+            }
+            if (exp_neg) exp = -exp;
+            p = q;
+        }
+    }
+
+    if (mantissa == 0 && digits == 0) {
+        value = neg ? -T(0) : T(0);
+        return { p, std::errc() };
+    }
+    const long e10 = exp + dropped - frac;
+    if (digits <= 19 && mantissa <= S_exact_digits(T()) &&
+        e10 >= -S_exact_pow10(T()) && e10 <= S_exact_pow10(T())) {
+        T v = static_cast<T>(mantissa);
+        v = e10 < 0 ? v / pow10[-e10] : v * pow10[e10];
+        value = neg ? -v : v;
+        return { p, std::errc() };
+    }
+
+    // The significant digits, then the exponent of the last one
+    char text[EMaxParseDigits + 2 + EMaxIntegerChars];
+    char* out = text;
+    long point_shift = 0;
+    bool after_point = false, leading = true, sticky = false;
+    for (const char* c = start; c != digits_end; c++) {
+        if (*c == '.') {
+            after_point = true;
+            continue;
+        }
+        if (leading && *c == '0') {
+            if (after_point) point_shift--;
+            continue;
+        }
+        leading = false;
+        if (out - text < EMaxParseDigits) {
+            *out++ = *c;
+            if (after_point) point_shift--;
+        } else {
+            // A dropped digit of the integer part still moves the point
+            if (!after_point) point_shift++;
+            sticky |= *c != '0';
+        }
+    }
+    if (sticky) {
+        *out++ = '1';
+        point_shift--;
+    }
+    *out++ = 'e';
+    out = to_chars(out, text + sizeof(text) - 1, exp + point_shift).ptr;
+    *out = '\0';
+    const int saved = errno;
+    errno = 0;
+    char* end;
+    const T v = S_strto(text, &end, T());
+    const bool range = errno == ERANGE;
+    errno = saved;
+    if (range && (v == T(0) || v == std::numeric_limits<T>::infinity())) {
+        return { p, std::errc::result_out_of_range };
+    }
+    value = neg ? -v : v;
+    return { p, std::errc() };
+}
+
+inline from_chars_result from_chars(const char* first, const char* last, double& value) noexcept {
+    return float_parser::parse(first, last, value);
+}
+
+inline from_chars_result from_chars(const char* first, const char* last, float& value) noexcept {
+    return float_parser::parse(first, last, value);
+}
+
+/*****************************************************************************************/
+// Into a string
+
+// Append value to str, writing in its capacity
+template <class T, typename std::enable_if<std::is_arithmetic<T>::value &&
+  !std::is_same<T, bool>::value, int>::type = 0>
+string& append_chars(string& str, T value) {
+    const size_t n = str.size();
+    str.resize_and_overwrite(n + (std::is_integral<T>::value ? EMaxIntegerChars : EMaxDoubleChars),
+                             [&](char* p, size_t count) {
+        return to_chars(p + n, p + count, value).ptr - p;
+    });
+    return str;
+}
+
+template <class T, typename std::enable_if<std::is_arithmetic<T>::value &&
+  !std::is_same<T, bool>::value, int>::type = 0>
+string to_string(T value) {
+    string str;
+    append_chars(str, value);
+    return str;
+}
+
+} // namespace saberstl
+
+#endif // !SABERSTL_CHARCONV_H
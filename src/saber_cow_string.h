@@ -0,0 +1,685 @@
+#ifndef SABERSTL_COW_STRING_H
+#define SABERSTL_COW_STRING_H
+
+// Template Class: basic_cow_string
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+
+#include "saber_basic_string.h"
+
+namespace saberstl {
+
+// The header of a shared buffer, the characters and a null follow it
+struct cow_string_rep {
+    std::atomic<size_t> refs;   // strings sharing the buffer
+    size_t size;                // number of characters
+    size_t cap;                 // characters it holds, the null excluded
+    bool leaked;                // a mutable reference was handed out, never share it again
+};
+
+// template class basic_cow_string
+// A string whose copies share one immutable buffer with an atomic count of
+// owners, so a copy costs an increment instead of an allocation and a copy
+// of the characters. The buffer is copied the first time a sharing string
+// is written, and written in place when the string owns it alone.
+// Handing out a mutable reference (non-const operator[], at, data, begin...)
+// makes the buffer unique and marks it leaked, so a later copy of the
+// string takes its own buffer and the reference cannot write into it.
+// The empty string has no buffer at all.
+// Parameter 1 represents the type of string;
+// Parameter 2 represents the solution of extraction type of string, default using saberstl::char_traits
+template <class CharType, class CharTraits = saberstl::char_traits<CharType>>
+class basic_cow_string {
+public:
+    typedef CharTraits                                  traits_type;
+    typedef CharTraits                                  char_traits;
+
+    typedef CharType                                    value_type;
+    typedef CharType*                                   pointer;
+    typedef const CharType*                             const_pointer;
+    typedef CharType&                                   reference;
+    typedef const CharType&                             const_reference;
+    typedef size_t                                      size_type;
+    typedef ptrdiff_t                                   difference_type;
+
+    typedef value_type*                                 iterator;
+    typedef const value_type*                           const_iterator;
+    typedef saberstl::reverse_iterator<iterator>        reverse_iterator;
+    typedef saberstl::reverse_iterator<const_iterator>  const_reverse_iterator;
+
+    typedef basic_string<CharType, CharTraits>          string_type;
+    typedef basic_string_view<CharType, CharTraits>     string_view_type;
+
+    typedef saberstl::allocator<char>                   rep_allocator;
+
+    static constexpr size_type npos = static_cast<size_type>(-1);
+
+    static_assert(std::is_same<CharType, typename traits_type::char_type>::value,
+                  "CharType must be same as traits_type::char_type");
+
+private:
+    cow_string_rep* rep_;   // The shared buffer, nullptr for the empty string
+
+public:
+    // Constructor, copy and move function, destructor
+    basic_cow_string() noexcept : rep_(nullptr) {}
+
+    basic_cow_string(size_type n, value_type ch) : rep_(nullptr) {
+        append(n, ch);
+    }
+    basic_cow_string(const_pointer str) : rep_(nullptr) {
+        append(str, char_traits::length(str));
+    }
+    basic_cow_string(const_pointer str, size_type count) : rep_(nullptr) {
+        append(str, count);
+    }
+    explicit basic_cow_string(string_view_type str) : rep_(nullptr) {
+        append(str.data(), str.size());
+    }
+    explicit basic_cow_string(const string_type& str) : rep_(nullptr) {
+        append(str.data(), str.size());
+    }
+
+    basic_cow_string(const basic_cow_string& rhs) : rep_(S_acquire(rhs.rep_)) {}
+    basic_cow_string(basic_cow_string&& rhs) noexcept : rep_(rhs.rep_) {
+        rhs.rep_ = nullptr;
+    }
+
+    basic_cow_string& operator=(const basic_cow_string& rhs) {
+        cow_string_rep* rep = S_acquire(rhs.rep_);
+        S_release(rep_);
+        rep_ = rep;
+        return *this;
+    }
+    basic_cow_string& operator=(basic_cow_string&& rhs) noexcept {
+        if (this != &rhs) {
+            S_release(rep_);
+            rep_ = rhs.rep_;
+            rhs.rep_ = nullptr;
+        }
+        return *this;
+    }
+    basic_cow_string& operator=(const_pointer str) { return assign(str); }
+    basic_cow_string& operator=(value_type ch) { return assign(1, ch); }
+    basic_cow_string& operator=(string_view_type str) { return assign(str); }
+
+    ~basic_cow_string() {
+        S_release(rep_);
+    }
+
+public:
+    // Iterator, the mutable ones leak the buffer
+    iterator                begin()                 { return leak(); }
+    const_iterator          begin()   const noexcept { return data(); }
+    iterator                end()                   { return leak() + size(); }
+    const_iterator          end()     const noexcept { return data() + size(); }
+
+    reverse_iterator        rbegin()                { return reverse_iterator(end()); }
+    const_reverse_iterator  rbegin()  const noexcept { return const_reverse_iterator(end()); }
+    reverse_iterator        rend()                  { return reverse_iterator(begin()); }
+    const_reverse_iterator  rend()    const noexcept { return const_reverse_iterator(begin()); }
+
+    const_iterator          cbegin()  const noexcept { return begin(); }
+    const_iterator          cend()    const noexcept { return end(); }
+    const_reverse_iterator  crbegin() const noexcept { return rbegin(); }
+    const_reverse_iterator  crend()   const noexcept { return rend(); }
+
+    // Capacity
+    bool      empty()    const noexcept { return size() == 0; }
+    size_type size()     const noexcept { return rep_ == nullptr ? 0 : rep_->size; }
+    size_type length()   const noexcept { return size(); }
+    size_type capacity() const noexcept { return rep_ == nullptr ? 0 : rep_->cap; }
+    size_type max_size() const noexcept {
+        return (static_cast<size_type>(-1) - sizeof(cow_string_rep)) / sizeof(CharType) - 1;
+    }
+
+    void reserve(size_type n);
+    void shrink_to_fit();
+
+    // Number of strings sharing the buffer, 0 for the empty string
+    size_type use_count() const noexcept {
+        return rep_ == nullptr ? 0 : rep_->refs.load(std::memory_order_relaxed);
+    }
+
+    // Access the elements
+    reference operator[](size_type n) {
+        SABERSTL_DEBUG(n <= size());
+        return leak()[n];
+    }
+    const_reference operator[](size_type n) const {
+        SABERSTL_DEBUG(n <= size());
+        return data()[n];
+    }
+
+    reference at(size_type n) {
+        THROW_OUT_OF_RANGE_IF(n >= size(), "basic_cow_string<Char, Traits>::at() subscript out of range");
+        return leak()[n];
+    }
+    const_reference at(size_type n) const {
+        THROW_OUT_OF_RANGE_IF(n >= size(), "basic_cow_string<Char, Traits>::at() subscript out of range");
+        return data()[n];
+    }
+
+    reference front() {
+        SABERSTL_DEBUG(!empty());
+        return leak()[0];
+    }
+    const_reference front() const {
+        SABERSTL_DEBUG(!empty());
+        return data()[0];
+    }
+
+    reference back() {
+        SABERSTL_DEBUG(!empty());
+        return leak()[size() - 1];
+    }
+    const_reference back() const {
+        SABERSTL_DEBUG(!empty());
+        return data()[size() - 1];
+    }
+
+    pointer       data()                { return leak(); }
+    const_pointer data()  const noexcept {
+        return rep_ == nullptr ? S_empty() : reinterpret_cast<const_pointer>(rep_ + 1);
+    }
+    const_pointer c_str() const noexcept { return data(); }
+
+    // Convert to a view, or to a basic_string by a copy
+    string_view_type view() const noexcept { return string_view_type(data(), size()); }
+    operator string_view_type() const noexcept { return view(); }
+    string_type str() const { return string_type(view()); }
+
+    // Modify the container
+    void clear() noexcept {
+        if (unique()) {
+            rep_->size = 0;
+            chars()[0] = value_type();
+        } else {
+            S_release(rep_);
+            rep_ = nullptr;
+        }
+    }
+
+    // assign
+    basic_cow_string& assign(size_type count, value_type ch) {
+        return replace(0, size(), count, ch);
+    }
+    basic_cow_string& assign(const basic_cow_string& str) {
+        return *this = str;
+    }
+    basic_cow_string& assign(const_pointer str) {
+        return replace(0, size(), str, char_traits::length(str));
+    }
+    basic_cow_string& assign(const_pointer str, size_type count) {
+        return replace(0, size(), str, count);
+    }
+    basic_cow_string& assign(string_view_type str) {
+        return replace(0, size(), str.data(), str.size());
+    }
+
+    // push_back / pop_back
+    void push_back(value_type ch) {
+        *make_room(size(), 0, 1) = ch;
+    }
+    void pop_back() {
+        SABERSTL_DEBUG(!empty());
+        erase(size() - 1, 1);
+    }
+
+    // append
+    basic_cow_string& append(size_type count, value_type ch) {
+        return replace(size(), 0, count, ch);
+    }
+    basic_cow_string& append(const basic_cow_string& str) {
+        return replace(size(), 0, str.data(), str.size());
+    }
+    basic_cow_string& append(const_pointer str) {
+        return replace(size(), 0, str, char_traits::length(str));
+    }
+    basic_cow_string& append(const_pointer str, size_type count) {
+        return replace(size(), 0, str, count);
+    }
+    basic_cow_string& append(string_view_type str) {
+        return replace(size(), 0, str.data(), str.size());
+    }
+
+    basic_cow_string& operator+=(const basic_cow_string& str) { return append(str); }
+    basic_cow_string& operator+=(value_type ch) { push_back(ch); return *this; }
+    basic_cow_string& operator+=(const_pointer str) { return append(str); }
+    basic_cow_string& operator+=(string_view_type str) { return append(str); }
+
+    // insert
+    basic_cow_string& insert(size_type pos, size_type count, value_type ch) {
+        return replace(pos, 0, count, ch);
+    }
+    basic_cow_string& insert(size_type pos, const basic_cow_string& str) {
+        return insert(pos, str.view());
+    }
+    basic_cow_string& insert(size_type pos, const_pointer str) {
+        return insert(pos, string_view_type(str));
+    }
+    basic_cow_string& insert(size_type pos, const_pointer str, size_type count) {
+        return insert(pos, string_view_type(str, count));
+    }
+    basic_cow_string& insert(size_type pos, string_view_type str) {
+        return replace(pos, 0, str.data(), str.size());
+    }
+
+    // erase
+    basic_cow_string& erase(size_type pos = 0, size_type count = npos) {
+        THROW_OUT_OF_RANGE_IF(pos > size(), "basic_cow_string<Char, Traits>'s pos out of range");
+        make_room(pos, saberstl::min(count, size() - pos), 0);
+        return *this;
+    }
+
+    // replace
+    basic_cow_string& replace(size_type pos, size_type count, const basic_cow_string& str) {
+        return replace(pos, count, str.view());
+    }
+    basic_cow_string& replace(size_type pos, size_type count, const_pointer str) {
+        return replace(pos, count, string_view_type(str));
+    }
+    basic_cow_string& replace(size_type pos, size_type count, string_view_type str) {
+        return replace(pos, count, str.data(), str.size());
+    }
+    basic_cow_string& replace(size_type pos, size_type count, const_pointer str, size_type count2);
+    basic_cow_string& replace(size_type pos, size_type count, size_type count2, value_type ch);
+
+    // resize
+    void resize(size_type count) {
+        resize(count, value_type());
+    }
+    void resize(size_type count, value_type ch) {
+        if (count < size()) erase(count);
+        else append(count - size(), ch);
+    }
+
+    // substr / copy
+    basic_cow_string substr(size_type pos = 0, size_type count = npos) const {
+        return basic_cow_string(view().substr(pos, count));
+    }
+    size_type copy(pointer dest, size_type count, size_type pos = 0) const {
+        return view().copy(dest, count, pos);
+    }
+
+    // find / rfind, npos for none, done by the view of the string
+    size_type find(value_type ch, size_type pos = 0) const noexcept {
+        return view().find(ch, pos);
+    }
+    size_type find(const_pointer str, size_type pos, size_type count) const noexcept {
+        return view().find(str, pos, count);
+    }
+    size_type find(const_pointer str, size_type pos = 0) const noexcept {
+        return view().find(str, pos);
+    }
+    size_type find(string_view_type str, size_type pos = 0) const noexcept {
+        return view().find(str, pos);
+    }
+
+    size_type rfind(value_type ch, size_type pos = npos) const noexcept {
+        return view().rfind(ch, pos);
+    }
+    size_type rfind(const_pointer str, size_type pos, size_type count) const noexcept {
+        return view().rfind(str, pos, count);
+    }
+    size_type rfind(const_pointer str, size_type pos = npos) const noexcept {
+        return view().rfind(str, pos);
+    }
+    size_type rfind(string_view_type str, size_type pos = npos) const noexcept {
+        return view().rfind(str, pos);
+    }
+
+    // find_first_of / find_first_not_of, npos for none
+    size_type find_first_of(value_type ch, size_type pos = 0) const noexcept {
+        return view().find_first_of(ch, pos);
+    }
+    size_type find_first_of(const_pointer str, size_type pos, size_type count) const noexcept {
+        return view().find_first_of(str, pos, count);
+    }
+    size_type find_first_of(const_pointer str, size_type pos = 0) const noexcept {
+        return view().find_first_of(str, pos);
+    }
+    size_type find_first_of(string_view_type str, size_type pos = 0) const noexcept {
+        return view().find_first_of(str, pos);
+    }
+
+    size_type find_first_not_of(value_type ch, size_type pos = 0) const noexcept {
+        return view().find_first_not_of(ch, pos);
+    }
+    size_type find_first_not_of(const_pointer str, size_type pos, size_type count) const noexcept {
+        return view().find_first_not_of(str, pos, count);
+    }
+    size_type find_first_not_of(const_pointer str, size_type pos = 0) const noexcept {
+        return view().find_first_not_of(str, pos);
+    }
+    size_type find_first_not_of(string_view_type str, size_type pos = 0) const noexcept {
+        return view().find_first_not_of(str, pos);
+    }
+
+    // Compare two strings, sharing strings are equal without a look at the characters
+    int compare(const basic_cow_string& other) const noexcept {
+        return rep_ == other.rep_ ? 0 : view().compare(other.view());
+    }
+    int compare(const_pointer str) const noexcept {
+        return view().compare(string_view_type(str));
+    }
+    int compare(string_view_type str) const noexcept {
+        return view().compare(str);
+    }
+    int compare(size_type pos, size_type count, string_view_type str) const {
+        return view().compare(pos, count, str);
+    }
+
+    // Swap the buffers
+    void swap(basic_cow_string& rhs) noexcept {
+        cow_string_rep* tmp = rep_;
+        rep_ = rhs.rep_;
+        rhs.rep_ = tmp;
+    }
+
+private:
+    pointer chars() const noexcept { return reinterpret_cast<pointer>(rep_ + 1); }
+
+    bool unique() const noexcept {
+        return rep_ != nullptr && rep_->refs.load(std::memory_order_acquire) == 1;
+    }
+
+    static const_pointer S_empty() noexcept {
+        static const value_type empty = value_type();
+        return &empty;
+    }
+
+    static cow_string_rep* S_create(size_type cap);
+    static cow_string_rep* S_acquire(cow_string_rep* rep);
+    static void S_release(cow_string_rep* rep) noexcept;
+
+    size_type grow_capacity(size_type need) const;
+    void reallocate(size_type new_cap);
+    pointer leak();
+    pointer make_room(size_type pos, size_type count1, size_type count2);
+};
+
+template <class CharType, class CharTraits>
+constexpr typename basic_cow_string<CharType, CharTraits>::size_type
+basic_cow_string<CharType, CharTraits>::npos;
+
+/*****************************************************************************************/
+
+template <class CharType, class CharTraits>
+void basic_cow_string<CharType, CharTraits>::reserve(size_type n) {
+    if (n > capacity()) reallocate(n);
+}
+
+// Only a buffer owned alone is shrunk
+template <class CharType, class CharTraits>
+void basic_cow_string<CharType, CharTraits>::shrink_to_fit() {
+    if (unique() && rep_->cap > rep_->size) reallocate(rep_->size);
+}
+
+// Replace count characters at pos with count2 characters of str, which may
+// be a part of this string
+template <class CharType, class CharTraits>
+basic_cow_string<CharType, CharTraits>&
+basic_cow_string<CharType, CharTraits>::replace(size_type pos, size_type count,
+                                                const_pointer str, size_type count2) {
+    THROW_OUT_OF_RANGE_IF(pos > size(), "basic_cow_string<Char, Traits>'s pos out of range");
+    count = saberstl::min(count, size() - pos);
+    const_pointer old = c_str();
+    cow_string_rep* keep = nullptr;
+    if (str + count2 > old && str < old + size()) {
+        // Keep the buffer alive and shared, make_room then copies out of it
+        keep = rep_;
+        keep->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+    char_traits::copy(make_room(pos, count, count2), str, count2);
+    S_release(keep);
+    return *this;
+}
+
+template <class CharType, class CharTraits>
+basic_cow_string<CharType, CharTraits>&
+basic_cow_string<CharType, CharTraits>::replace(size_type pos, size_type count,
+                                                size_type count2, value_type ch) {
+    THROW_OUT_OF_RANGE_IF(pos > size(), "basic_cow_string<Char, Traits>'s pos out of range");
+    count = saberstl::min(count, size() - pos);
+    pointer p = make_room(pos, count, count2);
+    if (count2 != 0) char_traits::fill(p, ch, count2);
+    return *this;
+}
+
+/*****************************************************************************************/
+// helper function
+
+// A buffer for cap characters with one owner
+template <class CharType, class CharTraits>
+cow_string_rep* basic_cow_string<CharType, CharTraits>::S_create(size_type cap) {
+    char* raw = rep_allocator::allocate(sizeof(cow_string_rep) + (cap + 1) * sizeof(CharType));
+    cow_string_rep* rep = ::new (static_cast<void*>(raw)) cow_string_rep;
+    rep->refs.store(1, std::memory_order_relaxed);
+    rep->size = 0;
+    rep->cap = cap;
+    rep->leaked = false;
+    return rep;
+}
+
+// Share rep, or copy it when it has been leaked
+template <class CharType, class CharTraits>
+cow_string_rep* basic_cow_string<CharType, CharTraits>::S_acquire(cow_string_rep* rep) {
+    if (rep == nullptr) return nullptr;
+    if (!rep->leaked) {
+        rep->refs.fetch_add(1, std::memory_order_relaxed);
+        return rep;
+    }
+    cow_string_rep* r = S_create(rep->size);
+    r->size = rep->size;
+    char_traits::copy(reinterpret_cast<pointer>(r + 1), reinterpret_cast<const_pointer>(rep + 1),
+                      rep->size + 1);
+    return r;
+}
+
+// The last owner frees the buffer
+template <class CharType, class CharTraits>
+void basic_cow_string<CharType, CharTraits>::S_release(cow_string_rep* rep) noexcept {
+    if (rep == nullptr) return;
+    if (rep->refs.load(std::memory_order_acquire) != 1 &&
+        rep->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+    const size_type bytes = sizeof(cow_string_rep) + (rep->cap + 1) * sizeof(CharType);
+    rep->~cow_string_rep();
+    rep_allocator::deallocate(reinterpret_cast<char*>(rep), bytes);
+}
+
+template <class CharType, class CharTraits>
+typename basic_cow_string<CharType, CharTraits>::size_type
+basic_cow_string<CharType, CharTraits>::grow_capacity(size_type need) const {
+    THROW_LENGTH_ERROR_IF(need > max_size(), "basic_cow_string<Char, Traits>'s size too big");
+    const size_type old = capacity();
+    if (old > max_size() / 2) return max_size();
+    return saberstl::max(saberstl::max(need, old * 2), static_cast<size_type>(STRING_INTI_SIZE));
+}
+
+// Move the characters to a buffer of its own with new_cap characters
+template <class CharType, class CharTraits>
+void basic_cow_string<CharType, CharTraits>::reallocate(size_type new_cap) {
+    const size_type n = size();
+    cow_string_rep* rep = S_create(new_cap);
+    rep->size = n;
+    pointer p = reinterpret_cast<pointer>(rep + 1);
+    char_traits::copy(p, c_str(), n);
+    p[n] = value_type();
+    S_release(rep_);
+    rep_ = rep;
+}
+
+// Make the buffer unique and never share it again, for a mutable reference
+template <class CharType, class CharTraits>
+typename basic_cow_string<CharType, CharTraits>::pointer
+basic_cow_string<CharType, CharTraits>::leak() {
+    if (!unique()) reallocate(size());
+    rep_->leaked = true;
+    return chars();
+}
+
+// Make the buffer unique with count1 characters at pos replaced by count2
+// uninitialized ones, return where they begin. The buffer is written in
+// place when this string owns it alone and it is large enough, otherwise
+// the kept characters are copied to a new one.
+template <class CharType, class CharTraits>
+typename basic_cow_string<CharType, CharTraits>::pointer
+basic_cow_string<CharType, CharTraits>::make_room(size_type pos, size_type count1, size_type count2) {
+    const size_type n = size();
+    SABERSTL_DEBUG(pos + count1 <= n);
+    THROW_LENGTH_ERROR_IF(count2 > max_size() - (n - count1),
+                          "basic_cow_string<Char, Traits>'s size too big");
+    const size_type new_size = n - count1 + count2;
+    const size_type tail = n - pos - count1;
+    if (unique() && new_size <= rep_->cap) {
+        pointer p = chars();
+        char_traits::move(p + pos + count2, p + pos + count1, tail);
+        rep_->size = new_size;
+        p[new_size] = value_type();
+        return p + pos;
+    }
+    if (new_size == 0) {
+        S_release(rep_);
+        rep_ = nullptr;
+        return nullptr;
+    }
+    const size_type cap = new_size > capacity() ? grow_capacity(new_size) : capacity();
+    cow_string_rep* rep = S_create(cap);
+    rep->size = new_size;
+    pointer p = reinterpret_cast<pointer>(rep + 1);
+    const_pointer old = c_str();
+    char_traits::copy(p, old, pos);
+    char_traits::copy(p + pos + count2, old + pos + count1, tail);
+    p[new_size] = value_type();
+    S_release(rep_);
+    rep_ = rep;
+    return p + pos;
+}
+
+/*****************************************************************************************/
+// Overload comparison operators
+
+template <class CharType, class CharTraits>
+bool operator==(const basic_cow_string<CharType, CharTraits>& lhs,
+                const basic_cow_string<CharType, CharTraits>& rhs) noexcept {
+    return lhs.size() == rhs.size() && lhs.compare(rhs) == 0;
+}
+
+template <class CharType, class CharTraits>
+bool operator==(const basic_cow_string<CharType, CharTraits>& lhs, const CharType* rhs) noexcept {
+    return lhs.compare(rhs) == 0;
+}
+
+template <class CharType, class CharTraits>
+bool operator==(const CharType* lhs, const basic_cow_string<CharType, CharTraits>& rhs) noexcept {
+    return rhs.compare(lhs) == 0;
+}
+
+template <class CharType, class CharTraits>
+bool operator!=(const basic_cow_string<CharType, CharTraits>& lhs,
+                const basic_cow_string<CharType, CharTraits>& rhs) noexcept {
+    return !(lhs == rhs);
+}
+
+template <class CharType, class CharTraits>
+bool operator!=(const basic_cow_string<CharType, CharTraits>& lhs, const CharType* rhs) noexcept {
+    return !(lhs == rhs);
+}
+
+template <class CharType, class CharTraits>
+bool operator!=(const CharType* lhs, const basic_cow_string<CharType, CharTraits>& rhs) noexcept {
+    return !(lhs == rhs);
+}
+
+template <class CharType, class CharTraits>
+bool operator<(const basic_cow_string<CharType, CharTraits>& lhs,
+               const basic_cow_string<CharType, CharTraits>& rhs) noexcept {
+    return lhs.compare(rhs) < 0;
+}
+
+template <class CharType, class CharTraits>
+bool operator<=(const basic_cow_string<CharType, CharTraits>& lhs,
+                const basic_cow_string<CharType, CharTraits>& rhs) noexcept {
+    return lhs.compare(rhs) <= 0;
+}
+
+template <class CharType, class CharTraits>
+bool operator>(const basic_cow_string<CharType, CharTraits>& lhs,
+               const basic_cow_string<CharType, CharTraits>& rhs) noexcept {
+    return lhs.compare(rhs) > 0;
+}
+
+template <class CharType, class CharTraits>
+bool operator>=(const basic_cow_string<CharType, CharTraits>& lhs,
+                const basic_cow_string<CharType, CharTraits>& rhs) noexcept {
+    return lhs.compare(rhs) >= 0;
+}
+
+// Overload operator+
+template <class CharType, class CharTraits>
+basic_cow_string<CharType, CharTraits>
+operator+(const basic_cow_string<CharType, CharTraits>& lhs,
+          const basic_cow_string<CharType, CharTraits>& rhs) {
+    basic_cow_string<CharType, CharTraits> result;
+    result.reserve(lhs.size() + rhs.size());
+    result.append(lhs).append(rhs);
+    return result;
+}
+
+template <class CharType, class CharTraits>
+basic_cow_string<CharType, CharTraits>
+operator+(const basic_cow_string<CharType, CharTraits>& lhs, const CharType* rhs) {
+    const size_t n = CharTraits::length(rhs);
+    basic_cow_string<CharType, CharTraits> result;
+    result.reserve(lhs.size() + n);
+    result.append(lhs).append(rhs, n);
+    return result;
+}
+
+template <class CharType, class CharTraits>
+basic_cow_string<CharType, CharTraits>
+operator+(const CharType* lhs, const basic_cow_string<CharType, CharTraits>& rhs) {
+    const size_t n = CharTraits::length(lhs);
+    basic_cow_string<CharType, CharTraits> result;
+    result.reserve(n + rhs.size());
+    result.append(lhs, n).append(rhs);
+    return result;
+}
+
+template <class CharType, class CharTraits>
+basic_cow_string<CharType, CharTraits>
+operator+(const basic_cow_string<CharType, CharTraits>& lhs, CharType ch) {
+    basic_cow_string<CharType, CharTraits> result;
+    result.reserve(lhs.size() + 1);
+    result.append(lhs).push_back(ch);
+    return result;
+}
+
+// Overload swap
+template <class CharType, class CharTraits>
+void swap(basic_cow_string<CharType, CharTraits>& lhs,
+          basic_cow_string<CharType, CharTraits>& rhs) noexcept {
+    lhs.swap(rhs);
+}
+
+// Overload hash, equal to the hash of basic_string with the same characters
+template <class CharType, class CharTraits>
+struct hash<basic_cow_string<CharType, CharTraits>> {
+    size_t operator()(const basic_cow_string<CharType, CharTraits>& str) const noexcept {
+        return hash<basic_string_view<CharType, CharTraits>>()(str.view());
+    }
+};
+
+typedef basic_cow_string<char>      cow_string;
+typedef basic_cow_string<wchar_t>   cow_wstring;
+typedef basic_cow_string<char16_t>  cow_u16string;
+typedef basic_cow_string<char32_t>  cow_u32string;
+
+} // namespace saberstl
+
+#endif // !SABERSTL_COW_STRING_H
@@ -36,7 +36,7 @@ struct has_iterator_cat {
 private:
     struct two {char a; char b;};
     template <class U> static two test(...);
-    template <class U> static test(typename U::iterator_category* = 0);
+    template <class U> static char test(typename U::iterator_category* = 0);
 public:
     static const bool value = sizeof(test<T>(0)) == sizeof(char);
 };
@@ -121,7 +121,7 @@ struct is_iterator :
 template <class Iterator>
 typename iterator_traits<Iterator>::iterator_category
 iterator_category (const Iterator&) {
-    typedef typename iterator_tarits<Iterator>::iterator_category Category;
+    typedef typename iterator_traits<Iterator>::iterator_category Category;
     return Category();
 }
 
@@ -147,7 +147,7 @@ template <class InputIterator>
 typename iterator_traits<InputIterator>::difference_type
 distance_type (InputIterator first, InputIterator last, input_iterator_tag) {
     typename iterator_traits<InputIterator>::difference_type n = 0;
-    while (first != end) {
+    while (first != last) {
         first++;
         n++;
     }
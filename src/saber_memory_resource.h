@@ -0,0 +1,372 @@
+#ifndef SABERSTL_MEMORY_RESOURCE_H
+#define SABERSTL_MEMORY_RESOURCE_H
+
+/*
+ * This header file contains the abstract class memory_resource, some
+ * resources built on the memory tools of saberstl, the template class
+ * polymorphic_allocator, which takes memory from a resource chosen at
+ * runtime, and the strings of namespace pmr using it
+*/
+
+#include <new>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "saber_alloc.h"
+#include "saber_allocator.h"
+#include "saber_arena.h"
+#include "saber_basic_string.h"
+#include "saber_construct.h"
+#include "saber_util.h"
+
+namespace saberstl {
+
+/*
+ * class memory_resource
+ * The interface of the memory sources. The derived classes implement
+ * do_allocate, do_deallocate and do_is_equal.
+*/
+class memory_resource {
+public:
+    virtual ~memory_resource() {}
+
+    void *allocate(size_t bytes, size_t align = alignof(std::max_align_t)) {
+        return do_allocate(bytes, align);
+    }
+
+    void deallocate(void *p, size_t bytes, size_t align = alignof(std::max_align_t)) {
+        do_deallocate(p, bytes, align);
+    }
+
+    bool is_equal(const memory_resource& other) const noexcept {
+        return do_is_equal(other);
+    }
+
+private:
+    virtual void *do_allocate(size_t bytes, size_t align) = 0;
+    virtual void do_deallocate(void *p, size_t bytes, size_t align) = 0;
+    virtual bool do_is_equal(const memory_resource& other) const noexcept = 0;
+};
+
+inline bool operator==(const memory_resource& lhs, const memory_resource& rhs) noexcept {
+    return &lhs == &rhs || lhs.is_equal(rhs);
+}
+
+inline bool operator!=(const memory_resource& lhs, const memory_resource& rhs) noexcept {
+    return !(lhs == rhs);
+}
+
+
+/*
+ * class new_delete_resource_type
+ * Takes memory from ::operator new and ::operator delete
+*/
+class new_delete_resource_type : public memory_resource {
+private:
+    void *do_allocate(size_t bytes, size_t align) override {
+        return aligned_operator_new(bytes, align);
+    }
+
+    void do_deallocate(void *p, size_t /*bytes*/, size_t align) override {
+        aligned_operator_delete(p, align);
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+/*
+ * class pool_resource_type
+ * Takes memory from the memory pool alloc
+*/
+class pool_resource_type : public memory_resource {
+private:
+    void *do_allocate(size_t bytes, size_t align) override {
+        void *p = alloc::allocate(bytes == 0 ? 1 : bytes, align);
+        if (p == nullptr) throw std::bad_alloc();
+        return p;
+    }
+
+    void do_deallocate(void *p, size_t bytes, size_t align) override {
+        alloc::deallocate(p, bytes == 0 ? 1 : bytes, align);
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+/*
+ * class numa_resource_type
+ * Takes memory from the pool of alloc on a NUMA node, whichever node the
+ * thread runs on, so a container built on it keeps its memory local to
+ * the threads of that node. The blocks skip the thread cache. A larger
+ * alignment is got as alloc::allocate(n, align) does, large blocks come
+ * from alloc as usual, and on a system without NUMA all the nodes are the
+ * one pool.
+*/
+class numa_resource_type : public memory_resource {
+private:
+    size_t node_;
+
+public:
+    explicit numa_resource_type(size_t node = 0) noexcept : node_(node) {}
+
+    size_t node() const noexcept { return node_; }
+
+private:
+    void *do_allocate(size_t bytes, size_t align) override;
+    void do_deallocate(void *p, size_t bytes, size_t align) override;
+
+    bool do_is_equal(const memory_resource& other) const noexcept override {
+        const numa_resource_type *rhs = dynamic_cast<const numa_resource_type*>(&other);
+        return rhs != nullptr && rhs->node_ == node_;
+    }
+};
+
+inline void* numa_resource_type::do_allocate(size_t bytes, size_t align) {
+    if (bytes == 0) bytes = 1;
+    void *p;
+    if (align <= static_cast<size_t>(EAlign128)) {
+        p = alloc::allocate_on(node_, bytes);
+    } else if (bytes + align > static_cast<size_t>(ESmallObjectBytes)) {
+        p = alloc::allocate(bytes, align);
+    } else {
+        /* Keep the address of the block just before the aligned space */
+        char *raw = static_cast<char*>(alloc::allocate_on(node_, bytes + align));
+        if (raw == nullptr) throw std::bad_alloc();
+        p = raw + align - (reinterpret_cast<uintptr_t>(raw) & (align - 1));
+        reinterpret_cast<char**>(p)[-1] = raw;
+    }
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+inline void numa_resource_type::do_deallocate(void *p, size_t bytes, size_t align) {
+    if (bytes == 0) bytes = 1;
+    if (align <= static_cast<size_t>(EAlign128)) {
+        alloc::deallocate_on(node_, p, bytes);
+    } else if (bytes + align > static_cast<size_t>(ESmallObjectBytes)) {
+        alloc::deallocate(p, bytes, align);
+    } else {
+        alloc::deallocate_on(node_, reinterpret_cast<char**>(p)[-1], bytes + align);
+    }
+}
+
+/*
+ * class arena_resource
+ * Takes memory from a monotonic_arena it owns, deallocate does nothing.
+ * Call reset() or release() to drop all the memory at once.
+*/
+class arena_resource : public memory_resource {
+private:
+    monotonic_arena arena_;
+
+public:
+    explicit arena_resource(size_t initial_size = EArenaInitBytes)
+    : arena_(initial_size) {}
+
+    void reset() noexcept { arena_.reset(); }
+    void release() noexcept { arena_.release(); }
+
+    monotonic_arena& arena() noexcept { return arena_; }
+
+private:
+    void *do_allocate(size_t bytes, size_t align) override {
+        return arena_.allocate(bytes, align);
+    }
+
+    void do_deallocate(void * /*p*/, size_t /*bytes*/, size_t /*align*/) override {
+    }
+
+    bool do_is_equal(const memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+/* The resources shared by the whole program */
+inline memory_resource* new_delete_resource() noexcept {
+    static new_delete_resource_type resource;
+    return &resource;
+}
+
+inline memory_resource* pool_resource() noexcept {
+    static pool_resource_type resource;
+    return &resource;
+}
+
+/* The resource of node, node < EMaxNumaNodes */
+inline memory_resource* numa_resource(size_t node) noexcept {
+    static numa_resource_type resources[EMaxNumaNodes] = {
+        numa_resource_type(0), numa_resource_type(1), numa_resource_type(2),
+        numa_resource_type(3), numa_resource_type(4), numa_resource_type(5),
+        numa_resource_type(6), numa_resource_type(7)
+    };
+    return resources + node;
+}
+
+/* The resource used by the default constructed polymorphic_allocator */
+inline std::atomic<memory_resource*>& default_resource_holder() noexcept {
+    static std::atomic<memory_resource*> holder(new_delete_resource());
+    return holder;
+}
+
+inline memory_resource* get_default_resource() noexcept {
+    return default_resource_holder().load(std::memory_order_acquire);
+}
+
+/* Set the default resource, nullptr for new_delete_resource(), return the old one */
+inline memory_resource* set_default_resource(memory_resource *r) noexcept {
+    if (r == nullptr) r = new_delete_resource();
+    return default_resource_holder().exchange(r, std::memory_order_acq_rel);
+}
+
+
+/*
+ * Template class: polymorphic_allocator
+ * Has the same interface as allocator, but carries a pointer to the
+ * memory_resource it takes memory from, so containers of one type can use
+ * different memory sources chosen at runtime.
+*/
+template <class T>
+class polymorphic_allocator {
+public:
+    typedef T           value_type;
+    typedef T*          pointer;
+    typedef const T*    const_pointer;
+    typedef T&          reference;
+    typedef const T&    const_reference;
+    typedef size_t      size_type;
+    typedef ptrdiff_t   difference_type;
+
+    template <class U>
+    struct rebind {
+        typedef polymorphic_allocator<U> other;
+    };
+
+private:
+    memory_resource *resource_;
+
+public:
+    polymorphic_allocator() noexcept : resource_(get_default_resource()) {}
+
+    polymorphic_allocator(memory_resource *r) noexcept
+    : resource_(r != nullptr ? r : get_default_resource()) {}
+
+    template <class U>
+    polymorphic_allocator(const polymorphic_allocator<U>& other) noexcept
+    : resource_(other.resource()) {}
+
+    memory_resource *resource() const noexcept { return resource_; }
+
+    /* A copied container does not share the resource */
+    polymorphic_allocator select_on_container_copy_construction() const noexcept {
+        return polymorphic_allocator();
+    }
+
+public:
+    T* allocate();
+    T* allocate(size_type n);
+
+    void deallocate(T* ptr);
+    void deallocate(T* ptr, size_type n);
+
+    static void construct(T* ptr);
+    static void construct(T* ptr, const T& value);
+    static void construct(T* ptr, T&& value);
+
+    template<class... Args>
+    static void construct(T* ptr, Args&& ...args);
+
+    static void destory(T* ptr);
+    static void destory(T* first, T* last);
+};
+
+template<class T>
+T* polymorphic_allocator<T>::allocate() {
+    return static_cast<T*>(resource_->allocate(sizeof(T), alignof(T)));
+}
+
+template<class T>
+T* polymorphic_allocator<T>::allocate(size_type n) {
+    if (n == 0) return nullptr;
+    return static_cast<T*>(resource_->allocate(n * sizeof(T), alignof(T)));
+}
+
+template<class T>
+void polymorphic_allocator<T>::deallocate(T* ptr) {
+    if (ptr == nullptr) return;
+    resource_->deallocate(ptr, sizeof(T), alignof(T));
+}
+
+template<class T>
+void polymorphic_allocator<T>::deallocate(T* ptr, size_type n) {
+    if (ptr == nullptr) return;
+    resource_->deallocate(ptr, n * sizeof(T), alignof(T));
+}
+
+template<class T>
+void polymorphic_allocator<T>::construct(T* ptr) {
+    saberstl::construct(ptr);
+}
+
+template<class T>
+void polymorphic_allocator<T>::construct(T* ptr, const T& value) {
+    saberstl::construct(ptr, value);
+}
+
+template<class T>
+void polymorphic_allocator<T>::construct(T* ptr, T&& value) {
+    saberstl::construct(ptr, saberstl::move(value));
+}
+
+template<class T>
+template<class ...Args>
+void polymorphic_allocator<T>::construct(T* ptr, Args&& ...args) {
+    saberstl::construct(ptr, saberstl::forward<Args>(args)...);
+}
+
+template<class T>
+void polymorphic_allocator<T>::destory(T* ptr) {
+    saberstl::destory(ptr);
+}
+
+template<class T>
+void polymorphic_allocator<T>::destory(T* first, T* last) {
+    saberstl::destory(first, last);
+}
+
+/* Two polymorphic_allocators are equal when their resources are equal */
+template <class T, class U>
+bool operator==(const polymorphic_allocator<T>& lhs,
+                const polymorphic_allocator<U>& rhs) noexcept {
+    return *lhs.resource() == *rhs.resource();
+}
+
+template <class T, class U>
+bool operator!=(const polymorphic_allocator<T>& lhs,
+                const polymorphic_allocator<U>& rhs) noexcept {
+    return !(lhs == rhs);
+}
+
+/*
+ * The strings taking memory from a memory_resource, such as
+ * pmr::string s(pool_resource()) or pmr::string s("text", numa_resource(1))
+*/
+namespace pmr {
+
+template <class CharType, class CharTraits = saberstl::char_traits<CharType>>
+using basic_string = saberstl::basic_string<CharType, CharTraits, polymorphic_allocator<CharType>>;
+
+typedef basic_string<char>      string;
+typedef basic_string<wchar_t>   wstring;
+typedef basic_string<char16_t>  u16string;
+typedef basic_string<char32_t>  u32string;
+
+} // namespace pmr
+
+} // namespace saberstl
+
+#endif // !SABERSTL_MEMORY_RESOURCE_H
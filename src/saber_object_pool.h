@@ -0,0 +1,270 @@
+#ifndef SABERSTL_OBJECT_POOL_H
+#define SABERSTL_OBJECT_POOL_H
+
+/*
+ * This header file contains the template class object_pool, a pool of
+ * objects of one type for the nodes of linked lists, trees and hash tables
+*/
+
+#include <new>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "saber_alloc.h"
+#include "saber_construct.h"
+#include "saber_util.h"
+
+namespace saberstl {
+
+/* Minimum size of a slab */
+enum { ESlabMinBytes = 4096 };
+
+/*
+ * Template class: object_pool
+ * The objects live in slabs of at least N slots. A slab is a power of 2
+ * bytes and aligned to its size, so the slab of an object is found by
+ * masking its address. The free slots are linked through themselves, and
+ * a new slab is handed out slot by slot, so allocate and deallocate are
+ * O(1) with no size class lookup.
+ * Every slab keeps a bitmap of the slots in use, clear() destroys all the
+ * objects in use at once and gives all the slabs back.
+ * A pool is not thread safe, local() gives a pool for each thread. An
+ * object may still be freed by another thread through its own pool: the
+ * slab knows the pool it belongs to, and the slot is pushed on the remote
+ * list of that pool, which takes the list back when it runs out of slots.
+*/
+template <class T, size_t N = 64>
+class object_pool {
+public:
+    typedef T           value_type;
+    typedef T*          pointer;
+    typedef size_t      size_type;
+
+private:
+    union slot {
+        slot *next;
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+    };
+
+    enum : size_t { EWordBits = sizeof(size_t) * 8 };
+
+    static constexpr size_t S_pow2(size_t n, size_t p = 1) {
+        return p >= n ? p : S_pow2(n, p << 1);
+    }
+
+    static constexpr size_t S_max(size_t a, size_t b) {
+        return a < b ? b : a;
+    }
+
+    /* Bytes of a slab, the header is less than a slot and N bits */
+    static constexpr size_t S_slab_bytes = S_max(ESlabMinBytes,
+        S_pow2(N * sizeof(slot) + sizeof(slot) + N / 8 + 4 * sizeof(size_t)));
+
+    static constexpr size_t S_bitmap_words =
+        (S_slab_bytes / sizeof(slot) + EWordBits - 1) / EWordBits;
+
+    struct slab {
+        slab *next;                     // next slab
+        object_pool *owner;             // the pool of the slab
+        size_t bits[S_bitmap_words];    // slots in use
+    };
+
+    static constexpr size_t S_slots_offset =
+        (sizeof(slab) + alignof(slot) - 1) & ~(alignof(slot) - 1);
+
+    /* Number of slots in a slab */
+    static constexpr size_t S_capacity = (S_slab_bytes - S_slots_offset) / sizeof(slot);
+
+    static_assert(S_capacity >= N, "object_pool slab is too small");
+
+private:
+    slab *slabs_;       // all the slabs
+    slot *free_;        // the free slots
+    slot *bump_;        // the next slot never used of the newest slab
+    slot *bump_end_;    // end of the newest slab
+    size_type size_;    // objects in use, and freed by other threads but not taken back
+    size_type nslab_;   // number of slabs
+    std::atomic<slot*> remote_;     // slots freed by other threads
+
+public:
+    object_pool() noexcept
+    : slabs_(nullptr), free_(nullptr), bump_(nullptr), bump_end_(nullptr),
+      size_(0), nslab_(0), remote_(nullptr) {}
+
+    ~object_pool() {
+        clear();
+    }
+
+public:
+    T* allocate();
+    void deallocate(T* ptr);
+
+    template <class... Args>
+    T* create(Args&& ...args);
+    void destroy(T* ptr);
+
+    void clear();
+
+    size_type size() const noexcept { return size_; }
+    size_type capacity() const noexcept { return nslab_ * S_capacity; }
+
+    static object_pool& local();
+
+private:
+    static slab* S_slab_of(const void* ptr) noexcept {
+        return reinterpret_cast<slab*>(
+            reinterpret_cast<uintptr_t>(ptr) & ~static_cast<uintptr_t>(S_slab_bytes - 1));
+    }
+
+    static slot* S_slots(slab* s) noexcept {
+        return reinterpret_cast<slot*>(reinterpret_cast<char*>(s) + S_slots_offset);
+    }
+
+    void mark(const void* ptr, bool used) noexcept;
+    void new_slab();
+    void push_remote(slot* s) noexcept;
+    void take_remote() noexcept;
+
+private:
+    object_pool(const object_pool&);
+    void operator=(const object_pool&);
+};
+
+/* Get the space of an object, it must be constructed before clear() */
+template <class T, size_t N>
+T* object_pool<T, N>::allocate() {
+    if (free_ == nullptr && remote_.load(std::memory_order_relaxed) != nullptr) take_remote();
+    slot* s = free_;
+    if (s != nullptr) {
+        free_ = s->next;
+    } else {
+        if (bump_ == bump_end_) new_slab();
+        s = bump_++;
+    }
+    size_++;
+    mark(s, true);
+    return reinterpret_cast<T*>(s);
+}
+
+/* Give back the space of an object, the object must be destroyed. The
+   object of another pool goes to the remote list of that pool */
+template <class T, size_t N>
+void object_pool<T, N>::deallocate(T* ptr) {
+    if (ptr == nullptr) return;
+    slot* s = reinterpret_cast<slot*>(ptr);
+    object_pool* owner = S_slab_of(ptr)->owner;
+    if (owner != this) {
+        owner->push_remote(s);
+        return;
+    }
+    mark(ptr, false);
+    s->next = free_;
+    free_ = s;
+    size_--;
+}
+
+template <class T, size_t N>
+template <class... Args>
+T* object_pool<T, N>::create(Args&& ...args) {
+    T* ptr = allocate();
+    try {
+        saberstl::construct(ptr, saberstl::forward<Args>(args)...);
+    } catch (...) {
+        deallocate(ptr);
+        throw;
+    }
+    return ptr;
+}
+
+template <class T, size_t N>
+void object_pool<T, N>::destroy(T* ptr) {
+    if (ptr == nullptr) return;
+    saberstl::destory(ptr);
+    deallocate(ptr);
+}
+
+/* Destroy all the objects in use and give all the slabs back */
+template <class T, size_t N>
+void object_pool<T, N>::clear() {
+    take_remote();
+    while (slabs_ != nullptr) {
+        slab* s = slabs_;
+        slabs_ = s->next;
+        if (!std::is_trivially_destructible<T>::value) {
+            slot* slots = S_slots(s);
+            for (size_t i = 0; i < S_capacity; i++) {
+                if ((s->bits[i / EWordBits] >> (i % EWordBits)) & 1) {
+                    saberstl::destory(reinterpret_cast<T*>(slots + i));
+                }
+            }
+        }
+        alloc::deallocate(s, S_slab_bytes, S_slab_bytes);
+    }
+    free_ = bump_ = bump_end_ = nullptr;
+    size_ = 0;
+    nslab_ = 0;
+}
+
+/* The pool of current thread. Its objects are destroyed when the thread
+   exits, other threads must be done with them by then */
+template <class T, size_t N>
+object_pool<T, N>& object_pool<T, N>::local() {
+    static thread_local object_pool pool;
+    return pool;
+}
+
+/* Record whether the slot of ptr is in use, only needed to destroy objects */
+template <class T, size_t N>
+void object_pool<T, N>::mark(const void* ptr, bool used) noexcept {
+    if (std::is_trivially_destructible<T>::value) return;
+    slab* s = S_slab_of(ptr);
+    size_t i = static_cast<size_t>(reinterpret_cast<const slot*>(ptr) - S_slots(s));
+    size_t bit = static_cast<size_t>(1) << (i % EWordBits);
+    if (used) s->bits[i / EWordBits] |= bit;
+    else s->bits[i / EWordBits] &= ~bit;
+}
+
+/* Chain a new slab, its slots are handed out from the first one */
+template <class T, size_t N>
+void object_pool<T, N>::new_slab() {
+    slab* s = static_cast<slab*>(alloc::allocate(S_slab_bytes, S_slab_bytes));
+    if (s == nullptr) throw std::bad_alloc();
+    s->next = slabs_;
+    s->owner = this;
+    for (size_t w = 0; w < S_bitmap_words; w++) s->bits[w] = 0;
+    slabs_ = s;
+    bump_ = S_slots(s);
+    bump_end_ = bump_ + S_capacity;
+    nslab_++;
+}
+
+/* Called by another thread, only the list head is shared */
+template <class T, size_t N>
+void object_pool<T, N>::push_remote(slot* s) noexcept {
+    slot* head = remote_.load(std::memory_order_relaxed);
+    do {
+        s->next = head;
+    } while (!remote_.compare_exchange_weak(head, s, std::memory_order_release,
+                                            std::memory_order_relaxed));
+}
+
+/* Move the whole remote list to the free slots, it is taken at once so
+   the pushes never see a slot popped under them */
+template <class T, size_t N>
+void object_pool<T, N>::take_remote() noexcept {
+    slot* s = remote_.exchange(nullptr, std::memory_order_acquire);
+    while (s != nullptr) {
+        slot* next = s->next;
+        mark(s, false);
+        s->next = free_;
+        free_ = s;
+        size_--;
+        s = next;
+    }
+}
+
+} // namespace saberstl
+
+#endif // !SABERSTL_OBJECT_POOL_H
@@ -0,0 +1,232 @@
+#ifndef SABERSTL_PAGE_PROVIDER_H
+#define SABERSTL_PAGE_PROVIDER_H
+
+/*
+ * This header file contains the class page_provider, where the memory pool
+ * alloc gets its chunks from, and the providers: one based on std::malloc,
+ * one mapping 2 MiB huge pages to reduce TLB misses, and one placing the
+ * pages on a NUMA node
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+namespace saberstl {
+
+/* Size of a huge page */
+enum { EHugePageBytes = 2 * 1024 * 1024 };
+
+/* Most NUMA nodes told apart, the nodes over it share the pools */
+enum { EMaxNumaNodes = 8 };
+
+/* MPOL_PREFERRED of mbind, the pages fall back to other nodes when it is full */
+enum { ENumaPreferred = 1 };
+
+/*
+ * class page_provider
+ * The source of the chunks of the memory pool. allocate_pages may round
+ * bytes up and tells the real size through it, release_pages gets the
+ * same size back. The providers are kept alive until the process exits,
+ * so the destructor is not virtual and the derived classes are trivially
+ * destructible.
+*/
+class page_provider {
+public:
+    virtual void *allocate_pages(size_t& bytes) = 0;
+    virtual void release_pages(void *p, size_t bytes) = 0;
+
+protected:
+    ~page_provider() {}
+};
+
+/*
+ * class malloc_page_provider
+ * Gets the chunks from std::malloc, the default provider of alloc
+*/
+class malloc_page_provider : public page_provider {
+public:
+    void *allocate_pages(size_t& bytes) override {
+        return std::malloc(bytes);
+    }
+
+    void release_pages(void *p, size_t /*bytes*/) override {
+        std::free(p);
+    }
+};
+
+/*
+ * class huge_page_provider
+ * Maps the chunks with mmap in multiples of EHugePageBytes, aligned to
+ * EHugePageBytes and advised with MADV_HUGEPAGE, so that the kernel backs
+ * them with transparent huge pages. With explicit_pages it tries the
+ * reserved huge pages (MAP_HUGETLB) first. Falls back to std::malloc on
+ * the systems without mmap.
+*/
+class huge_page_provider : public page_provider {
+private:
+    bool explicit_pages_;
+
+public:
+    explicit huge_page_provider(bool explicit_pages = false) noexcept
+    : explicit_pages_(explicit_pages) {}
+
+    void *allocate_pages(size_t& bytes) override;
+    void release_pages(void *p, size_t bytes) override;
+};
+
+inline void* huge_page_provider::allocate_pages(size_t& bytes) {
+#if defined(__unix__) || defined(__APPLE__)
+    const size_t page = static_cast<size_t>(EHugePageBytes);
+    bytes = (bytes + page - 1) & ~(page - 1);
+#ifdef MAP_HUGETLB
+    if (explicit_pages_) {
+        void *p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) return p;
+    }
+#endif
+    /* Map one more huge page, then unmap the parts out of the aligned range */
+    size_t len = bytes + page;
+    void *raw = mmap(nullptr, len, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) return nullptr;
+    char *begin = static_cast<char*>(raw);
+    char *p = reinterpret_cast<char*>(
+        (reinterpret_cast<uintptr_t>(begin) + page - 1) & ~static_cast<uintptr_t>(page - 1));
+    if (p != begin) munmap(begin, p - begin);
+    if (p + bytes != begin + len) munmap(p + bytes, begin + len - (p + bytes));
+#ifdef MADV_HUGEPAGE
+    madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+    return p;
+#else
+    return std::malloc(bytes);
+#endif
+}
+
+inline void huge_page_provider::release_pages(void *p, size_t bytes) {
+#if defined(__unix__) || defined(__APPLE__)
+    munmap(p, bytes);
+#else
+    (void)bytes;
+    std::free(p);
+#endif
+}
+
+/*
+ * Number of NUMA nodes of the system, read from sysfs once, 1 when the
+ * system has no NUMA or is not Linux. It is at most EMaxNumaNodes.
+*/
+inline size_t numa_node_count() noexcept {
+    static const size_t count = []() -> size_t {
+        size_t n = 1;
+#if defined(__linux__)
+        std::FILE *f = std::fopen("/sys/devices/system/node/online", "r");
+        if (f == nullptr) return 1;
+        /* A list of ranges such as "0-1,3", the largest id counts */
+        unsigned id;
+        char sep;
+        while (std::fscanf(f, "%u", &id) == 1) {
+            if (id + 1 > n) n = id + 1;
+            if (std::fscanf(f, "%c", &sep) != 1) break;
+        }
+        std::fclose(f);
+#endif
+        return n < static_cast<size_t>(EMaxNumaNodes) ? n : static_cast<size_t>(EMaxNumaNodes);
+    }();
+    return count;
+}
+
+/* The NUMA node current thread runs on, 0 when it is unknown */
+inline size_t numa_current_node() noexcept {
+    size_t count = numa_node_count();
+    if (count == 1) return 0;
+#if defined(__linux__) && defined(SYS_getcpu)
+    unsigned cpu = 0, node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0) return node % count;
+#endif
+    return 0;
+}
+
+/*
+ * class numa_page_provider
+ * Maps the chunks with mmap and asks the kernel with mbind to place them
+ * on the node. If mbind is not available or fails, the pages still go to
+ * the node of the thread touching them first, which is the thread that
+ * grows the pool of the node. Falls back to std::malloc on the systems
+ * without mmap.
+*/
+class numa_page_provider : public page_provider {
+private:
+    size_t node_;
+
+public:
+    explicit numa_page_provider(size_t node = 0) noexcept : node_(node) {}
+
+    size_t node() const noexcept { return node_; }
+
+    void *allocate_pages(size_t& bytes) override;
+    void release_pages(void *p, size_t bytes) override;
+};
+
+inline void* numa_page_provider::allocate_pages(size_t& bytes) {
+#if defined(__unix__) || defined(__APPLE__)
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    bytes = (bytes + page - 1) & ~(page - 1);
+    void *p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) return nullptr;
+#if defined(__linux__) && defined(SYS_mbind)
+    unsigned long mask = 1ul << node_;
+    syscall(SYS_mbind, p, bytes, ENumaPreferred, &mask, sizeof(mask) * 8, 0);
+#endif
+    return p;
+#else
+    return std::malloc(bytes);
+#endif
+}
+
+inline void numa_page_provider::release_pages(void *p, size_t bytes) {
+#if defined(__unix__) || defined(__APPLE__)
+    munmap(p, bytes);
+#else
+    (void)bytes;
+    std::free(p);
+#endif
+}
+
+/* The providers shared by the whole program */
+inline page_provider* malloc_pages() noexcept {
+    static malloc_page_provider provider;
+    return &provider;
+}
+
+inline page_provider* huge_pages() noexcept {
+    static huge_page_provider provider;
+    return &provider;
+}
+
+/* The provider of node, node < EMaxNumaNodes */
+inline page_provider* numa_pages(size_t node) noexcept {
+    static numa_page_provider providers[EMaxNumaNodes] = {
+        numa_page_provider(0), numa_page_provider(1), numa_page_provider(2),
+        numa_page_provider(3), numa_page_provider(4), numa_page_provider(5),
+        numa_page_provider(6), numa_page_provider(7)
+    };
+    return providers + node;
+}
+
+} // namespace saberstl
+
+#endif // !SABERSTL_PAGE_PROVIDER_H
@@ -0,0 +1,610 @@
+#ifndef SABERSTL_ROPE_H
+#define SABERSTL_ROPE_H
+
+// Template Class: basic_rope
+
+#include <new>
+#include <atomic>
+#include <iostream>
+
+#include "saber_basic_string.h"
+
+namespace saberstl {
+
+// Most bytes of characters in a leaf built from a long string
+enum { ERopeLeafBytes = 1024 };
+
+// Two adjacent leaves of at most this many bytes together are merged
+enum { ERopeMergeBytes = 256 };
+
+// Most height of a rope, an AVL tree of 2^64 leaves is lower than it
+enum { ERopeMaxHeight = 96 };
+
+// template class basic_rope
+// A string kept as an AVL tree of immutable, reference counted nodes: the
+// leaves hold the characters and the inner nodes concatenate two subtrees.
+// A node is never changed once built, so copying a rope shares the root,
+// and concatenation, substr, insert and erase build O(log n) new nodes
+// along one or two paths while sharing the rest of the trees. Short
+// adjacent leaves are merged as they are joined, so appending small pieces
+// does not leave a leaf per piece. The counts are atomic, so ropes sharing
+// nodes can live in different threads.
+// Parameter 1 represents the type of string;
+// Parameter 2 represents the solution of extraction type of string, default using saberstl::char_traits
+template <class CharType, class CharTraits = saberstl::char_traits<CharType>>
+class basic_rope {
+public:
+    typedef CharTraits                                  traits_type;
+    typedef CharTraits                                  char_traits;
+
+    typedef CharType                                    value_type;
+    typedef CharType*                                   pointer;
+    typedef const CharType*                             const_pointer;
+    typedef size_t                                      size_type;
+    typedef ptrdiff_t                                   difference_type;
+
+    typedef basic_string<CharType, CharTraits>          string_type;
+    typedef basic_string_view<CharType, CharTraits>     string_view_type;
+
+    typedef saberstl::allocator<char>                   node_allocator;
+
+    static constexpr size_type npos = static_cast<size_type>(-1);
+
+private:
+    // A leaf if left is nullptr, its characters follow the node
+    struct node {
+        std::atomic<size_t> refs;   // ropes and nodes referring to it
+        size_type size;             // characters under the node
+        size_type height;           // 0 for a leaf
+        node* left;
+        node* right;
+
+        node(size_type n, size_type h, node* l, node* r) noexcept
+        : refs(1), size(n), height(h), left(l), right(r) {}
+
+        bool is_leaf() const noexcept { return left == nullptr; }
+        pointer chars() noexcept { return reinterpret_cast<pointer>(this + 1); }
+        const_pointer chars() const noexcept { return reinterpret_cast<const_pointer>(this + 1); }
+    };
+
+    enum : size_t {
+        ELeafMax = ERopeLeafBytes / sizeof(CharType) > 0 ? ERopeLeafBytes / sizeof(CharType) : 1,
+        EMergeMax = ERopeMergeBytes / sizeof(CharType)
+    };
+
+    node* root_;    // Store the tree, nullptr for the empty rope
+
+public:
+    // chunk_iterator
+    // Walks the leaves from left to right, each chunk is a view of the
+    // characters of one leaf, valid while a rope refers to the leaf. The
+    // stack keeps the nodes whose right subtrees are still to be walked; a
+    // node may be both children of its parent, so the path alone would not do.
+    class chunk_iterator {
+    private:
+        const node* stack_[ERopeMaxHeight];     // nodes to go right from
+        size_type top_;                         // nodes in the stack
+        const node* leaf_;                      // the current leaf, nullptr for the end
+
+    public:
+        typedef saberstl::forward_iterator_tag  iterator_category;
+        typedef string_view_type                value_type;
+        typedef ptrdiff_t                       difference_type;
+        typedef const string_view_type*         pointer;
+        typedef string_view_type                reference;
+
+        chunk_iterator() noexcept : top_(0), leaf_(nullptr) {}
+        explicit chunk_iterator(const node* root) noexcept : top_(0), leaf_(nullptr) {
+            if (root != nullptr) descend(root);
+        }
+
+        string_view_type operator*() const noexcept {
+            return string_view_type(leaf_->chars(), leaf_->size);
+        }
+
+        chunk_iterator& operator++() noexcept {
+            if (top_ == 0) leaf_ = nullptr;
+            else descend(stack_[--top_]->right);
+            return *this;
+        }
+        chunk_iterator operator++(int) noexcept {
+            chunk_iterator tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        bool operator==(const chunk_iterator& rhs) const noexcept {
+            return leaf_ == rhs.leaf_ && top_ == rhs.top_;
+        }
+        bool operator!=(const chunk_iterator& rhs) const noexcept { return !(*this == rhs); }
+
+    private:
+        void descend(const node* p) noexcept {
+            while (!p->is_leaf()) {
+                stack_[top_++] = p;
+                p = p->left;
+            }
+            leaf_ = p;
+        }
+    };
+
+public:
+    basic_rope() noexcept : root_(nullptr) {}
+
+    basic_rope(const_pointer str) : root_(S_build(str, char_traits::length(str))) {}
+    basic_rope(const_pointer str, size_type count) : root_(S_build(str, count)) {}
+    explicit basic_rope(string_view_type str) : root_(S_build(str.data(), str.size())) {}
+    explicit basic_rope(const string_type& str) : root_(S_build(str.data(), str.size())) {}
+
+    basic_rope(const basic_rope& rhs) noexcept : root_(S_retain(rhs.root_)) {}
+    basic_rope(basic_rope&& rhs) noexcept : root_(rhs.root_) {
+        rhs.root_ = nullptr;
+    }
+
+    basic_rope& operator=(const basic_rope& rhs) noexcept {
+        node* old = root_;
+        root_ = S_retain(rhs.root_);
+        S_release(old);
+        return *this;
+    }
+    basic_rope& operator=(basic_rope&& rhs) noexcept {
+        if (this != &rhs) {
+            S_release(root_);
+            root_ = rhs.root_;
+            rhs.root_ = nullptr;
+        }
+        return *this;
+    }
+
+    ~basic_rope() {
+        S_release(root_);
+    }
+
+public:
+    // Capacity operations
+    bool empty() const noexcept { return root_ == nullptr; }
+    size_type size() const noexcept { return root_ == nullptr ? 0 : root_->size; }
+    size_type length() const noexcept { return size(); }
+    size_type height() const noexcept { return root_ == nullptr ? 0 : root_->height; }
+
+    // Access the elements, O(log n)
+    value_type operator[](size_type n) const noexcept {
+        SABERSTL_DEBUG(n < size());
+        const node* p = root_;
+        while (!p->is_leaf()) {
+            if (n < p->left->size) {
+                p = p->left;
+            } else {
+                n -= p->left->size;
+                p = p->right;
+            }
+        }
+        return p->chars()[n];
+    }
+    value_type at(size_type n) const {
+        THROW_OUT_OF_RANGE_IF(n >= size(), "basic_rope<Char, Traits>::at() subscript out of range");
+        return (*this)[n];
+    }
+    value_type front() const noexcept { return (*this)[0]; }
+    value_type back() const noexcept { return (*this)[size() - 1]; }
+
+    // The leaves in order
+    chunk_iterator chunk_begin() const noexcept { return chunk_iterator(root_); }
+    chunk_iterator chunk_end() const noexcept { return chunk_iterator(); }
+
+    template <class Func>
+    void for_each_chunk(Func f) const {
+        for (chunk_iterator it = chunk_begin(); it != chunk_end(); ++it) f(*it);
+    }
+
+    // Modify the rope, O(log n) each
+    void clear() noexcept {
+        S_release(root_);
+        root_ = nullptr;
+    }
+
+    basic_rope& append(const basic_rope& str) {
+        root_ = S_join(root_, S_retain(str.root_));
+        return *this;
+    }
+    basic_rope& append(string_view_type str) {
+        root_ = S_join(root_, S_build(str.data(), str.size()));
+        return *this;
+    }
+    basic_rope& append(const_pointer str) {
+        return append(string_view_type(str));
+    }
+    void push_back(value_type ch) {
+        append(string_view_type(&ch, 1));
+    }
+
+    basic_rope& operator+=(const basic_rope& str) { return append(str); }
+    basic_rope& operator+=(string_view_type str) { return append(str); }
+    basic_rope& operator+=(const_pointer str) { return append(str); }
+    basic_rope& operator+=(value_type ch) { push_back(ch); return *this; }
+
+    basic_rope& insert(size_type pos, const basic_rope& str) {
+        return replace(pos, 0, str);
+    }
+    basic_rope& insert(size_type pos, string_view_type str) {
+        return replace(pos, 0, basic_rope(str));
+    }
+    basic_rope& insert(size_type pos, const_pointer str) {
+        return insert(pos, string_view_type(str));
+    }
+
+    basic_rope& erase(size_type pos = 0, size_type count = npos) {
+        return replace(pos, count, basic_rope());
+    }
+
+    basic_rope& replace(size_type pos, size_type count, const basic_rope& str);
+    basic_rope& replace(size_type pos, size_type count, string_view_type str) {
+        return replace(pos, count, basic_rope(str));
+    }
+    basic_rope& replace(size_type pos, size_type count, const_pointer str) {
+        return replace(pos, count, string_view_type(str));
+    }
+
+    // The characters in [pos, pos + count), sharing the nodes of this rope
+    basic_rope substr(size_type pos = 0, size_type count = npos) const;
+
+    // Copy the characters into a basic_string, once
+    string_type flatten() const;
+    size_type copy(pointer dest, size_type count, size_type pos = 0) const;
+
+    int compare(const basic_rope& other) const noexcept;
+
+    void swap(basic_rope& rhs) noexcept {
+        saberstl::swap(root_, rhs.root_);
+    }
+
+private:
+    explicit basic_rope(node* root) noexcept : root_(root) {}
+
+    // helper functions
+    static size_type S_height(const node* p) noexcept { return p == nullptr ? 0 : p->height; }
+
+    static node* S_retain(node* p) noexcept {
+        if (p != nullptr) p->refs.fetch_add(1, std::memory_order_relaxed);
+        return p;
+    }
+    static void S_release(node* p) noexcept;
+
+    static node* S_new_leaf(const_pointer str, size_type n);
+    static node* S_new_leaf(const_pointer s1, size_type n1, const_pointer s2, size_type n2);
+    static node* S_new_concat(node* l, node* r);
+    static node* S_place_concat(char* raw, node* l, node* r) noexcept {
+        return ::new (raw) node(l->size + r->size, saberstl::max(l->height, r->height) + 1, l, r);
+    }
+    static node* S_build(const_pointer str, size_type n);
+
+    static node* S_balance(node* l, node* r);
+    static node* S_join(node* l, node* r);
+    static void S_split(node* p, size_type pos, node*& l, node*& r);
+};
+
+/*****************************************************************************************/
+
+template <class CharType, class CharTraits>
+constexpr typename basic_rope<CharType, CharTraits>::size_type
+basic_rope<CharType, CharTraits>::npos;
+
+// Replace [pos, pos + count) with str
+template <class CharType, class CharTraits>
+basic_rope<CharType, CharTraits>&
+basic_rope<CharType, CharTraits>::replace(size_type pos, size_type count, const basic_rope& str) {
+    const size_type n = size();
+    THROW_OUT_OF_RANGE_IF(pos > n, "basic_rope<Char, Traits>'s pos out of range");
+    count = saberstl::min(count, n - pos);
+    // Hold str first, the splits give up root_, which str may be
+    node* ins = S_retain(str.root_);
+    node *head, *rest, *mid, *tail;
+    S_split(root_, pos, head, rest);
+    S_split(rest, count, mid, tail);
+    S_release(mid);
+    root_ = S_join(S_join(head, ins), tail);
+    return *this;
+}
+
+template <class CharType, class CharTraits>
+basic_rope<CharType, CharTraits>
+basic_rope<CharType, CharTraits>::substr(size_type pos, size_type count) const {
+    const size_type n = size();
+    THROW_OUT_OF_RANGE_IF(pos > n, "basic_rope<Char, Traits>'s pos out of range");
+    count = saberstl::min(count, n - pos);
+    node *head, *rest, *mid, *tail;
+    S_split(S_retain(root_), pos, head, rest);
+    S_split(rest, count, mid, tail);
+    S_release(head);
+    S_release(tail);
+    return basic_rope(mid);
+}
+
+template <class CharType, class CharTraits>
+typename basic_rope<CharType, CharTraits>::string_type
+basic_rope<CharType, CharTraits>::flatten() const {
+    string_type result;
+    result.reserve(size());
+    for (chunk_iterator it = chunk_begin(); it != chunk_end(); ++it) result.append(*it);
+    return result;
+}
+
+template <class CharType, class CharTraits>
+typename basic_rope<CharType, CharTraits>::size_type
+basic_rope<CharType, CharTraits>::copy(pointer dest, size_type count, size_type pos) const {
+    THROW_OUT_OF_RANGE_IF(pos > size(), "basic_rope<Char, Traits>'s pos out of range");
+    count = saberstl::min(count, size() - pos);
+    size_type done = 0;
+    for (chunk_iterator it = chunk_begin(); it != chunk_end() && done < count; ++it) {
+        string_view_type chunk = *it;
+        if (pos >= chunk.size()) {
+            pos -= chunk.size();
+            continue;
+        }
+        done += chunk.copy(dest + done, count - done, pos);
+        pos = 0;
+    }
+    return done;
+}
+
+// Compare chunk by chunk, the leaves of two ropes need not line up
+template <class CharType, class CharTraits>
+int basic_rope<CharType, CharTraits>::compare(const basic_rope& other) const noexcept {
+    chunk_iterator it1 = chunk_begin(), it2 = other.chunk_begin();
+    string_view_type c1, c2;
+    for (;;) {
+        if (c1.empty() && it1 != chunk_end()) c1 = *it1++;
+        if (c2.empty() && it2 != other.chunk_end()) c2 = *it2++;
+        if (c1.empty() || c2.empty()) break;
+        const size_type n = saberstl::min(c1.size(), c2.size());
+        const int res = char_traits::compare(c1.data(), c2.data(), n);
+        if (res != 0) return res;
+        c1.remove_prefix(n);
+        c2.remove_prefix(n);
+    }
+    if (c1.empty() && c2.empty()) return 0;
+    return c1.empty() ? -1 : 1;
+}
+
+/*****************************************************************************************/
+// helper function
+
+// Drop a reference, free the node and drop its children when it is the last
+template <class CharType, class CharTraits>
+void basic_rope<CharType, CharTraits>::S_release(node* p) noexcept {
+    while (p != nullptr && p->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        node* l = p->left;
+        node* r = p->right;
+        const size_t bytes = sizeof(node) + (p->is_leaf() ? p->size * sizeof(CharType) : 0);
+        p->~node();
+        node_allocator::deallocate(reinterpret_cast<char*>(p), bytes);
+        // Recurse into one side only, the depth is bounded by the height
+        S_release(l);
+        p = r;
+    }
+}
+
+template <class CharType, class CharTraits>
+typename basic_rope<CharType, CharTraits>::node*
+basic_rope<CharType, CharTraits>::S_new_leaf(const_pointer str, size_type n) {
+    return S_new_leaf(str, n, nullptr, 0);
+}
+
+// A leaf of [s1, s1 + n1) followed by [s2, s2 + n2)
+template <class CharType, class CharTraits>
+typename basic_rope<CharType, CharTraits>::node*
+basic_rope<CharType, CharTraits>::
+S_new_leaf(const_pointer s1, size_type n1, const_pointer s2, size_type n2) {
+    char* raw = node_allocator::allocate(sizeof(node) + (n1 + n2) * sizeof(CharType));
+    node* p = ::new (raw) node(n1 + n2, 0, nullptr, nullptr);
+    char_traits::copy(p->chars(), s1, n1);
+    char_traits::copy(p->chars() + n1, s2, n2);
+    return p;
+}
+
+// Take the references of l and r
+template <class CharType, class CharTraits>
+typename basic_rope<CharType, CharTraits>::node*
+basic_rope<CharType, CharTraits>::S_new_concat(node* l, node* r) {
+    char* raw;
+    try {
+        raw = node_allocator::allocate(sizeof(node));
+    }
+    catch (...) {
+        S_release(l);
+        S_release(r);
+        throw;
+    }
+    return S_place_concat(raw, l, r);
+}
+
+// A balanced tree of leaves of ELeafMax characters, nullptr for none
+template <class CharType, class CharTraits>
+typename basic_rope<CharType, CharTraits>::node*
+basic_rope<CharType, CharTraits>::S_build(const_pointer str, size_type n) {
+    if (n == 0) return nullptr;
+    if (n <= ELeafMax) return S_new_leaf(str, n);
+    const size_type half = (n / ELeafMax + 1) / 2 * ELeafMax;
+    node* l = S_build(str, half);
+    node* r;
+    try {
+        r = S_build(str + half, n - half);
+    }
+    catch (...) {
+        S_release(l);
+        throw;
+    }
+    return S_new_concat(l, r);
+}
+
+// Concatenate l and r whose heights differ by at most 2, rotating once
+// or twice as an AVL tree does; the rotated nodes are copied, not changed.
+// The new nodes are allocated before any reference moves, so a throw only
+// has l and r to give back.
+template <class CharType, class CharTraits>
+typename basic_rope<CharType, CharTraits>::node*
+basic_rope<CharType, CharTraits>::S_balance(node* l, node* r) {
+    size_t need = 1;
+    if (l->height > r->height + 1)
+        need = l->left->height >= l->right->height ? 2 : 3;
+    else if (r->height > l->height + 1)
+        need = r->right->height >= r->left->height ? 2 : 3;
+    char* raw[3];
+    size_t got = 0;
+    try {
+        for (; got < need; ++got) raw[got] = node_allocator::allocate(sizeof(node));
+    }
+    catch (...) {
+        while (got > 0) node_allocator::deallocate(raw[--got], sizeof(node));
+        S_release(l);
+        S_release(r);
+        throw;
+    }
+    if (l->height > r->height + 1) {
+        node* ll = S_retain(l->left);
+        node* lr = S_retain(l->right);
+        S_release(l);
+        if (need == 2) return S_place_concat(raw[0], ll, S_place_concat(raw[1], lr, r));
+        node* lrl = S_retain(lr->left);
+        node* lrr = S_retain(lr->right);
+        S_release(lr);
+        return S_place_concat(raw[0], S_place_concat(raw[1], ll, lrl),
+                              S_place_concat(raw[2], lrr, r));
+    }
+    if (r->height > l->height + 1) {
+        node* rl = S_retain(r->left);
+        node* rr = S_retain(r->right);
+        S_release(r);
+        if (need == 2) return S_place_concat(raw[0], S_place_concat(raw[1], l, rl), rr);
+        node* rll = S_retain(rl->left);
+        node* rlr = S_retain(rl->right);
+        S_release(rl);
+        return S_place_concat(raw[0], S_place_concat(raw[1], l, rll),
+                              S_place_concat(raw[2], rlr, rr));
+    }
+    return S_place_concat(raw[0], l, r);
+}
+
+// Concatenate l and r, taking their references. The shorter tree goes down
+// the side of the taller one until the heights are close, so it costs
+// O(|height of l - height of r|). A short leaf joining a short leaf at the
+// edge of the other tree is merged with it.
+template <class CharType, class CharTraits>
+typename basic_rope<CharType, CharTraits>::node*
+basic_rope<CharType, CharTraits>::S_join(node* l, node* r) {
+    if (l == nullptr) return r;
+    if (r == nullptr) return l;
+    if (l->is_leaf() && r->is_leaf() && l->size + r->size <= EMergeMax) {
+        node* p = S_new_leaf(l->chars(), l->size, r->chars(), r->size);
+        S_release(l);
+        S_release(r);
+        return p;
+    }
+    if (l->height > r->height + 1 || (r->is_leaf() && !l->is_leaf() &&
+        l->right->is_leaf() && l->right->size + r->size <= EMergeMax)) {
+        node* ll = S_retain(l->left);
+        node* lr = S_retain(l->right);
+        S_release(l);
+        return S_balance(ll, S_join(lr, r));
+    }
+    if (r->height > l->height + 1 || (l->is_leaf() && !r->is_leaf() &&
+        r->left->is_leaf() && l->size + r->left->size <= EMergeMax)) {
+        node* rl = S_retain(r->left);
+        node* rr = S_retain(r->right);
+        S_release(r);
+        return S_balance(S_join(l, rl), rr);
+    }
+    return S_new_concat(l, r);
+}
+
+// Split p at pos into l and r, taking the reference of p
+template <class CharType, class CharTraits>
+void basic_rope<CharType, CharTraits>::S_split(node* p, size_type pos, node*& l, node*& r) {
+    if (p == nullptr || pos == 0) {
+        l = nullptr;
+        r = p;
+        return;
+    }
+    if (pos >= p->size) {
+        l = p;
+        r = nullptr;
+        return;
+    }
+    if (p->is_leaf()) {
+        l = S_new_leaf(p->chars(), pos);
+        try {
+            r = S_new_leaf(p->chars() + pos, p->size - pos);
+        }
+        catch (...) {
+            S_release(l);
+            S_release(p);
+            throw;
+        }
+        S_release(p);
+        return;
+    }
+    node* pl = S_retain(p->left);
+    node* pr = S_retain(p->right);
+    S_release(p);
+    if (pos < pl->size) {
+        node* mid;
+        S_split(pl, pos, l, mid);
+        r = S_join(mid, pr);
+    } else {
+        node* mid;
+        S_split(pr, pos - pl->size, mid, r);
+        l = S_join(pl, mid);
+    }
+}
+
+/*****************************************************************************************/
+
+// Overload operators
+template <class CharType, class CharTraits>
+basic_rope<CharType, CharTraits>
+operator+(const basic_rope<CharType, CharTraits>& lhs,
+          const basic_rope<CharType, CharTraits>& rhs) {
+    basic_rope<CharType, CharTraits> result(lhs);
+    result.append(rhs);
+    return result;
+}
+
+template <class CharType, class CharTraits>
+bool operator==(const basic_rope<CharType, CharTraits>& lhs,
+                const basic_rope<CharType, CharTraits>& rhs) noexcept {
+    return lhs.size() == rhs.size() && lhs.compare(rhs) == 0;
+}
+
+template <class CharType, class CharTraits>
+bool operator!=(const basic_rope<CharType, CharTraits>& lhs,
+                const basic_rope<CharType, CharTraits>& rhs) noexcept {
+    return !(lhs == rhs);
+}
+
+template <class CharType, class CharTraits>
+bool operator<(const basic_rope<CharType, CharTraits>& lhs,
+               const basic_rope<CharType, CharTraits>& rhs) noexcept {
+    return lhs.compare(rhs) < 0;
+}
+
+// Overload saberstl swap
+template <class CharType, class CharTraits>
+void swap(basic_rope<CharType, CharTraits>& lhs,
+          basic_rope<CharType, CharTraits>& rhs) noexcept {
+    lhs.swap(rhs);
+}
+
+// Output the rope chunk by chunk
+template <class CharType, class CharTraits>
+std::basic_ostream<CharType>& operator<<(std::basic_ostream<CharType>& os,
+                                         const basic_rope<CharType, CharTraits>& str) {
+    for (auto it = str.chunk_begin(); it != str.chunk_end(); ++it) os << *it;
+    return os;
+}
+
+typedef basic_rope<char>      rope;
+typedef basic_rope<wchar_t>   wrope;
+
+} // namespace saberstl
+
+#endif // !SABERSTL_ROPE_H
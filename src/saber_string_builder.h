@@ -0,0 +1,359 @@
+#ifndef SABERSTL_STRING_BUILDER_H
+#define SABERSTL_STRING_BUILDER_H
+
+// Template Class: basic_string_builder
+
+#include <cstdarg>
+#include <cstddef>
+#include <cstdio>
+#include <type_traits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/uio.h>
+#endif
+
+#include "saber_basic_string.h"
+#include "saber_charconv.h"
+#include "saber_arena.h"
+
+namespace saberstl {
+
+// Bytes of the first chunk of a builder
+enum { EBuilderInitBytes = 256 };
+
+// Chunks stop doubling when they reach this size
+enum { EBuilderMaxChunkBytes = 64 * 1024 };
+
+// template class basic_string_builder
+// Collects appended text in a chain of chunks. A full chunk is never copied
+// or moved, the next one is twice as large up to EBuilderMaxChunkBytes, so
+// growing costs no copy at all. The text is copied once when it is turned
+// into a basic_string of the exact size, or not at all when the chunks are
+// written out through iovec. The chunks come from the allocator, or from a
+// monotonic_arena given to the constructor, which then owns them.
+// Parameter 1 represents the type of string;
+// Parameter 2 represents the solution of extraction type of string, default using saberstl::char_traits
+template <class CharType, class CharTraits = saberstl::char_traits<CharType>>
+class basic_string_builder {
+public:
+    typedef CharTraits                                  traits_type;
+    typedef CharTraits                                  char_traits;
+
+    typedef CharType                                    value_type;
+    typedef CharType*                                   pointer;
+    typedef const CharType*                             const_pointer;
+    typedef size_t                                      size_type;
+
+    typedef basic_string<CharType, CharTraits>          string_type;
+    typedef basic_string_view<CharType, CharTraits>     string_view_type;
+
+    typedef saberstl::allocator<char>                   chunk_allocator;
+
+private:
+    // The characters follow the header
+    struct chunk {
+        chunk* next;
+        size_type size;     // characters written
+        size_type cap;      // characters it holds
+
+        pointer chars() noexcept { return reinterpret_cast<pointer>(this + 1); }
+        const_pointer chars() const noexcept { return reinterpret_cast<const_pointer>(this + 1); }
+    };
+
+    chunk* head_;               // The first chunk
+    chunk* tail_;               // The chunk being written
+    size_type size_;            // Characters in all the chunks
+    size_type next_cap_;        // Capacity of the next chunk
+    monotonic_arena* arena_;    // Where the chunks come from, nullptr for the allocator
+
+public:
+    basic_string_builder() noexcept
+    : head_(nullptr), tail_(nullptr), size_(0),
+      next_cap_(S_init_cap()), arena_(nullptr) {}
+
+    explicit basic_string_builder(monotonic_arena& arena) noexcept
+    : head_(nullptr), tail_(nullptr), size_(0),
+      next_cap_(S_init_cap()), arena_(&arena) {}
+
+    basic_string_builder(basic_string_builder&& rhs) noexcept
+    : head_(rhs.head_), tail_(rhs.tail_), size_(rhs.size_),
+      next_cap_(rhs.next_cap_), arena_(rhs.arena_) {
+        rhs.head_ = rhs.tail_ = nullptr;
+        rhs.size_ = 0;
+        rhs.next_cap_ = S_init_cap();
+    }
+
+    basic_string_builder& operator=(basic_string_builder&& rhs) noexcept;
+
+    ~basic_string_builder() {
+        release();
+    }
+
+public:
+    bool empty() const noexcept { return size_ == 0; }
+    size_type size() const noexcept { return size_; }
+    size_type length() const noexcept { return size_; }
+
+    // Drop the text; the chunks of the allocator are given back, the ones
+    // of an arena wait for the arena
+    void clear() noexcept {
+        release();
+        next_cap_ = S_init_cap();
+    }
+
+    // append
+    basic_string_builder& append(const_pointer str, size_type count);
+    basic_string_builder& append(string_view_type str) {
+        return append(str.data(), str.size());
+    }
+    basic_string_builder& append(const_pointer str) {
+        return append(str, char_traits::length(str));
+    }
+    basic_string_builder& append(size_type count, value_type ch);
+
+    void push_back(value_type ch) {
+        if (tail_ == nullptr || tail_->size == tail_->cap) add_chunk(1);
+        tail_->chars()[tail_->size++] = ch;
+        size_++;
+    }
+
+    // Append a number as to_chars writes it, in the chunk when it has room
+    template <class T, typename std::enable_if<std::is_arithmetic<T>::value &&
+      !std::is_same<T, bool>::value, int>::type = 0>
+    basic_string_builder& append_number(T value);
+
+    // Append the text of printf(fmt, ...). vsnprintf writes into the room
+    // left in the chunk; when the text does not fit, it is formatted again
+    // into a new chunk of its size and the room is left unused
+    template <class C = CharType, typename std::enable_if<
+      std::is_same<C, char>::value, int>::type = 0>
+    __attribute__((format(printf, 2, 3)))
+    basic_string_builder& appendf(const char* fmt, ...);
+
+    basic_string_builder& operator<<(value_type ch) { push_back(ch); return *this; }
+    basic_string_builder& operator<<(const_pointer str) { return append(str); }
+    basic_string_builder& operator<<(string_view_type str) { return append(str); }
+    basic_string_builder& operator<<(const string_type& str) { return append(str.data(), str.size()); }
+
+    template <class T, typename std::enable_if<std::is_arithmetic<T>::value &&
+      !std::is_same<T, bool>::value && !std::is_same<T, value_type>::value &&
+      !std::is_same<T, char>::value, int>::type = 0>
+    basic_string_builder& operator<<(T value) { return append_number(value); }
+
+    // The text as a basic_string of the exact size, copied once
+    string_type str() const;
+    // Copy the text to dest, which holds size() characters
+    void copy(pointer dest) const noexcept;
+
+    // The chunks in order
+    size_type chunk_count() const noexcept;
+    template <class Func>
+    void for_each_chunk(Func f) const {
+        for (const chunk* c = head_; c != nullptr; c = c->next) {
+            if (c->size != 0) f(string_view_type(c->chars(), c->size));
+        }
+    }
+
+#if defined(__unix__) || defined(__APPLE__)
+    // Fill at most count iovec with the chunks for writev, return how many are used
+    size_type to_iovec(struct iovec* iov, size_type count) const noexcept;
+#endif
+
+private:
+    static size_type S_init_cap() noexcept {
+        return EBuilderInitBytes / sizeof(CharType) > 0 ? EBuilderInitBytes / sizeof(CharType) : 1;
+    }
+
+    // Chain a chunk with room for at least need characters
+    void add_chunk(size_type need);
+    void release() noexcept;
+
+private:
+    basic_string_builder(const basic_string_builder&);
+    void operator=(const basic_string_builder&);
+};
+
+/*****************************************************************************************/
+
+template <class CharType, class CharTraits>
+basic_string_builder<CharType, CharTraits>&
+basic_string_builder<CharType, CharTraits>::operator=(basic_string_builder&& rhs) noexcept {
+    if (this != &rhs) {
+        release();
+        head_ = rhs.head_;
+        tail_ = rhs.tail_;
+        size_ = rhs.size_;
+        next_cap_ = rhs.next_cap_;
+        arena_ = rhs.arena_;
+        rhs.head_ = rhs.tail_ = nullptr;
+        rhs.size_ = 0;
+        rhs.next_cap_ = S_init_cap();
+    }
+    return *this;
+}
+
+// Fill the current chunk, then put the rest into a new one
+template <class CharType, class CharTraits>
+basic_string_builder<CharType, CharTraits>&
+basic_string_builder<CharType, CharTraits>::append(const_pointer str, size_type count) {
+    if (tail_ != nullptr) {
+        const size_type n = saberstl::min(count, tail_->cap - tail_->size);
+        char_traits::copy(tail_->chars() + tail_->size, str, n);
+        tail_->size += n;
+        size_ += n;
+        str += n;
+        count -= n;
+    }
+    if (count != 0) {
+        add_chunk(count);
+        char_traits::copy(tail_->chars(), str, count);
+        tail_->size = count;
+        size_ += count;
+    }
+    return *this;
+}
+
+template <class CharType, class CharTraits>
+basic_string_builder<CharType, CharTraits>&
+basic_string_builder<CharType, CharTraits>::append(size_type count, value_type ch) {
+    while (count != 0) {
+        if (tail_ == nullptr || tail_->size == tail_->cap) add_chunk(count);
+        const size_type n = saberstl::min(count, tail_->cap - tail_->size);
+        char_traits::fill(tail_->chars() + tail_->size, ch, n);
+        tail_->size += n;
+        size_ += n;
+        count -= n;
+    }
+    return *this;
+}
+
+// A char builder writes the number in the chunk, others widen it from a buffer
+template <class CharType, class CharTraits>
+template <class T, typename std::enable_if<std::is_arithmetic<T>::value &&
+  !std::is_same<T, bool>::value, int>::type>
+basic_string_builder<CharType, CharTraits>&
+basic_string_builder<CharType, CharTraits>::append_number(T value) {
+    const size_type most = std::is_integral<T>::value ? EMaxIntegerChars : EMaxDoubleChars;
+    if (std::is_same<CharType, char>::value) {
+        if (tail_ == nullptr || tail_->cap - tail_->size < most) add_chunk(most);
+        char* p = reinterpret_cast<char*>(tail_->chars() + tail_->size);
+        const size_type n = to_chars(p, p + most, value).ptr - p;
+        tail_->size += n;
+        size_ += n;
+    } else {
+        char buf[EMaxIntegerChars];
+        const size_type n = to_chars(buf, buf + sizeof(buf), value).ptr - buf;
+        for (size_type i = 0; i < n; i++) push_back(static_cast<value_type>(buf[i]));
+    }
+    return *this;
+}
+
+template <class CharType, class CharTraits>
+template <class C, typename std::enable_if<std::is_same<C, char>::value, int>::type>
+basic_string_builder<CharType, CharTraits>&
+basic_string_builder<CharType, CharTraits>::appendf(const char* fmt, ...) {
+    va_list args, again;
+    va_start(args, fmt);
+    va_copy(again, args);
+    // vsnprintf also writes the null character, so the text fits when n < room
+    const size_type room = tail_ == nullptr ? 0 : tail_->cap - tail_->size;
+    const int n = std::vsnprintf(room == 0 ? nullptr : tail_->chars() + tail_->size,
+                                 room, fmt, args);
+    va_end(args);
+    if (n >= 0 && static_cast<size_type>(n) >= room) {
+        add_chunk(static_cast<size_type>(n) + 1);
+        std::vsnprintf(tail_->chars(), static_cast<size_type>(n) + 1, fmt, again);
+    }
+    va_end(again);
+    THROW_RUNTIME_ERROR_IF(n < 0, "basic_string_builder<Char, Traits>'s appendf format error");
+    tail_->size += n;
+    size_ += n;
+    return *this;
+}
+
+template <class CharType, class CharTraits>
+typename basic_string_builder<CharType, CharTraits>::string_type
+basic_string_builder<CharType, CharTraits>::str() const {
+    string_type result;
+    result.reserve(size_);
+    result.resize_and_overwrite(size_, [this](pointer dest, size_type) {
+        copy(dest);
+        return size_;
+    });
+    return result;
+}
+
+template <class CharType, class CharTraits>
+void basic_string_builder<CharType, CharTraits>::copy(pointer dest) const noexcept {
+    for (const chunk* c = head_; c != nullptr; c = c->next) {
+        char_traits::copy(dest, c->chars(), c->size);
+        dest += c->size;
+    }
+}
+
+template <class CharType, class CharTraits>
+typename basic_string_builder<CharType, CharTraits>::size_type
+basic_string_builder<CharType, CharTraits>::chunk_count() const noexcept {
+    size_type n = 0;
+    for (const chunk* c = head_; c != nullptr; c = c->next) {
+        if (c->size != 0) n++;
+    }
+    return n;
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+template <class CharType, class CharTraits>
+typename basic_string_builder<CharType, CharTraits>::size_type
+basic_string_builder<CharType, CharTraits>::to_iovec(struct iovec* iov, size_type count) const noexcept {
+    size_type n = 0;
+    for (const chunk* c = head_; c != nullptr && n < count; c = c->next) {
+        if (c->size == 0) continue;
+        iov[n].iov_base = const_cast<pointer>(c->chars());
+        iov[n].iov_len = c->size * sizeof(CharType);
+        n++;
+    }
+    return n;
+}
+#endif
+
+/*****************************************************************************************/
+// helper function
+
+template <class CharType, class CharTraits>
+void basic_string_builder<CharType, CharTraits>::add_chunk(size_type need) {
+    const size_type cap = saberstl::max(need, next_cap_);
+    const size_t bytes = sizeof(chunk) + cap * sizeof(CharType);
+    void* raw = arena_ != nullptr ? arena_->allocate(bytes, alignof(chunk))
+                                  : static_cast<void*>(chunk_allocator::allocate(bytes));
+    chunk* c = static_cast<chunk*>(raw);
+    c->next = nullptr;
+    c->size = 0;
+    c->cap = cap;
+    if (tail_ == nullptr) head_ = c;
+    else tail_->next = c;
+    tail_ = c;
+    const size_type max_cap = EBuilderMaxChunkBytes / sizeof(CharType);
+    if (next_cap_ < max_cap) next_cap_ = saberstl::min(next_cap_ * 2, max_cap);
+}
+
+template <class CharType, class CharTraits>
+void basic_string_builder<CharType, CharTraits>::release() noexcept {
+    if (arena_ == nullptr) {
+        chunk* c = head_;
+        while (c != nullptr) {
+            chunk* next = c->next;
+            chunk_allocator::deallocate(reinterpret_cast<char*>(c),
+                                        sizeof(chunk) + c->cap * sizeof(CharType));
+            c = next;
+        }
+    }
+    head_ = tail_ = nullptr;
+    size_ = 0;
+}
+
+typedef basic_string_builder<char>      string_builder;
+typedef basic_string_builder<wchar_t>   wstring_builder;
+
+} // namespace saberstl
+
+#endif // !SABERSTL_STRING_BUILDER_H
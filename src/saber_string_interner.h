@@ -0,0 +1,300 @@
+#ifndef SABERSTL_STRING_INTERNER_H
+#define SABERSTL_STRING_INTERNER_H
+
+// Template Class: basic_interned_string, basic_string_interner
+
+#include <cstddef>
+#include <mutex>
+
+#include "saber_basic_string.h"
+#include "saber_arena.h"
+
+namespace saberstl {
+
+// Number of shards of an interner, 1 << EInternShardBits
+enum { EInternShardBits = 4, EInternShards = 1 << EInternShardBits };
+
+// Initial slots of the table of a shard, a power of 2
+enum { EInternInitSlots = 64 };
+
+// The header of an interned string, the characters and a null follow it
+struct interned_rep {
+    size_t hash;    // hash of the characters
+    size_t size;    // number of characters
+};
+
+// template class basic_interned_string
+// A handle of a string stored once in a basic_string_interner. Two handles
+// from the same interner are equal if and only if they point to the same
+// record, so == is a pointer compare and the hash is read, not computed.
+// A default handle is the empty string, and interning an empty string
+// gives it. The handle is valid while its interner lives.
+template <class CharType, class CharTraits = saberstl::char_traits<CharType>>
+class basic_interned_string {
+public:
+    typedef basic_string_view<CharType, CharTraits>     string_view_type;
+    typedef CharType                                    value_type;
+    typedef const CharType*                             const_pointer;
+    typedef size_t                                      size_type;
+
+private:
+    const interned_rep* rep_;   // Store the record, nullptr for the empty string
+
+public:
+    basic_interned_string() noexcept : rep_(nullptr) {}
+    explicit basic_interned_string(const interned_rep* rep) noexcept : rep_(rep) {}
+
+    const_pointer data() const noexcept {
+        return rep_ == nullptr ? S_empty() : reinterpret_cast<const_pointer>(rep_ + 1);
+    }
+    const_pointer c_str() const noexcept { return data(); }
+    size_type size() const noexcept { return rep_ == nullptr ? 0 : rep_->size; }
+    bool empty() const noexcept { return rep_ == nullptr; }
+
+    // The hash equals the hash of the same characters in a basic_string_view
+    size_t hash() const noexcept {
+        return rep_ == nullptr ? saberstl::hash<string_view_type>()(string_view_type()) : rep_->hash;
+    }
+
+    string_view_type view() const noexcept { return string_view_type(data(), size()); }
+    operator string_view_type() const noexcept { return view(); }
+
+    const interned_rep* get() const noexcept { return rep_; }
+
+private:
+    static const_pointer S_empty() noexcept {
+        static const value_type empty = value_type();
+        return &empty;
+    }
+};
+
+// Handles are compared by their records, < orders by address, not by the characters
+template <class CharType, class CharTraits>
+bool operator==(const basic_interned_string<CharType, CharTraits>& lhs,
+                const basic_interned_string<CharType, CharTraits>& rhs) noexcept {
+    return lhs.get() == rhs.get();
+}
+
+template <class CharType, class CharTraits>
+bool operator!=(const basic_interned_string<CharType, CharTraits>& lhs,
+                const basic_interned_string<CharType, CharTraits>& rhs) noexcept {
+    return lhs.get() != rhs.get();
+}
+
+template <class CharType, class CharTraits>
+bool operator<(const basic_interned_string<CharType, CharTraits>& lhs,
+               const basic_interned_string<CharType, CharTraits>& rhs) noexcept {
+    return lhs.get() < rhs.get();
+}
+
+// Overload hash, the hash kept in the record
+template <class CharType, class CharTraits>
+struct hash<basic_interned_string<CharType, CharTraits>> {
+    size_t operator()(const basic_interned_string<CharType, CharTraits>& str) const noexcept {
+        return str.hash();
+    }
+};
+
+// template class basic_string_interner
+// Stores each distinct string once and hands out basic_interned_string.
+// It is split into EInternShards shards chosen by the high bits of the
+// hash, each with its own lock, monotonic_arena and open addressing table
+// of records, so threads interning different strings rarely wait for each
+// other. The records never move or die before the interner, and a table
+// grows by rehashing the records with the hash kept in them.
+template <class CharType, class CharTraits = saberstl::char_traits<CharType>>
+class basic_string_interner {
+public:
+    typedef basic_interned_string<CharType, CharTraits> interned_type;
+    typedef basic_string_view<CharType, CharTraits>     string_view_type;
+    typedef basic_string<CharType, CharTraits>          string_type;
+    typedef CharTraits                                  char_traits;
+    typedef size_t                                      size_type;
+
+    typedef saberstl::allocator<const interned_rep*>    table_allocator;
+
+private:
+    struct shard {
+        mutable std::mutex lock;        // Guard the rest of the shard
+        monotonic_arena arena;          // Where the records live
+        const interned_rep** table;     // Slots of records, nullptr for empty
+        size_type mask;                 // Slots - 1
+        size_type count;                // Records in the shard
+
+        shard() : lock(), arena(), table(nullptr), mask(0), count(0) {}
+    };
+
+    shard shards_[EInternShards];
+
+public:
+    basic_string_interner() = default;
+
+    ~basic_string_interner() {
+        for (shard& s : shards_) {
+            if (s.table != nullptr) table_allocator::deallocate(s.table, s.mask + 1);
+        }
+    }
+
+public:
+    // Intern str, the characters are copied the first time only
+    interned_type intern(string_view_type str);
+    interned_type intern(const string_type& str) { return intern(string_view_type(str)); }
+    interned_type intern(const CharType* str) { return intern(string_view_type(str)); }
+
+    // The handle of str if it has been interned, the empty handle if not
+    interned_type find(string_view_type str) const;
+
+    // Number of distinct strings
+    size_type size() const;
+
+    // Bytes of the records and of the tables
+    size_t bytes_used() const;
+    // Bytes of the arena blocks and of the tables
+    size_t bytes_reserved() const;
+
+private:
+    static size_t S_hash(string_view_type str) noexcept {
+        return saberstl::hash<string_view_type>()(str);
+    }
+    // The high bits pick the shard, the low bits pick the slot
+    shard& shard_of(size_t h) noexcept {
+        return shards_[h >> (sizeof(size_t) * 8 - EInternShardBits)];
+    }
+    const shard& shard_of(size_t h) const noexcept {
+        return shards_[h >> (sizeof(size_t) * 8 - EInternShardBits)];
+    }
+
+    static const interned_rep* const* probe(const shard& s, string_view_type str, size_t h) noexcept;
+    static void grow(shard& s);
+
+private:
+    basic_string_interner(const basic_string_interner&);
+    void operator=(const basic_string_interner&);
+};
+
+/*****************************************************************************************/
+// helper function
+
+// The slot holding str, or the empty slot where it should go; the table must have one
+template <class CharType, class CharTraits>
+const interned_rep* const* basic_string_interner<CharType, CharTraits>::
+probe(const shard& s, string_view_type str, size_t h) noexcept {
+    size_type i = h & s.mask;
+    for (;;) {
+        const interned_rep* rep = s.table[i];
+        if (rep == nullptr) return s.table + i;
+        if (rep->hash == h && rep->size == str.size() &&
+            char_traits::compare(reinterpret_cast<const CharType*>(rep + 1),
+                                 str.data(), str.size()) == 0) {
+            return s.table + i;
+        }
+        i = (i + 1) & s.mask;
+    }
+}
+
+// Double the table, or make the first one
+template <class CharType, class CharTraits>
+void basic_string_interner<CharType, CharTraits>::grow(shard& s) {
+    const size_type old_slots = s.table == nullptr ? 0 : s.mask + 1;
+    const size_type new_slots = old_slots == 0 ? static_cast<size_type>(EInternInitSlots)
+                                               : old_slots * 2;
+    const interned_rep** table = table_allocator::allocate(new_slots);
+    for (size_type i = 0; i < new_slots; i++) table[i] = nullptr;
+    const size_type mask = new_slots - 1;
+    for (size_type i = 0; i < old_slots; i++) {
+        const interned_rep* rep = s.table[i];
+        if (rep == nullptr) continue;
+        size_type j = rep->hash & mask;
+        while (table[j] != nullptr) j = (j + 1) & mask;
+        table[j] = rep;
+    }
+    if (s.table != nullptr) table_allocator::deallocate(s.table, old_slots);
+    s.table = table;
+    s.mask = mask;
+}
+
+/*****************************************************************************************/
+
+// Intern str
+template <class CharType, class CharTraits>
+typename basic_string_interner<CharType, CharTraits>::interned_type
+basic_string_interner<CharType, CharTraits>::intern(string_view_type str) {
+    if (str.empty()) return interned_type();
+    const size_t h = S_hash(str);
+    shard& s = shard_of(h);
+    std::lock_guard<std::mutex> guard(s.lock);
+    const interned_rep** slot = nullptr;
+    if (s.table != nullptr) {
+        slot = const_cast<const interned_rep**>(probe(s, str, h));
+        if (*slot != nullptr) return interned_type(*slot);
+    }
+    // A new record, keep the load at most a half; the slot moves with the table
+    if (s.table == nullptr || (s.count + 1) * 2 > s.mask + 1) {
+        grow(s);
+        slot = const_cast<const interned_rep**>(probe(s, str, h));
+    }
+    const size_t bytes = sizeof(interned_rep) + (str.size() + 1) * sizeof(CharType);
+    interned_rep* rep = static_cast<interned_rep*>(s.arena.allocate(bytes, alignof(interned_rep)));
+    rep->hash = h;
+    rep->size = str.size();
+    CharType* chars = reinterpret_cast<CharType*>(rep + 1);
+    char_traits::copy(chars, str.data(), str.size());
+    chars[str.size()] = CharType();
+    *slot = rep;
+    s.count++;
+    return interned_type(rep);
+}
+
+// Find str without interning it
+template <class CharType, class CharTraits>
+typename basic_string_interner<CharType, CharTraits>::interned_type
+basic_string_interner<CharType, CharTraits>::find(string_view_type str) const {
+    if (str.empty()) return interned_type();
+    const size_t h = S_hash(str);
+    const shard& s = shard_of(h);
+    std::lock_guard<std::mutex> guard(s.lock);
+    if (s.table == nullptr) return interned_type();
+    return interned_type(*probe(s, str, h));
+}
+
+template <class CharType, class CharTraits>
+typename basic_string_interner<CharType, CharTraits>::size_type
+basic_string_interner<CharType, CharTraits>::size() const {
+    size_type n = 0;
+    for (const shard& s : shards_) {
+        std::lock_guard<std::mutex> guard(s.lock);
+        n += s.count;
+    }
+    return n;
+}
+
+template <class CharType, class CharTraits>
+size_t basic_string_interner<CharType, CharTraits>::bytes_used() const {
+    size_t bytes = 0;
+    for (const shard& s : shards_) {
+        std::lock_guard<std::mutex> guard(s.lock);
+        bytes += s.arena.bytes_used();
+        if (s.table != nullptr) bytes += (s.mask + 1) * sizeof(const interned_rep*);
+    }
+    return bytes;
+}
+
+template <class CharType, class CharTraits>
+size_t basic_string_interner<CharType, CharTraits>::bytes_reserved() const {
+    size_t bytes = 0;
+    for (const shard& s : shards_) {
+        std::lock_guard<std::mutex> guard(s.lock);
+        bytes += s.arena.bytes_reserved();
+        if (s.table != nullptr) bytes += (s.mask + 1) * sizeof(const interned_rep*);
+    }
+    return bytes;
+}
+
+typedef basic_interned_string<char>         interned_string;
+typedef basic_interned_string<wchar_t>      interned_wstring;
+typedef basic_string_interner<char>         string_interner;
+typedef basic_string_interner<wchar_t>      wstring_interner;
+
+} // namespace saberstl
+
+#endif // !SABERSTL_STRING_INTERNER_H
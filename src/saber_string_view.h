@@ -0,0 +1,440 @@
+#ifndef SABERSTL_STRING_VIEW_H
+#define SABERSTL_STRING_VIEW_H
+
+// Template Class: basic_string_view
+
+#include <iostream>
+#include <type_traits>
+
+#include "saber_char_traits.h"
+#include "saber_iterator.h"
+#include "saber_algobase.h"
+#include "saber_functional.h"
+#include "saber_execptdef.h"
+
+namespace saberstl {
+
+// template class basic_string_view
+// A pointer and a size referring to characters owned by someone else, such
+// as a basic_string or an input buffer. It never allocates: substr, the
+// find functions, the comparisons and the hash all work on the referred
+// characters, so the owner must outlive the view.
+// Parameter 1 represents the type of string;
+// Parameter 2 represents the solution of extraction type of string, default using saberstl::char_traits
+template <class CharType, class CharTraits = saberstl::char_traits<CharType>>
+class basic_string_view {
+public:
+    typedef CharTraits                                  traits_type;
+    typedef CharTraits                                  char_traits;
+
+    typedef CharType                                    value_type;
+    typedef CharType*                                   pointer;
+    typedef const CharType*                             const_pointer;
+    typedef CharType&                                   reference;
+    typedef const CharType&                             const_reference;
+    typedef size_t                                      size_type;
+    typedef ptrdiff_t                                   difference_type;
+
+    typedef const value_type*                           iterator;
+    typedef const value_type*                           const_iterator;
+    typedef saberstl::reverse_iterator<const_iterator>  reverse_iterator;
+    typedef saberstl::reverse_iterator<const_iterator>  const_reverse_iterator;
+
+    static_assert(std::is_same<CharType, typename traits_type::char_type>::value,
+                  "Character must be same as traits_type::char_type");
+
+public:
+    static constexpr size_type npos = static_cast<size_type>(-1);
+
+private:
+    const_pointer data_;    // The first character referred
+    size_type size_;        // Number of characters referred
+
+public:
+    constexpr basic_string_view() noexcept : data_(nullptr), size_(0) {}
+
+    constexpr basic_string_view(const_pointer str, size_type count) noexcept
+    : data_(str), size_(count) {}
+
+    basic_string_view(const_pointer str) noexcept
+    : data_(str), size_(char_traits::length(str)) {}
+
+    constexpr basic_string_view(const basic_string_view& rhs) noexcept = default;
+    basic_string_view& operator=(const basic_string_view& rhs) noexcept = default;
+
+public:
+    // Iterator operations
+    const_iterator begin() const noexcept { return data_; }
+    const_iterator end() const noexcept { return data_ + size_; }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+
+    const_reverse_iterator rbegin() const noexcept { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const noexcept { return const_reverse_iterator(begin()); }
+    const_reverse_iterator crbegin() const noexcept { return rbegin(); }
+    const_reverse_iterator crend() const noexcept { return rend(); }
+
+    // Capacity operations
+    constexpr bool empty() const noexcept { return size_ == 0; }
+    constexpr size_type size() const noexcept { return size_; }
+    constexpr size_type length() const noexcept { return size_; }
+    constexpr size_type max_size() const noexcept { return static_cast<size_type>(-1) / sizeof(CharType); }
+
+    // Access the elements
+    const_reference operator[](size_type n) const noexcept {
+        SABERSTL_DEBUG(n < size_);
+        return data_[n];
+    }
+    const_reference at(size_type n) const {
+        THROW_OUT_OF_RANGE_IF(n >= size_, "basic_string_view<Char, Traits>::at() subscript out of range");
+        return data_[n];
+    }
+    const_reference front() const noexcept {
+        SABERSTL_DEBUG(!empty());
+        return data_[0];
+    }
+    const_reference back() const noexcept {
+        SABERSTL_DEBUG(!empty());
+        return data_[size_ - 1];
+    }
+    constexpr const_pointer data() const noexcept { return data_; }
+
+    // Shrink the view
+    void remove_prefix(size_type n) noexcept {
+        SABERSTL_DEBUG(n <= size_);
+        data_ += n;
+        size_ -= n;
+    }
+    void remove_suffix(size_type n) noexcept {
+        SABERSTL_DEBUG(n <= size_);
+        size_ -= n;
+    }
+
+    void swap(basic_string_view& rhs) noexcept {
+        saberstl::swap(data_, rhs.data_);
+        saberstl::swap(size_, rhs.size_);
+    }
+
+    // substr / copy, substr refers to the same characters
+    basic_string_view substr(size_type pos = 0, size_type count = npos) const {
+        THROW_OUT_OF_RANGE_IF(pos > size_, "basic_string_view<Char, Traits>'s pos out of range");
+        return basic_string_view(data_ + pos, saberstl::min(count, size_ - pos));
+    }
+    size_type copy(pointer dest, size_type count, size_type pos = 0) const {
+        THROW_OUT_OF_RANGE_IF(pos > size_, "basic_string_view<Char, Traits>'s pos out of range");
+        count = saberstl::min(count, size_ - pos);
+        char_traits::copy(dest, data_ + pos, count);
+        return count;
+    }
+
+    // Compare two views
+    int compare(basic_string_view other) const noexcept;
+    int compare(size_type pos, size_type count, basic_string_view other) const {
+        return substr(pos, count).compare(other);
+    }
+    int compare(size_type pos1, size_type count1, basic_string_view other,
+                size_type pos2, size_type count2) const {
+        return substr(pos1, count1).compare(other.substr(pos2, count2));
+    }
+    int compare(const_pointer str) const noexcept {
+        return compare(basic_string_view(str));
+    }
+
+    bool starts_with(basic_string_view prefix) const noexcept {
+        return size_ >= prefix.size_ && char_traits::compare(data_, prefix.data_, prefix.size_) == 0;
+    }
+    bool starts_with(value_type ch) const noexcept {
+        return !empty() && front() == ch;
+    }
+    bool ends_with(basic_string_view suffix) const noexcept {
+        return size_ >= suffix.size_ &&
+            char_traits::compare(data_ + size_ - suffix.size_, suffix.data_, suffix.size_) == 0;
+    }
+    bool ends_with(value_type ch) const noexcept {
+        return !empty() && back() == ch;
+    }
+
+    // find / rfind, npos for none
+    size_type find(value_type ch, size_type pos = 0) const noexcept;
+    size_type find(const_pointer str, size_type pos, size_type count) const noexcept;
+    size_type find(const_pointer str, size_type pos = 0) const noexcept {
+        return find(str, pos, char_traits::length(str));
+    }
+    size_type find(basic_string_view str, size_type pos = 0) const noexcept {
+        return find(str.data_, pos, str.size_);
+    }
+
+    size_type rfind(value_type ch, size_type pos = npos) const noexcept;
+    size_type rfind(const_pointer str, size_type pos, size_type count) const noexcept;
+    size_type rfind(const_pointer str, size_type pos = npos) const noexcept {
+        return rfind(str, pos, char_traits::length(str));
+    }
+    size_type rfind(basic_string_view str, size_type pos = npos) const noexcept {
+        return rfind(str.data_, pos, str.size_);
+    }
+
+    // find_first_of / find_first_not_of, npos for none
+    size_type find_first_of(value_type ch, size_type pos = 0) const noexcept {
+        return find(ch, pos);
+    }
+    size_type find_first_of(const_pointer str, size_type pos, size_type count) const noexcept {
+        return find_of(str, pos, count, true);
+    }
+    size_type find_first_of(const_pointer str, size_type pos = 0) const noexcept {
+        return find_of(str, pos, char_traits::length(str), true);
+    }
+    size_type find_first_of(basic_string_view str, size_type pos = 0) const noexcept {
+        return find_of(str.data_, pos, str.size_, true);
+    }
+
+    size_type find_first_not_of(value_type ch, size_type pos = 0) const noexcept {
+        return find_of(&ch, pos, 1, false);
+    }
+    size_type find_first_not_of(const_pointer str, size_type pos, size_type count) const noexcept {
+        return find_of(str, pos, count, false);
+    }
+    size_type find_first_not_of(const_pointer str, size_type pos = 0) const noexcept {
+        return find_of(str, pos, char_traits::length(str), false);
+    }
+    size_type find_first_not_of(basic_string_view str, size_type pos = 0) const noexcept {
+        return find_of(str.data_, pos, str.size_, false);
+    }
+
+private:
+    // The first character from pos in or not in [set, set + count)
+    size_type find_of(const_pointer set, size_type pos, size_type count, bool in) const noexcept;
+};
+
+/*****************************************************************************************/
+
+template <class CharType, class CharTraits>
+constexpr typename basic_string_view<CharType, CharTraits>::size_type
+basic_string_view<CharType, CharTraits>::npos;
+
+// Compare with another view
+template <class CharType, class CharTraits>
+int basic_string_view<CharType, CharTraits>::compare(basic_string_view other) const noexcept {
+    const size_type rlen = saberstl::min(size_, other.size_);
+    const int res = char_traits::compare(data_, other.data_, rlen);
+    if (res != 0) return res;
+    if (size_ < other.size_) return -1;
+    if (size_ > other.size_) return 1;
+    return 0;
+}
+
+// Find ch from pos
+template <class CharType, class CharTraits>
+typename basic_string_view<CharType, CharTraits>::size_type
+basic_string_view<CharType, CharTraits>::find(value_type ch, size_type pos) const noexcept {
+    if (pos >= size_) return npos;
+    const_pointer r = char_traits::find(data_ + pos, size_ - pos, ch);
+    return r == nullptr ? npos : static_cast<size_type>(r - data_);
+}
+
+// Find str of count characters from pos, the candidates are found by its first character
+template <class CharType, class CharTraits>
+typename basic_string_view<CharType, CharTraits>::size_type
+basic_string_view<CharType, CharTraits>::
+find(const_pointer str, size_type pos, size_type count) const noexcept {
+    if (count == 0) return pos <= size_ ? pos : npos;
+    if (pos > size_ || count > size_ - pos) return npos;
+    const_pointer cur = data_ + pos;
+    const_pointer last = data_ + size_ - count;     // the last place str may start
+    while (cur <= last) {
+        cur = char_traits::find(cur, last - cur + 1, str[0]);
+        if (cur == nullptr) break;
+        if (char_traits::compare(cur + 1, str + 1, count - 1) == 0) {
+            return static_cast<size_type>(cur - data_);
+        }
+        ++cur;
+    }
+    return npos;
+}
+
+// Find the last ch at or before pos
+template <class CharType, class CharTraits>
+typename basic_string_view<CharType, CharTraits>::size_type
+basic_string_view<CharType, CharTraits>::rfind(value_type ch, size_type pos) const noexcept {
+    if (size_ == 0) return npos;
+    const_pointer r = char_traits::rfind(data_, saberstl::min(pos, size_ - 1) + 1, ch);
+    return r == nullptr ? npos : static_cast<size_type>(r - data_);
+}
+
+// Find the last str of count characters starting at or before pos
+template <class CharType, class CharTraits>
+typename basic_string_view<CharType, CharTraits>::size_type
+basic_string_view<CharType, CharTraits>::
+rfind(const_pointer str, size_type pos, size_type count) const noexcept {
+    if (count > size_) return npos;
+    size_type start = saberstl::min(pos, size_ - count);
+    if (count == 0) return start;
+    for (;;) {
+        const_pointer cur = char_traits::rfind(data_, start + 1, str[0]);
+        if (cur == nullptr) return npos;
+        if (char_traits::compare(cur + 1, str + 1, count - 1) == 0) {
+            return static_cast<size_type>(cur - data_);
+        }
+        if (cur == data_) return npos;
+        start = static_cast<size_type>(cur - data_) - 1;
+    }
+}
+
+// find_of function
+template <class CharType, class CharTraits>
+typename basic_string_view<CharType, CharTraits>::size_type
+basic_string_view<CharType, CharTraits>::
+find_of(const_pointer set, size_type pos, size_type count, bool in) const noexcept {
+    if (pos >= size_) return npos;
+    const_pointer r = char_traits::find_of(data_ + pos, size_ - pos, set, count, in);
+    return r == nullptr ? npos : static_cast<size_type>(r - data_);
+}
+
+/*****************************************************************************************/
+
+// The type of T that takes no part in the deduction, so one side of a
+// comparison may convert to the view, such as a basic_string or a C-style string
+template <class T>
+struct string_view_identity {
+    typedef T type;
+};
+
+// Overload comparison operators
+template <class CharType, class CharTraits>
+bool operator==(basic_string_view<CharType, CharTraits> lhs,
+                basic_string_view<CharType, CharTraits> rhs) noexcept {
+    return lhs.size() == rhs.size() && lhs.compare(rhs) == 0;
+}
+
+template <class CharType, class CharTraits>
+bool operator==(basic_string_view<CharType, CharTraits> lhs,
+                typename string_view_identity<basic_string_view<CharType, CharTraits>>::type rhs) noexcept {
+    return lhs.size() == rhs.size() && lhs.compare(rhs) == 0;
+}
+
+template <class CharType, class CharTraits>
+bool operator==(typename string_view_identity<basic_string_view<CharType, CharTraits>>::type lhs,
+                basic_string_view<CharType, CharTraits> rhs) noexcept {
+    return lhs.size() == rhs.size() && lhs.compare(rhs) == 0;
+}
+
+template <class CharType, class CharTraits>
+bool operator!=(basic_string_view<CharType, CharTraits> lhs,
+                basic_string_view<CharType, CharTraits> rhs) noexcept {
+    return !(lhs == rhs);
+}
+
+template <class CharType, class CharTraits>
+bool operator!=(basic_string_view<CharType, CharTraits> lhs,
+                typename string_view_identity<basic_string_view<CharType, CharTraits>>::type rhs) noexcept {
+    return !(lhs == rhs);
+}
+
+template <class CharType, class CharTraits>
+bool operator!=(typename string_view_identity<basic_string_view<CharType, CharTraits>>::type lhs,
+                basic_string_view<CharType, CharTraits> rhs) noexcept {
+    return !(lhs == rhs);
+}
+
+template <class CharType, class CharTraits>
+bool operator<(basic_string_view<CharType, CharTraits> lhs,
+               basic_string_view<CharType, CharTraits> rhs) noexcept {
+    return lhs.compare(rhs) < 0;
+}
+
+template <class CharType, class CharTraits>
+bool operator<(basic_string_view<CharType, CharTraits> lhs,
+               typename string_view_identity<basic_string_view<CharType, CharTraits>>::type rhs) noexcept {
+    return lhs.compare(rhs) < 0;
+}
+
+template <class CharType, class CharTraits>
+bool operator<(typename string_view_identity<basic_string_view<CharType, CharTraits>>::type lhs,
+               basic_string_view<CharType, CharTraits> rhs) noexcept {
+    return lhs.compare(rhs) < 0;
+}
+
+template <class CharType, class CharTraits>
+bool operator<=(basic_string_view<CharType, CharTraits> lhs,
+                basic_string_view<CharType, CharTraits> rhs) noexcept {
+    return lhs.compare(rhs) <= 0;
+}
+
+template <class CharType, class CharTraits>
+bool operator<=(basic_string_view<CharType, CharTraits> lhs,
+                typename string_view_identity<basic_string_view<CharType, CharTraits>>::type rhs) noexcept {
+    return lhs.compare(rhs) <= 0;
+}
+
+template <class CharType, class CharTraits>
+bool operator<=(typename string_view_identity<basic_string_view<CharType, CharTraits>>::type lhs,
+                basic_string_view<CharType, CharTraits> rhs) noexcept {
+    return lhs.compare(rhs) <= 0;
+}
+
+template <class CharType, class CharTraits>
+bool operator>(basic_string_view<CharType, CharTraits> lhs,
+               basic_string_view<CharType, CharTraits> rhs) noexcept {
+    return lhs.compare(rhs) > 0;
+}
+
+template <class CharType, class CharTraits>
+bool operator>(basic_string_view<CharType, CharTraits> lhs,
+               typename string_view_identity<basic_string_view<CharType, CharTraits>>::type rhs) noexcept {
+    return lhs.compare(rhs) > 0;
+}
+
+template <class CharType, class CharTraits>
+bool operator>(typename string_view_identity<basic_string_view<CharType, CharTraits>>::type lhs,
+               basic_string_view<CharType, CharTraits> rhs) noexcept {
+    return lhs.compare(rhs) > 0;
+}
+
+template <class CharType, class CharTraits>
+bool operator>=(basic_string_view<CharType, CharTraits> lhs,
+                basic_string_view<CharType, CharTraits> rhs) noexcept {
+    return lhs.compare(rhs) >= 0;
+}
+
+template <class CharType, class CharTraits>
+bool operator>=(basic_string_view<CharType, CharTraits> lhs,
+                typename string_view_identity<basic_string_view<CharType, CharTraits>>::type rhs) noexcept {
+    return lhs.compare(rhs) >= 0;
+}
+
+template <class CharType, class CharTraits>
+bool operator>=(typename string_view_identity<basic_string_view<CharType, CharTraits>>::type lhs,
+                basic_string_view<CharType, CharTraits> rhs) noexcept {
+    return lhs.compare(rhs) >= 0;
+}
+
+// Overload saberstl swap
+template <class CharType, class CharTraits>
+void swap(basic_string_view<CharType, CharTraits>& lhs,
+          basic_string_view<CharType, CharTraits>& rhs) noexcept {
+    lhs.swap(rhs);
+}
+
+// Output the view
+template <class CharType, class CharTraits>
+std::basic_ostream<CharType>& operator<<(std::basic_ostream<CharType>& os,
+                                         basic_string_view<CharType, CharTraits> str) {
+    return os.write(str.data(), static_cast<std::streamsize>(str.size()));
+}
+
+// Overload hash, over the bytes of the characters referred
+template <class CharType, class CharTraits>
+struct hash<basic_string_view<CharType, CharTraits>> {
+    size_t operator()(basic_string_view<CharType, CharTraits> str) const noexcept {
+        return bitwise_hash(reinterpret_cast<const unsigned char*>(str.data()),
+                            str.size() * sizeof(CharType));
+    }
+};
+
+typedef basic_string_view<char>      string_view;
+typedef basic_string_view<wchar_t>   wstring_view;
+typedef basic_string_view<char16_t>  u16string_view;
+typedef basic_string_view<char32_t>  u32string_view;
+
+} // namespace saberstl
+
+#endif // !SABERSTL_STRING_VIEW_H
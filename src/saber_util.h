@@ -77,7 +77,7 @@ struct pair {
     }
 
     // implicit constructiable for this type
-    template <class U1 = Ty1, class u2 = Ty2,
+    template <class U1 = Ty1, class U2 = Ty2,
         typename std::enable_if<
             std::is_copy_constructible<U1>::value &&
             std::is_copy_constructible<U2>::value &&
@@ -87,7 +87,7 @@ struct pair {
     }
 
     // explicit constructible for this type
-    template <class U1 = Ty1, class u2 = Ty2,
+    template <class U1 = Ty1, class U2 = Ty2,
         typename std::enable_if<
             std::is_copy_constructible<U1>::value &&
             std::is_copy_constructible<U2>::value &&
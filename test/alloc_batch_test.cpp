@@ -0,0 +1,73 @@
+/*
+ * The batch of a size class in a thread cache: a thread which keeps
+ * taking blocks of one size refills often, and the batch doubles up to
+ * EMaxTransferBlocks. When the thread turns to another size, the batch
+ * of the first one halves at every decay back to EMinTransferBlocks, and
+ * the blocks cached over it go back to the shared pool. Read from the
+ * statistics, so built with SABERSTL_ALLOC_STATS.
+*/
+
+#define SABERSTL_ALLOC_STATS
+
+#include <thread>
+#include <vector>
+
+#include "saber_alloc.h"
+#include "test_util.h"
+
+namespace {
+
+enum { EHotBytes = 200, EOtherBytes = 16, EHotBlocks = 5000 };
+
+saberstl::alloc_class_stats class_of(size_t n) {
+    const saberstl::alloc_stats s = saberstl::alloc::statistics();
+    for (const saberstl::alloc_class_stats& c : s.classes) {
+        if (c.block_size >= n) return c;
+    }
+    EXPECT(false);
+    return s.classes[0];
+}
+
+void worker() {
+    /* No slow path yet, the batch is the smallest */
+    EXPECT(class_of(EHotBytes).batch <= saberstl::EMinTransferBlocks);
+
+    /* Refill-heavy: many blocks taken and none freed */
+    std::vector<void*> hot;
+    for (int i = 0; i < EHotBlocks; i++) hot.push_back(saberstl::alloc::allocate(EHotBytes));
+    saberstl::alloc_class_stats c = class_of(EHotBytes);
+    EXPECT(c.batch == saberstl::EMaxTransferBlocks);
+    /* The batch grows by doubling, so the refills are far fewer than the blocks */
+    EXPECT(c.refills < EHotBlocks / 16);
+    for (void *p : hot) saberstl::alloc::deallocate(p, EHotBytes);
+    c = class_of(EHotBytes);
+    EXPECT(c.thread_cached <= 2 * saberstl::EMaxTransferBlocks);
+
+    /* Only another size from now on, the cold batch decays */
+    std::vector<void*> other(4 * saberstl::EMaxTransferBlocks);
+    int rounds = 0;
+    for (; rounds < 10000 && class_of(EHotBytes).batch > saberstl::EMinTransferBlocks; rounds++) {
+        for (void *&p : other) p = saberstl::alloc::allocate(EOtherBytes);
+        for (void *p : other) saberstl::alloc::deallocate(p, EOtherBytes);
+    }
+    c = class_of(EHotBytes);
+    EXPECT(c.batch == saberstl::EMinTransferBlocks);
+    EXPECT(c.thread_cached <= saberstl::EMinTransferBlocks);
+    /* It took a few decays, not one */
+    EXPECT(rounds > 1);
+
+    /* Hot again, it grows again */
+    for (void *&p : hot) p = saberstl::alloc::allocate(EHotBytes);
+    EXPECT(class_of(EHotBytes).batch == saberstl::EMaxTransferBlocks);
+    for (void *p : hot) saberstl::alloc::deallocate(p, EHotBytes);
+}
+
+} // namespace
+
+int main() {
+    /* A thread of its own, so no other cache holds a larger batch */
+    std::thread t(worker);
+    t.join();
+    std::printf("alloc batch: ok\n");
+    return 0;
+}
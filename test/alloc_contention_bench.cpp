@@ -0,0 +1,134 @@
+/*
+ * Contention of alloc: 1 to 8 threads allocate and free small blocks as
+ * fast as they can, in a local pattern (free what this thread took) and a
+ * cross-thread one (free what the previous thread took). Compared with
+ * std::malloc / std::free on the same pattern, and with the batches taken
+ * and freed by allocate_bulk / deallocate_bulk instead of one call each.
+*/
+
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "saber_alloc.h"
+#include "test_util.h"
+
+namespace {
+
+enum { EOpsPerThread = 1 << 20, EBatch = 64, EBlockBytes = 48 };
+
+/* A batch of EBatch blocks of EBlockBytes, taken and freed one by one */
+struct pool_alloc {
+    static void allocate(void **out) {
+        for (int i = 0; i < EBatch; i++) out[i] = saberstl::alloc::allocate(EBlockBytes);
+    }
+    static void deallocate(void **blocks) {
+        for (int i = 0; i < EBatch; i++) saberstl::alloc::deallocate(blocks[i], EBlockBytes);
+    }
+};
+
+/* The same in one call */
+struct bulk_alloc {
+    static void allocate(void **out) { saberstl::alloc::allocate_bulk(EBlockBytes, EBatch, out); }
+    static void deallocate(void **blocks) { saberstl::alloc::deallocate_bulk(EBlockBytes, EBatch, blocks); }
+};
+
+struct malloc_alloc {
+    static void allocate(void **out) {
+        for (int i = 0; i < EBatch; i++) out[i] = std::malloc(EBlockBytes);
+    }
+    static void deallocate(void **blocks) {
+        for (int i = 0; i < EBatch; i++) std::free(blocks[i]);
+    }
+};
+
+/* Every thread allocates a batch and frees it */
+template <class Alloc>
+void local_loop() {
+    void *batch[EBatch];
+    for (int r = 0; r < EOpsPerThread / EBatch; r++) {
+        Alloc::allocate(batch);
+        saberstl::test::keep(batch);
+        Alloc::deallocate(batch);
+    }
+}
+
+/* Free the batch handed to this thread, if any */
+template <class Alloc>
+void drain(std::atomic<void**>& slot) {
+    void **got = slot.exchange(nullptr);
+    if (got == nullptr) return;
+    Alloc::deallocate(got);
+    delete[] got;
+}
+
+/* Every thread hands its batch to the next thread, which frees it */
+template <class Alloc>
+void cross_loop(unsigned id, unsigned nthread, std::vector<std::atomic<void**>>& slots,
+                std::atomic<unsigned>& producing) {
+    for (int r = 0; r < EOpsPerThread / EBatch; r++) {
+        void **batch = new void*[EBatch];
+        Alloc::allocate(batch);
+        void **expected = nullptr;
+        while (!slots[(id + 1) % nthread].compare_exchange_weak(expected, batch)) {
+            /* Keep freeing while the next thread is busy, or all may wait */
+            expected = nullptr;
+            drain<Alloc>(slots[id]);
+            std::this_thread::yield();
+        }
+        drain<Alloc>(slots[id]);
+    }
+    /* The previous thread may still wait for this slot */
+    producing.fetch_sub(1);
+    while (producing.load() != 0) {
+        drain<Alloc>(slots[id]);
+        std::this_thread::yield();
+    }
+}
+
+template <class Alloc>
+double run(unsigned nthread, bool cross) {
+    std::vector<std::atomic<void**>> slots(nthread);
+    for (auto& s : slots) s.store(nullptr);
+    std::atomic<unsigned> producing(nthread);
+    std::vector<std::thread> threads;
+    saberstl::test::timer t;
+    for (unsigned i = 0; i < nthread; i++) {
+        threads.emplace_back([i, nthread, cross, &slots, &producing] {
+            if (cross) cross_loop<Alloc>(i, nthread, slots, producing);
+            else local_loop<Alloc>();
+        });
+    }
+    for (std::thread& th : threads) th.join();
+    const double seconds = t.seconds();
+    for (auto& s : slots) drain<Alloc>(s);
+    return seconds;
+}
+
+} // namespace
+
+int main() {
+#ifdef SABERSTL_ALLOC_LOCK_FREE
+    std::printf("alloc contention (lock-free mode), %d byte blocks\n", EBlockBytes);
+#else
+    std::printf("alloc contention, %d byte blocks\n", EBlockBytes);
+#endif
+    char name[64];
+    for (unsigned n = 1; n <= 8; n <<= 1) {
+        const double ops = 2.0 * EOpsPerThread * n;
+        std::snprintf(name, sizeof(name), "alloc local, %u threads", n);
+        saberstl::test::report(name, run<pool_alloc>(n, false), ops);
+        std::snprintf(name, sizeof(name), "alloc bulk local, %u threads", n);
+        saberstl::test::report(name, run<bulk_alloc>(n, false), ops);
+        std::snprintf(name, sizeof(name), "malloc local, %u threads", n);
+        saberstl::test::report(name, run<malloc_alloc>(n, false), ops);
+        std::snprintf(name, sizeof(name), "alloc cross-thread, %u threads", n);
+        saberstl::test::report(name, run<pool_alloc>(n, true), ops);
+        std::snprintf(name, sizeof(name), "alloc bulk cross-thread, %u threads", n);
+        saberstl::test::report(name, run<bulk_alloc>(n, true), ops);
+        std::snprintf(name, sizeof(name), "malloc cross-thread, %u threads", n);
+        saberstl::test::report(name, run<malloc_alloc>(n, true), ops);
+    }
+    return 0;
+}
@@ -0,0 +1,4 @@
+/* The stress test of alloc in the debug mode */
+
+#define SABERSTL_ALLOC_DEBUG
+#include "alloc_stress_test.cpp"
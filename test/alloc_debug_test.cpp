@@ -0,0 +1,118 @@
+/*
+ * The debug mode of alloc: a buffer overflow, a buffer underflow, a double
+ * free and a write after free each abort the program with a message
+ * naming the fault. Every case runs in a child process, the parent reads
+ * its stderr and checks it died of SIGABRT; a clean run must exit 0.
+*/
+
+#define SABERSTL_ALLOC_DEBUG
+
+#include <csignal>
+#include <cstring>
+#include <string>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "saber_alloc.h"
+#include "test_util.h"
+
+namespace {
+
+enum { EBlockBytes = 40 };
+
+void overflow() {
+    char *p = static_cast<char*>(saberstl::alloc::allocate(EBlockBytes));
+    p[EBlockBytes] = 'x';
+    saberstl::alloc::deallocate(p, EBlockBytes);
+}
+
+void underflow() {
+    char *p = static_cast<char*>(saberstl::alloc::allocate(EBlockBytes));
+    p[-1] = 'x';
+    saberstl::alloc::deallocate(p, EBlockBytes);
+}
+
+void double_free() {
+    void *p = saberstl::alloc::allocate(EBlockBytes);
+    saberstl::alloc::deallocate(p, EBlockBytes);
+    saberstl::alloc::deallocate(p, EBlockBytes);
+}
+
+/* The write is found when the block leaves the quarantine */
+void write_after_free() {
+    char *p = static_cast<char*>(saberstl::alloc::allocate(EBlockBytes));
+    saberstl::alloc::deallocate(p, EBlockBytes);
+    p[3] = 'x';
+    saberstl::alloc_debug::set_quarantine_bytes(0);
+    saberstl::alloc::deallocate(saberstl::alloc::allocate(EBlockBytes), EBlockBytes);
+}
+
+/* Large blocks are guarded too */
+void large_overflow() {
+    const size_t n = saberstl::ESmallObjectBytes * 2;
+    char *p = static_cast<char*>(saberstl::alloc::allocate(n));
+    p[n + 3] = 'x';
+    saberstl::alloc::deallocate(p, n);
+}
+
+void clean() {
+    for (int i = 0; i < 10000; i++) {
+        const size_t n = 1 + i % 300;
+        char *p = static_cast<char*>(saberstl::alloc::allocate(n));
+        std::memset(p, 'a', n);
+        saberstl::alloc::deallocate(p, n);
+    }
+}
+
+/* Run f in a child, return its stderr, and how it ended in status */
+std::string run_child(void (*f)(), int& status) {
+    int fds[2];
+    EXPECT(pipe(fds) == 0);
+    std::fflush(nullptr);
+    const pid_t pid = fork();
+    EXPECT(pid >= 0);
+    if (pid == 0) {
+        close(fds[0]);
+        dup2(fds[1], STDERR_FILENO);
+        f();
+        _exit(0);
+    }
+    close(fds[1]);
+    std::string err;
+    char buf[256];
+    ssize_t got;
+    while ((got = read(fds[0], buf, sizeof(buf))) > 0) err.append(buf, got);
+    close(fds[0]);
+    EXPECT(waitpid(pid, &status, 0) == pid);
+    return err;
+}
+
+void expect_abort(void (*f)(), const char *what) {
+    int status = 0;
+    const std::string err = run_child(f, status);
+    if (!(WIFSIGNALED(status) && WTERMSIG(status) == SIGABRT)) {
+        std::fprintf(stderr, "%s: no abort, stderr: %s\n", what, err.c_str());
+        EXPECT(false);
+    }
+    if (err.find(std::string("saberstl alloc: ") + what) == std::string::npos) {
+        std::fprintf(stderr, "%s: unexpected message: %s\n", what, err.c_str());
+        EXPECT(false);
+    }
+}
+
+} // namespace
+
+int main() {
+    expect_abort(overflow, "buffer overflow");
+    expect_abort(underflow, "buffer underflow");
+    expect_abort(double_free, "double free");
+    expect_abort(write_after_free, "write after free");
+    expect_abort(large_overflow, "buffer overflow");
+    int status = 0;
+    const std::string err = run_child(clean, status);
+    EXPECT(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    EXPECT(err.empty());
+    std::printf("alloc debug: ok\n");
+    return 0;
+}
@@ -0,0 +1,56 @@
+/*
+ * Random access over many small blocks of alloc, where TLB misses
+ * dominate: 2M blocks of 64 bytes (128 MiB) linked in a random cycle and
+ * chased, with the chunks from the default provider and from huge_pages().
+ * The first set is freed and trimmed before the second is taken.
+*/
+
+#include <vector>
+
+#include "saber_alloc.h"
+#include "test_util.h"
+
+namespace {
+
+enum { EBlocks = 1 << 21, EBlockBytes = 64, EChases = 1 << 24 };
+
+struct block {
+    block *next;
+    char pad[EBlockBytes - sizeof(block*)];
+};
+
+double chase() {
+    std::vector<block*> blocks(EBlocks);
+    for (block*& p : blocks) p = static_cast<block*>(saberstl::alloc::allocate(EBlockBytes));
+    /* Shuffle, then link in the shuffled order */
+    saberstl::test::rng r;
+    for (size_t i = EBlocks - 1; i > 0; i--) {
+        const size_t j = r.below(i + 1);
+        block *tmp = blocks[i];
+        blocks[i] = blocks[j];
+        blocks[j] = tmp;
+    }
+    for (size_t i = 0; i < EBlocks; i++) blocks[i]->next = blocks[(i + 1) % EBlocks];
+
+    block *p = blocks[0];
+    saberstl::test::timer t;
+    for (int i = 0; i < EChases; i++) p = p->next;
+    const double seconds = t.seconds();
+    saberstl::test::keep(p);
+
+    for (block *b : blocks) saberstl::alloc::deallocate(b, EBlockBytes);
+    saberstl::alloc::trim();
+    return seconds;
+}
+
+} // namespace
+
+int main() {
+    std::printf("alloc page providers, %d MiB of %d byte blocks\n",
+                EBlocks * EBlockBytes >> 20, EBlockBytes);
+    saberstl::test::report("random chase, default pages", chase(), EChases);
+    saberstl::alloc::set_page_provider(saberstl::huge_pages());
+    saberstl::test::report("random chase, huge_pages()", chase(), EChases);
+    saberstl::alloc::set_page_provider(nullptr);
+    return 0;
+}
@@ -0,0 +1,4 @@
+/* The contention benchmark of alloc in the lock-free mode */
+
+#define SABERSTL_ALLOC_LOCK_FREE
+#include "alloc_contention_bench.cpp"
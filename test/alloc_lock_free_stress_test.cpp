@@ -0,0 +1,4 @@
+/* The stress test of alloc in the lock-free mode */
+
+#define SABERSTL_ALLOC_LOCK_FREE
+#include "alloc_stress_test.cpp"
@@ -0,0 +1,112 @@
+/*
+ * Local and remote access to the per NUMA node pools of alloc. A thread
+ * pinned to node k builds a list of 256 byte nodes, which alloc takes
+ * from the pool of node k; then a thread pinned to node 0 sums it. Node
+ * k = 0 is the local case, the others are remote. On a system without
+ * NUMA there is only the local case.
+*/
+
+#include <cstring>
+#include <thread>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+#include "saber_alloc.h"
+#include "test_util.h"
+
+namespace {
+
+enum { ENodes = 1 << 18, ENodeBytes = 256, ERepeat = 8 };
+
+struct list_node {
+    list_node *next;
+    long values[(ENodeBytes - sizeof(list_node*)) / sizeof(long)];
+};
+
+/* Run current thread on the CPUs of node, false if it cannot */
+bool pin_to_node(size_t node) {
+#if defined(__linux__)
+    char path[64];
+    std::snprintf(path, sizeof(path), "/sys/devices/system/node/node%zu/cpulist", node);
+    std::FILE *f = std::fopen(path, "r");
+    if (f == nullptr) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    /* A list of ranges such as "0-7,16-23" */
+    unsigned first, last;
+    while (std::fscanf(f, "%u", &first) == 1) {
+        last = first;
+        int c = std::fgetc(f);
+        if (c == '-') {
+            if (std::fscanf(f, "%u", &last) != 1) break;
+            c = std::fgetc(f);
+        }
+        for (unsigned cpu = first; cpu <= last && cpu < CPU_SETSIZE; cpu++) CPU_SET(cpu, &set);
+        if (c != ',') break;
+    }
+    std::fclose(f);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    return node == 0;
+#endif
+}
+
+list_node *build(size_t node) {
+    list_node *head = nullptr;
+    std::thread([node, &head] {
+        pin_to_node(node);
+        for (int i = 0; i < ENodes; i++) {
+            list_node *p = static_cast<list_node*>(saberstl::alloc::allocate(ENodeBytes));
+            std::memset(p->values, 1, sizeof(p->values));
+            p->next = head;
+            head = p;
+        }
+        /* Give the free blocks cached by this thread back to the pool */
+        saberstl::alloc::flush_thread_cache();
+    }).join();
+    return head;
+}
+
+double walk(list_node *head) {
+    double seconds = 0;
+    std::thread([head, &seconds] {
+        pin_to_node(0);
+        long sum = 0;
+        saberstl::test::timer t;
+        for (int r = 0; r < ERepeat; r++) {
+            for (list_node *p = head; p != nullptr; p = p->next) {
+                for (long v : p->values) sum += v;
+            }
+        }
+        seconds = t.seconds();
+        saberstl::test::keep(sum);
+    }).join();
+    return seconds;
+}
+
+void destroy(list_node *head) {
+    while (head != nullptr) {
+        list_node *next = head->next;
+        saberstl::alloc::deallocate(head, ENodeBytes);
+        head = next;
+    }
+}
+
+} // namespace
+
+int main() {
+    const size_t nodes = saberstl::numa_node_count();
+    std::printf("alloc NUMA pools, %zu node(s), %d MiB lists, ns per list node\n",
+                nodes, ENodes * ENodeBytes >> 20);
+    char name[64];
+    for (size_t k = 0; k < nodes; k++) {
+        list_node *head = build(k);
+        std::snprintf(name, sizeof(name), "walk from node 0, built on node %zu%s",
+                      k, k == 0 ? " (local)" : " (remote)");
+        saberstl::test::report(name, walk(head), static_cast<double>(ENodes) * ERepeat);
+        destroy(head);
+    }
+    return 0;
+}
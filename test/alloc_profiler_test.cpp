@@ -0,0 +1,155 @@
+/*
+ * The allocation profiler of alloc: at a sample rate of 1 byte every block
+ * is sampled, so the report counts exactly the bytes allocated and still
+ * live, and a free or a realloc takes a block out again. At a real rate
+ * the estimates of the live bytes and of the churn stay close to the true
+ * numbers, and a rate of 0 stops the sampling. Built with
+ * SABERSTL_ALLOC_PROFILE.
+*/
+
+#define SABERSTL_ALLOC_PROFILE
+
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "saber_alloc.h"
+#include "test_util.h"
+
+namespace {
+
+enum { EBlockBytes = 64, EManyBlocks = 100000, EEstimateRate = 4096 };
+
+/* The summary line of a report */
+struct summary {
+    size_t sites;
+    size_t live;
+    size_t total;
+};
+
+std::string report(size_t top) {
+    std::FILE *out = std::tmpfile();
+    EXPECT(out != nullptr);
+    saberstl::alloc_profiler::report(out, top);
+    std::string text;
+    std::rewind(out);
+    char buf[512];
+    size_t got;
+    while ((got = std::fread(buf, 1, sizeof(buf), out)) > 0) text.append(buf, got);
+    std::fclose(out);
+    return text;
+}
+
+summary read_summary() {
+    const std::string text = report(10);
+    summary s = {};
+    const size_t at = text.find("  sites: ");
+    EXPECT(at != std::string::npos);
+    EXPECT(std::sscanf(text.c_str() + at, "  sites: %zu, live bytes: %zu, allocated bytes: %zu",
+                       &s.sites, &s.live, &s.total) == 3);
+    return s;
+}
+
+/* The sites printed under the header of a list */
+size_t listed(const std::string& text, const char *header) {
+    size_t at = text.find(header);
+    EXPECT(at != std::string::npos);
+    size_t n = 0;
+    for (at = text.find('\n', at); at != std::string::npos; at = text.find('\n', at + 1)) {
+        if (text.compare(at + 1, 7, "  live ") != 0) {
+            if (text.compare(at + 1, 4, "    ") != 0) break;
+            continue;
+        }
+        n++;
+    }
+    return n;
+}
+
+/* Two call sites of their own */
+__attribute__((noinline)) void *site_a(size_t n) {
+    void *p = saberstl::alloc::allocate(n);
+    saberstl::test::keep(p);
+    return p;
+}
+
+__attribute__((noinline)) void *site_b(size_t n) {
+    void *p = saberstl::alloc::allocate(n);
+    saberstl::test::keep(p);
+    return p;
+}
+
+bool near(size_t estimate, size_t truth) {
+    return estimate > truth * 4 / 5 && estimate < truth * 6 / 5;
+}
+
+/* At a rate of 1 every block is a sample standing for its own bytes */
+void exact() {
+    const size_t small = saberstl::ESmallObjectBytes;
+    saberstl::alloc_profiler::set_sample_rate(1);
+    /* The first call of a thread only draws the distance */
+    saberstl::alloc::deallocate(site_a(EBlockBytes), EBlockBytes);
+
+    const summary s0 = read_summary();
+    std::vector<void*> as, bs;
+    for (int i = 0; i < 10; i++) as.push_back(site_a(100));
+    for (int i = 0; i < 5; i++) bs.push_back(site_b(3 * small));
+    summary s = read_summary();
+    EXPECT(s.live - s0.live == 1000 + 15 * small);
+    EXPECT(s.total - s0.total == 1000 + 15 * small);
+    EXPECT(s.sites >= 2);
+
+    /* A large block grown by realloc is the new size, once */
+    bs[0] = saberstl::alloc::reallocate(bs[0], 3 * small, 5 * small);
+    s = read_summary();
+    EXPECT(s.live - s0.live == 1000 + 17 * small);
+
+    /* The top argument limits the sites of each list */
+    EXPECT(listed(report(1), "churn by site:") == 1);
+    EXPECT(listed(report(10), "churn by site:") >= 2);
+    EXPECT(listed(report(10), "live heap by site:") >= 2);
+
+    for (void *p : as) saberstl::alloc::deallocate(p, 100);
+    saberstl::alloc::deallocate(bs[0], 5 * small);
+    for (size_t i = 1; i < bs.size(); i++) saberstl::alloc::deallocate(bs[i], 3 * small);
+    s = read_summary();
+    EXPECT(s.live == s0.live);
+}
+
+/* At a real rate the numbers are estimates */
+void estimate() {
+    saberstl::alloc_profiler::set_sample_rate(EEstimateRate);
+    saberstl::alloc::deallocate(site_a(EBlockBytes), EBlockBytes);
+
+    const summary s0 = read_summary();
+    std::vector<void*> kept(EManyBlocks);
+    for (void *&p : kept) p = site_a(EBlockBytes);
+    for (int i = 0; i < EManyBlocks; i++) saberstl::alloc::deallocate(site_b(EBlockBytes), EBlockBytes);
+    const summary s = read_summary();
+    const size_t bytes = static_cast<size_t>(EManyBlocks) * EBlockBytes;
+    EXPECT(near(s.live - s0.live, bytes));
+    EXPECT(near(s.total - s0.total, 2 * bytes));
+
+    for (void *p : kept) saberstl::alloc::deallocate(p, EBlockBytes);
+    EXPECT(read_summary().live == s0.live);
+
+    /* No sample once the rate is 0 */
+    saberstl::alloc_profiler::set_sample_rate(0);
+    const summary off = read_summary();
+    for (void *&p : kept) p = site_a(EBlockBytes);
+    for (void *p : kept) saberstl::alloc::deallocate(p, EBlockBytes);
+    EXPECT(read_summary().total == off.total);
+    saberstl::alloc_profiler::set_sample_rate(saberstl::EProfileSampleBytes);
+}
+
+} // namespace
+
+int main() {
+    /* Threads of their own, which start to count down from the rate set */
+    std::thread t1(exact);
+    t1.join();
+    std::thread t2(estimate);
+    t2.join();
+    std::printf("alloc profiler: ok\n");
+    return 0;
+}
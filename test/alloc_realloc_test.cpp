@@ -0,0 +1,98 @@
+/*
+ * alloc::reallocate keeps the contents up to the smaller size whether the
+ * block stays in its size class, moves to another class, crosses between
+ * the pool and std::malloc either way, or is resized by std::realloc. A
+ * new size in the same class returns the same block, and a failed
+ * realloc leaves the old block to the caller.
+*/
+
+#include <cstring>
+#include <vector>
+
+#include "saber_alloc.h"
+#include "test_util.h"
+
+namespace {
+
+unsigned char pattern(size_t i) {
+    return static_cast<unsigned char>(i * 131 + 7);
+}
+
+void *make(size_t n) {
+    unsigned char *p = static_cast<unsigned char*>(saberstl::alloc::allocate(n));
+    for (size_t i = 0; i < n; i++) p[i] = pattern(i);
+    return p;
+}
+
+void expect_kept(const void *q, size_t n) {
+    const unsigned char *p = static_cast<const unsigned char*>(q);
+    for (size_t i = 0; i < n; i++) EXPECT(p[i] == pattern(i));
+}
+
+/* Resize from old_size to new_size and back, checking the contents */
+void round_trip(size_t old_size, size_t new_size) {
+    void *p = make(old_size);
+    void *q = saberstl::alloc::reallocate(p, old_size, new_size);
+    EXPECT(q != nullptr);
+    const size_t kept = old_size < new_size ? old_size : new_size;
+    expect_kept(q, kept);
+    /* The grown part is writable */
+    std::memset(static_cast<char*>(q) + kept, 0xAB, new_size - kept);
+    void *r = saberstl::alloc::reallocate(q, new_size, old_size);
+    EXPECT(r != nullptr);
+    expect_kept(r, kept);
+    saberstl::alloc::deallocate(r, old_size);
+}
+
+} // namespace
+
+int main() {
+    const size_t small = saberstl::ESmallObjectBytes;
+    static const size_t sizes[] = { 1, 7, 8, 60, 64, 65, 128, 129, 1000, small - 1, small,
+                                    small + 1, 3 * small, 64 * 1024, 1024 * 1024 };
+    for (size_t a : sizes) {
+        for (size_t b : sizes) round_trip(a, b);
+    }
+    {
+        /* From nullptr it only allocates */
+        void *p = saberstl::alloc::reallocate(nullptr, 0, 100);
+        EXPECT(p != nullptr);
+        saberstl::alloc::deallocate(p, 100);
+    }
+#ifndef SABERSTL_ALLOC_DEBUG
+    {
+        /* The same size class, the block does not move */
+        void *p = make(64);
+        EXPECT(saberstl::alloc::reallocate(p, 64, 60) == p);
+        EXPECT(saberstl::alloc::reallocate(p, 60, 64) == p);
+        expect_kept(p, 60);
+        saberstl::alloc::deallocate(p, 64);
+    }
+#if !defined(__SANITIZE_ADDRESS__) && !defined(__SANITIZE_THREAD__)
+    {
+        /* A realloc too large to succeed leaves the block as it was; the
+           sanitizers stop the program on such a request instead */
+        void *p = make(2 * small);
+        EXPECT(saberstl::alloc::reallocate(p, 2 * small, static_cast<size_t>(-1) / 2) == nullptr);
+        expect_kept(p, 2 * small);
+        saberstl::alloc::deallocate(p, 2 * small);
+    }
+#endif
+#endif
+    {
+        /* Growing a buffer step by step, as a vector does */
+        size_t n = 16;
+        void *p = make(n);
+        while (n < 4 * small) {
+            const size_t grown = n + n / 2 + 3;
+            p = saberstl::alloc::reallocate(p, n, grown);
+            EXPECT(p != nullptr);
+            expect_kept(p, n);
+            for (size_t i = n; i < grown; i++) static_cast<unsigned char*>(p)[i] = pattern(i);
+            n = grown;
+        }
+        saberstl::alloc::deallocate(p, n);
+    }
+    std::printf("alloc reallocate: ok\n");
+    return 0;
+}
@@ -0,0 +1,109 @@
+/*
+ * The statistics of alloc against a known sequence of allocations: the
+ * counters of a size class, the blocks in use and cached, the large
+ * blocks served by std::malloc, the live threads, and the counters a
+ * thread leaves behind when it exits. print and print_json write every
+ * field. Built with SABERSTL_ALLOC_STATS.
+*/
+
+#define SABERSTL_ALLOC_STATS
+
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "saber_alloc.h"
+#include "test_util.h"
+
+namespace {
+
+enum { ESmallCount = 10, EFreed = 4, EOtherCount = 5 };
+
+/* Everything written by f to a temporary file */
+template <class F>
+std::string capture(F f) {
+    std::FILE *out = std::tmpfile();
+    EXPECT(out != nullptr);
+    f(out);
+    std::string text;
+    std::rewind(out);
+    char buf[512];
+    size_t got;
+    while ((got = std::fread(buf, 1, sizeof(buf), out)) > 0) text.append(buf, got);
+    std::fclose(out);
+    return text;
+}
+
+void worker() {
+    using saberstl::alloc;
+    const size_t small = saberstl::ESmallObjectBytes;
+    const saberstl::alloc_stats s0 = alloc::statistics();
+    /* Two sizes of their own classes */
+    const size_t a = s0.classes[2].block_size;
+    const size_t b = s0.classes[10].block_size;
+
+    std::vector<void*> as, bs;
+    for (int i = 0; i < ESmallCount; i++) as.push_back(alloc::allocate(a));
+    for (int i = 0; i < EOtherCount; i++) bs.push_back(alloc::allocate(b));
+    for (int i = 0; i < EFreed; i++) alloc::deallocate(as[i], a);
+    void *big1 = alloc::allocate(small + 1);
+    void *big2 = alloc::allocate(4 * small);
+
+    saberstl::alloc_stats s = alloc::statistics();
+    /* The cache of this thread is made at its first allocation */
+    EXPECT(s.threads == s0.threads + 1);
+    EXPECT(s.classes[2].allocs - s0.classes[2].allocs == ESmallCount);
+    EXPECT(s.classes[2].deallocs - s0.classes[2].deallocs == EFreed);
+    EXPECT(s.classes[2].in_use - s0.classes[2].in_use == ESmallCount - EFreed);
+    EXPECT(s.classes[10].allocs - s0.classes[10].allocs == EOtherCount);
+    EXPECT(s.classes[10].in_use - s0.classes[10].in_use == EOtherCount);
+    EXPECT(s.bytes_in_use - s0.bytes_in_use == (ESmallCount - EFreed) * a + EOtherCount * b);
+    EXPECT(s.large_allocs - s0.large_allocs == 2);
+    EXPECT(s.large_bytes_in_use - s0.large_bytes_in_use == 5 * small + 1);
+    /* The refills took more than asked, the rest is cached in this thread */
+    EXPECT(s.classes[2].refills > s0.classes[2].refills);
+    EXPECT(s.classes[2].thread_cached > 0);
+    EXPECT(s.heap_bytes > 0 && s.chunk_grows > 0);
+
+    alloc::deallocate(big1, small + 1);
+    alloc::deallocate(big2, 4 * small);
+    for (size_t i = EFreed; i < as.size(); i++) alloc::deallocate(as[i], a);
+    for (void *p : bs) alloc::deallocate(p, b);
+    s = alloc::statistics();
+    EXPECT(s.large_deallocs - s0.large_deallocs == 2);
+    EXPECT(s.large_bytes_in_use == s0.large_bytes_in_use);
+    EXPECT(s.classes[2].in_use == s0.classes[2].in_use);
+    EXPECT(s.bytes_in_use == s0.bytes_in_use);
+
+    /* A flush moves the cached blocks of this thread to the shared pool */
+    const size_t cached = s.classes[2].thread_cached + s.classes[2].pool_cached;
+    alloc::flush_thread_cache();
+    s = alloc::statistics();
+    EXPECT(s.classes[2].thread_cached == 0);
+    EXPECT(s.classes[2].pool_cached == cached);
+}
+
+} // namespace
+
+int main() {
+    const saberstl::alloc_stats s0 = saberstl::alloc::statistics();
+    std::thread t(worker);
+    t.join();
+    /* The thread is gone, its counters are kept */
+    const saberstl::alloc_stats s = saberstl::alloc::statistics();
+    EXPECT(s.threads == s0.threads);
+    EXPECT(s.classes[2].allocs - s0.classes[2].allocs == ESmallCount);
+    EXPECT(s.classes[10].deallocs - s0.classes[10].deallocs == EOtherCount);
+    EXPECT(s.classes[2].thread_cached == s0.classes[2].thread_cached);
+
+    const std::string text = capture([&s](std::FILE *out) { s.print(out); });
+    EXPECT(text.find("saberstl alloc statistics") != std::string::npos);
+    EXPECT(text.find("chunk releases:") != std::string::npos);
+    const std::string json = capture([&s](std::FILE *out) { s.print_json(out); });
+    EXPECT(json.front() == '{' && json.find("]}\n") == json.size() - 3);
+    EXPECT(json.find("\"large_allocs\":" + std::to_string(s.large_allocs)) != std::string::npos);
+    EXPECT(json.find("{\"size\":" + std::to_string(s.classes[0].block_size)) != std::string::npos);
+    std::printf("alloc stats: ok\n");
+    return 0;
+}
@@ -0,0 +1,121 @@
+/*
+ * Stress alloc from many threads. Every thread allocates blocks of random
+ * sizes, fills them with a pattern made from the owner and the block, and
+ * hands half of them to the next thread, which checks the pattern and
+ * frees them: so the blocks go back to a cache other than the one they
+ * came from. Every round also takes a group of blocks of one size with
+ * allocate_bulk; half the groups are freed whole with deallocate_bulk,
+ * the others block by block by the next thread.
+ * Build with SANITIZE=thread to look for races.
+*/
+
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "saber_alloc.h"
+#include "test_util.h"
+
+namespace {
+
+enum { EThreads = 8, ERounds = 200, EBlocksPerRound = 256, EMaxBlockBytes = 6000 };
+
+struct block {
+    unsigned char *p;
+    size_t n;
+};
+
+/* Blocks handed to a thread by the previous one */
+struct mailbox {
+    std::mutex lock;
+    std::vector<block> blocks;
+};
+
+mailbox boxes[EThreads];
+
+unsigned char pattern(const unsigned char *p, size_t i) {
+    return static_cast<unsigned char>((reinterpret_cast<uintptr_t>(p) >> 4) + i);
+}
+
+void fill(const block& b) {
+    for (size_t i = 0; i < b.n; i++) b.p[i] = pattern(b.p, i);
+}
+
+void verify_and_free(const block& b) {
+    for (size_t i = 0; i < b.n; i++) EXPECT(b.p[i] == pattern(b.p, i));
+    saberstl::alloc::deallocate(b.p, b.n);
+}
+
+void worker(unsigned id) {
+    uint64_t seed = 0x9E3779B97F4A7C15ull * (id + 1);
+    std::vector<block> mine;
+    for (int r = 0; r < ERounds; r++) {
+        for (int i = 0; i < EBlocksPerRound; i++) {
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            /* Mostly small blocks, some over the pool limit */
+            size_t n = 1 + seed % (seed & 0x100 ? EMaxBlockBytes : 256);
+            block b = { static_cast<unsigned char*>(saberstl::alloc::allocate(n)), n };
+            EXPECT(b.p != nullptr);
+            fill(b);
+            mine.push_back(b);
+        }
+        /* A bulk group, small blocks mostly and at most a few large ones */
+        {
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            const size_t n = 1 + seed % (seed & 0x100 ? EMaxBlockBytes : 256);
+            const size_t count = 1 + (seed >> 20) % (n > 256 ? 8 : EBlocksPerRound);
+            void *group[EBlocksPerRound];
+            saberstl::alloc::allocate_bulk(n, count, group);
+            for (size_t i = 0; i < count; i++) {
+                EXPECT(group[i] != nullptr);
+                fill(block{ static_cast<unsigned char*>(group[i]), n });
+            }
+            if (r % 2 == 0) {
+                for (size_t i = 0; i < count; i++) {
+                    const unsigned char *p = static_cast<unsigned char*>(group[i]);
+                    for (size_t k = 0; k < n; k++) EXPECT(p[k] == pattern(p, k));
+                }
+                saberstl::alloc::deallocate_bulk(n, count, group);
+            } else {
+                for (size_t i = 0; i < count; i++) {
+                    mine.insert(mine.begin(), block{ static_cast<unsigned char*>(group[i]), n });
+                }
+            }
+        }
+        /* Half to the next thread, half freed here */
+        {
+            mailbox& next = boxes[(id + 1) % EThreads];
+            std::lock_guard<std::mutex> guard(next.lock);
+            next.blocks.insert(next.blocks.end(), mine.begin(), mine.begin() + mine.size() / 2);
+        }
+        for (size_t i = mine.size() / 2; i < mine.size(); i++) verify_and_free(mine[i]);
+        mine.clear();
+        std::vector<block> got;
+        {
+            std::lock_guard<std::mutex> guard(boxes[id].lock);
+            got.swap(boxes[id].blocks);
+        }
+        for (const block& b : got) verify_and_free(b);
+    }
+}
+
+} // namespace
+
+int main() {
+    std::vector<std::thread> threads;
+    for (unsigned i = 0; i < EThreads; i++) threads.emplace_back(worker, i);
+    for (std::thread& t : threads) t.join();
+    for (mailbox& box : boxes) {
+        for (const block& b : box.blocks) verify_and_free(b);
+        box.blocks.clear();
+    }
+    saberstl::alloc::flush_thread_cache();
+    saberstl::alloc::trim();
+    std::printf("alloc stress: ok\n");
+    return 0;
+}
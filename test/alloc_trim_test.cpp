@@ -0,0 +1,96 @@
+/*
+ * trim() gives back the chunks with no block in use: the heap bytes in the
+ * statistics drop by what it returns, and the pool still works after. With
+ * a trim threshold, freeing enough blocks trims without a call. Threads
+ * keep allocating while another trims. Read from the statistics, so built
+ * with SABERSTL_ALLOC_STATS.
+*/
+
+#define SABERSTL_ALLOC_STATS
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "saber_alloc.h"
+#include "test_util.h"
+
+namespace {
+
+enum { EBlockBytes = 200, EBlocks = 40000, EThreads = 3, ERounds = 300 };
+
+/* Enough blocks for several chunks, all freed by this thread */
+void churn_all() {
+    std::vector<void*> blocks(EBlocks);
+    for (void *&p : blocks) {
+        p = saberstl::alloc::allocate(EBlockBytes);
+        std::memset(p, 'a', EBlockBytes);
+    }
+    for (void *p : blocks) saberstl::alloc::deallocate(p, EBlockBytes);
+    saberstl::alloc::flush_thread_cache();
+}
+
+} // namespace
+
+int main() {
+    {
+        /* An explicit trim */
+        std::thread t(churn_all);
+        t.join();
+        const saberstl::alloc_stats before = saberstl::alloc::statistics();
+        EXPECT(before.heap_bytes >= static_cast<size_t>(EBlocks) * EBlockBytes);
+        const size_t released = saberstl::alloc::trim();
+        const saberstl::alloc_stats after = saberstl::alloc::statistics();
+        EXPECT(released > 0);
+        EXPECT(after.heap_bytes == before.heap_bytes - released);
+        EXPECT(after.chunk_releases > before.chunk_releases);
+        /* Nothing is left to give back */
+        EXPECT(saberstl::alloc::trim() == 0);
+        /* The pool grows again */
+        void *p = saberstl::alloc::allocate(EBlockBytes);
+        std::memset(p, 'b', EBlockBytes);
+        saberstl::alloc::deallocate(p, EBlockBytes);
+    }
+    {
+        /* An automatic trim, when the free bytes grow over the threshold */
+        saberstl::alloc::set_trim_threshold(EBlocks * EBlockBytes / 4);
+        const size_t releases = saberstl::alloc::statistics().chunk_releases;
+        std::thread t(churn_all);
+        t.join();
+        EXPECT(saberstl::alloc::statistics().chunk_releases > releases);
+        saberstl::alloc::set_trim_threshold(0);
+    }
+    {
+        /* Trims while other threads allocate and free */
+        std::atomic<bool> done(false);
+        std::vector<std::thread> workers;
+        for (int w = 0; w < EThreads; w++) {
+            workers.emplace_back([w] {
+                saberstl::test::rng r(w + 1);
+                std::vector<void*> blocks(1000);
+                for (int round = 0; round < ERounds; round++) {
+                    const size_t n = 8 + r.below(EBlockBytes);
+                    for (void *&p : blocks) {
+                        p = saberstl::alloc::allocate(n);
+                        std::memset(p, 'c', n);
+                    }
+                    for (void *p : blocks) saberstl::alloc::deallocate(p, n);
+                    if (round % 16 == 0) saberstl::alloc::flush_thread_cache();
+                }
+            });
+        }
+        std::thread trimmer([&done] {
+            while (!done.load(std::memory_order_relaxed)) {
+                saberstl::alloc::trim();
+                std::this_thread::yield();
+            }
+        });
+        for (std::thread& t : workers) t.join();
+        done.store(true, std::memory_order_relaxed);
+        trimmer.join();
+        EXPECT(saberstl::alloc::statistics().bytes_in_use == 0);
+    }
+    std::printf("alloc trim: ok\n");
+    return 0;
+}
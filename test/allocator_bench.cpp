@@ -0,0 +1,76 @@
+/*
+ * allocator<T>, where every block comes from ::operator new, against
+ * pool_allocator<T>, where the small ones come from alloc. Node churn: a fixed number of live nodes, one freed and one allocated
+ * at random per step, as a node-based container under steady load; and
+ * build-and-destroy of short lists of small arrays.
+*/
+
+#include <vector>
+
+#include "saber_allocator.h"
+#include "test_util.h"
+
+namespace {
+
+enum { ELiveNodes = 1 << 14, EChurnSteps = 1 << 22, EListRounds = 1 << 14, EListLength = 256 };
+
+struct node {
+    node *next;
+    node *prev;
+    long key;
+    long value;
+};
+
+template <template <class> class Allocator>
+double churn() {
+    typedef Allocator<node> node_allocator;
+    std::vector<node*> live(ELiveNodes);
+    for (node*& p : live) p = node_allocator::allocate();
+    saberstl::test::rng r;
+    saberstl::test::timer t;
+    for (int i = 0; i < EChurnSteps; i++) {
+        node*& p = live[r.below(ELiveNodes)];
+        node_allocator::deallocate(p);
+        p = node_allocator::allocate();
+        p->key = i;
+        saberstl::test::keep(p);
+    }
+    const double seconds = t.seconds();
+    for (node* p : live) node_allocator::deallocate(p);
+    return seconds;
+}
+
+/* Arrays of 8 to 256 bytes, freed with their size */
+template <template <class> class Allocator>
+double lists() {
+    typedef Allocator<char> byte_allocator;
+    struct item { char *p; size_t n; };
+    std::vector<item> items(EListLength);
+    saberstl::test::rng r;
+    saberstl::test::timer t;
+    for (int round = 0; round < EListRounds; round++) {
+        for (item& it : items) {
+            it.n = 8 + r.below(249);
+            it.p = byte_allocator::allocate(it.n);
+            it.p[0] = 0;
+        }
+        saberstl::test::keep(items);
+        for (item& it : items) byte_allocator::deallocate(it.p, it.n);
+    }
+    return t.seconds();
+}
+
+} // namespace
+
+int main() {
+    std::printf("allocator<T> (::operator new) against pool_allocator<T>\n");
+    saberstl::test::report("node churn, 32 byte nodes, allocator",
+                           churn<saberstl::allocator>(), 2.0 * EChurnSteps);
+    saberstl::test::report("node churn, 32 byte nodes, pool_allocator",
+                           churn<saberstl::pool_allocator>(), 2.0 * EChurnSteps);
+    saberstl::test::report("list of 8-256 byte arrays, allocator",
+                           lists<saberstl::allocator>(), 2.0 * EListRounds * EListLength);
+    saberstl::test::report("list of 8-256 byte arrays, pool_allocator",
+                           lists<saberstl::pool_allocator>(), 2.0 * EListRounds * EListLength);
+    return 0;
+}
@@ -0,0 +1,87 @@
+/*
+ * allocator<T> and pool_allocator<T> side by side in one program: only the
+ * blocks of pool_allocator come from alloc, small ones from a size class
+ * and large ones from its malloc path; bulk, over-aligned and rebound
+ * requests work with both. Read from the statistics, so built with
+ * SABERSTL_ALLOC_STATS.
+*/
+
+#define SABERSTL_ALLOC_STATS
+
+#include <cstring>
+
+#include "saber_allocator.h"
+#include "test_util.h"
+
+namespace {
+
+struct node {
+    node *next;
+    node *prev;
+    long key;
+    long value;
+};
+
+struct alignas(256) wide {
+    char bytes[256];
+};
+
+saberstl::alloc_class_stats class_of(size_t n) {
+    const saberstl::alloc_stats s = saberstl::alloc::statistics();
+    for (const saberstl::alloc_class_stats& c : s.classes) {
+        if (c.block_size >= n) return c;
+    }
+    EXPECT(false);
+    return s.classes[0];
+}
+
+template <template <class> class Allocator>
+void exercise() {
+    typedef Allocator<node> node_allocator;
+    typedef typename node_allocator::template rebind<char>::other byte_allocator;
+
+    node *n = node_allocator::allocate();
+    n->key = 1;
+    node_allocator::deallocate(n);
+
+    node *nodes[100];
+    node_allocator::allocate_bulk(nodes, 100);
+    for (size_t i = 0; i < 100; i++) nodes[i]->key = static_cast<long>(i);
+    for (size_t i = 0; i < 100; i++) EXPECT(nodes[i]->key == static_cast<long>(i));
+    node_allocator::deallocate_bulk(nodes, 100);
+
+    const size_t big = 3 * saberstl::ESmallObjectBytes;
+    char *p = byte_allocator::allocate(big);
+    std::memset(p, 'a', big);
+    byte_allocator::deallocate(p, big);
+
+    wide *w = Allocator<wide>::allocate(3);
+    EXPECT(reinterpret_cast<uintptr_t>(w) % alignof(wide) == 0);
+    Allocator<wide>::deallocate(w, 3);
+
+    char *line = byte_allocator::allocate(40, 64);
+    EXPECT(reinterpret_cast<uintptr_t>(line) % 64 == 0);
+    byte_allocator::deallocate(line, 40, 64);
+
+    EXPECT(node_allocator::allocate(0) == nullptr);
+}
+
+} // namespace
+
+int main() {
+    const size_t allocs = class_of(sizeof(node)).allocs;
+    const size_t large = saberstl::alloc::statistics().large_allocs;
+    exercise<saberstl::allocator>();
+    EXPECT(class_of(sizeof(node)).allocs == allocs);
+    EXPECT(saberstl::alloc::statistics().large_allocs == large);
+
+    exercise<saberstl::pool_allocator>();
+    EXPECT(class_of(sizeof(node)).allocs == allocs + 101);
+    EXPECT(saberstl::alloc::statistics().large_allocs > large);
+    EXPECT(class_of(sizeof(node)).in_use == 0);
+
+    EXPECT(saberstl::allocator<node>() == saberstl::allocator<char>());
+    EXPECT(saberstl::pool_allocator<node>() == saberstl::pool_allocator<char>());
+    std::printf("allocator: ok\n");
+    return 0;
+}
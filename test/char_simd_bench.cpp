@@ -0,0 +1,113 @@
+/*
+ * The char_simd kernels against plain loops over char16_t and char32_t
+ * text of 4096 characters: find with the match at the end, rfind with it
+ * at the start, find_of with 4 characters in and not in the set, length
+ * and compare of equal text.
+*/
+
+#include <vector>
+
+#include "saber_char_simd.h"
+#include "test_util.h"
+
+namespace {
+
+enum { ELen = 4096, ERounds = 1 << 14 };
+
+/* The loops are kept out of line so they are timed as written */
+template <class T>
+__attribute__((noinline)) const T* loop_find(const T* s, size_t n, T ch) {
+    for (size_t i = 0; i < n; i++) {
+        if (s[i] == ch) return s + i;
+    }
+    return nullptr;
+}
+
+template <class T>
+__attribute__((noinline)) const T* loop_rfind(const T* s, size_t n, T ch) {
+    while (n > 0) {
+        if (s[--n] == ch) return s + n;
+    }
+    return nullptr;
+}
+
+template <class T>
+__attribute__((noinline)) const T* loop_find_of(const T* s, size_t n, const T* set, size_t m, bool in) {
+    for (size_t i = 0; i < n; i++) {
+        bool hit = false;
+        for (size_t j = 0; j < m && !hit; j++) hit = s[i] == set[j];
+        if (hit == in) return s + i;
+    }
+    return nullptr;
+}
+
+template <class T>
+__attribute__((noinline)) size_t loop_length(const T* s) {
+    size_t n = 0;
+    for (; s[n] != T(0); n++) {}
+    return n;
+}
+
+template <class T>
+__attribute__((noinline)) int loop_compare(const T* s1, const T* s2, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (s1[i] != s2[i]) return s1[i] < s2[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+template <class F>
+void time_case(const char *type, const char *what, F f) {
+    char name[64];
+    std::snprintf(name, sizeof(name), "%s %s", type, what);
+    saberstl::test::timer t;
+    for (int r = 0; r < ERounds; r++) saberstl::test::keep(f());
+    saberstl::test::report(name, t.seconds(), ERounds);
+}
+
+template <class T>
+void run(const char *type) {
+    /* Text of 8 letters, the searched characters occur at one end only */
+    const T a = static_cast<T>(sizeof(T) == 2 ? 0x3041 : 0x1F600);
+    std::vector<T> text(ELen + 1), other(ELen + 1);
+    saberstl::test::rng rng;
+    for (size_t i = 0; i < ELen; i++) text[i] = static_cast<T>(a + rng.below(8));
+    text[ELen] = T(0);
+    other = text;
+    const T *s = text.data(), *o = other.data();
+    const T last = static_cast<T>(a + 8);
+    text[ELen - 1] = last;
+    other[0] = last;
+    const T set_in[] = { static_cast<T>(a + 8), static_cast<T>(a + 9), static_cast<T>(a + 10), last };
+    const T set_out[] = { static_cast<T>(a + 0), static_cast<T>(a + 1), static_cast<T>(a + 2),
+                          static_cast<T>(a + 3) };
+    std::vector<T> runs(ELen, a);
+    runs[ELen - 1] = last;
+
+    time_case(type, "find, char_simd", [&] { return saberstl::char_simd::find(s, ELen, last); });
+    time_case(type, "find, loop", [&] { return loop_find(s, ELen, last); });
+    time_case(type, "rfind, char_simd", [&] { return saberstl::char_simd::rfind(o, ELen, last); });
+    time_case(type, "rfind, loop", [&] { return loop_rfind(o, ELen, last); });
+    time_case(type, "find_of 4 in, char_simd",
+              [&] { return saberstl::char_simd::find_of(s, ELen, set_in, 4, true); });
+    time_case(type, "find_of 4 in, loop", [&] { return loop_find_of(s, ELen, set_in, 4, true); });
+    time_case(type, "find_of 4 not in, char_simd",
+              [&] { return saberstl::char_simd::find_of(runs.data(), ELen, set_out, 4, false); });
+    time_case(type, "find_of 4 not in, loop",
+              [&] { return loop_find_of(runs.data(), ELen, set_out, 4, false); });
+    time_case(type, "length, char_simd", [&] { return saberstl::char_simd::length(s); });
+    time_case(type, "length, loop", [&] { return loop_length(s); });
+    other = text;
+    o = other.data();
+    time_case(type, "compare, char_simd", [&] { return saberstl::char_simd::compare(s, o, ELen); });
+    time_case(type, "compare, loop", [&] { return loop_compare(s, o, ELen); });
+}
+
+} // namespace
+
+int main() {
+    std::printf("char_simd kernels over %d characters\n", static_cast<int>(ELen));
+    run<char16_t>("char16_t");
+    run<char32_t>("char32_t");
+    return 0;
+}
@@ -0,0 +1,4 @@
+/* The char_simd test with the SSE2 kernels only */
+
+#define SABERSTL_SIMD_NO_AVX2
+#include "char_simd_test.cpp"
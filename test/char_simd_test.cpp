@@ -0,0 +1,195 @@
+/*
+ * The kernels of char_simd against scalar loops, for characters of 1, 2
+ * and 4 bytes, from every offset in a 32-byte block and with every tail
+ * length up to a few blocks. char_simd_sse2_test runs the same with AVX2
+ * turned off.
+*/
+
+#include <cstring>
+
+#include "saber_char_simd.h"
+#include "test_util.h"
+
+namespace {
+
+enum { EBuf = 512, EMaxLen = 130, EAlphabet = 24 };
+
+/* The characters searched for. The wide ones share the low byte with the
+   narrow ones, so a kernel comparing bytes instead of characters fails. */
+template <class T>
+T letter(size_t k) {
+    const uint32_t base = sizeof(T) == 1 ? 'a' : sizeof(T) == 2 ? 0x3000 + 'a' : 0x1F600 + 'a';
+    return static_cast<T>(base + k);
+}
+
+template <class T>
+T impostor(size_t k) {
+    return sizeof(T) == 1 ? static_cast<T>('A' + k) : static_cast<T>('a' + k);
+}
+
+template <class T>
+const T* scalar_find(const T* s, size_t n, T ch) {
+    for (size_t i = 0; i < n; i++) {
+        if (s[i] == ch) return s + i;
+    }
+    return nullptr;
+}
+
+template <class T>
+const T* scalar_rfind(const T* s, size_t n, T ch) {
+    while (n > 0) {
+        if (s[--n] == ch) return s + n;
+    }
+    return nullptr;
+}
+
+template <class T>
+const T* scalar_find_of(const T* s, size_t n, const T* set, size_t m, bool in) {
+    for (size_t i = 0; i < n; i++) {
+        if ((scalar_find(set, m, s[i]) != nullptr) == in) return s + i;
+    }
+    return nullptr;
+}
+
+template <class T>
+int scalar_compare(const T* s1, const T* s2, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (s1[i] != s2[i]) return s1[i] < s2[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+template <class T>
+void test_find(saberstl::test::rng& rng) {
+    alignas(32) T buf[EBuf];
+    const size_t lanes = 32 / sizeof(T);
+    for (size_t off = 0; off < lanes; off++) {
+        for (size_t n = 0; n < EMaxLen; n++) {
+            for (size_t i = 0; i < EBuf; i++) buf[i] = letter<T>(rng.below(8));
+            const T* s = buf + off;
+            for (size_t k = 0; k < 9; k++) {
+                const T ch = letter<T>(k);
+                EXPECT(saberstl::char_simd::find(s, n, ch) == scalar_find(s, n, ch));
+                EXPECT(saberstl::char_simd::rfind(s, n, ch) == scalar_rfind(s, n, ch));
+                EXPECT(saberstl::char_simd::find(s, n, impostor<T>(k)) == nullptr);
+            }
+            /* One match, anywhere in the range or just past it */
+            for (size_t i = 0; i < EBuf; i++) buf[i] = letter<T>(0);
+            const size_t at = rng.below(n + 1);
+            buf[off + at] = letter<T>(1);
+            const T* expect = at < n ? s + at : nullptr;
+            EXPECT(saberstl::char_simd::find(s, n, letter<T>(1)) == expect);
+            EXPECT(saberstl::char_simd::rfind(s, n, letter<T>(1)) == expect);
+        }
+    }
+}
+
+template <class T>
+void test_find_of(saberstl::test::rng& rng) {
+    static const size_t set_sizes[] = { 0, 1, 2, 3, 7, 15, 16, 17, 24, 40 };
+    alignas(32) T buf[EBuf];
+    T set[40];
+    const size_t lanes = 32 / sizeof(T);
+    for (size_t off = 0; off < lanes; off++) {
+        for (size_t n = 0; n < EMaxLen; n++) {
+            for (size_t m : set_sizes) {
+                for (size_t j = 0; j < m; j++) set[j] = letter<T>(rng.below(EAlphabet));
+                const T* s = buf + off;
+                for (size_t i = 0; i < EBuf; i++) buf[i] = letter<T>(rng.below(EAlphabet));
+                for (int in = 0; in < 2; in++) {
+                    EXPECT(saberstl::char_simd::find_of(s, n, set, m, in != 0) ==
+                           scalar_find_of(s, n, set, m, in != 0));
+                }
+                /* Runs of set members with one outsider, so "not of" scans far */
+                if (m == 0) continue;
+                for (size_t i = 0; i < EBuf; i++) buf[i] = set[rng.below(m)];
+                buf[off + rng.below(n + 1)] = impostor<T>(rng.below(EAlphabet));
+                for (int in = 0; in < 2; in++) {
+                    EXPECT(saberstl::char_simd::find_of(s, n, set, m, in != 0) ==
+                           scalar_find_of(s, n, set, m, in != 0));
+                }
+            }
+        }
+    }
+}
+
+template <class T>
+void test_length() {
+    alignas(32) T buf[EBuf];
+    const size_t lanes = 32 / sizeof(T);
+    for (size_t off = 0; off < lanes; off++) {
+        for (size_t n = 0; n < EMaxLen; n++) {
+            /* Zeros before the string must not count */
+            for (size_t i = 0; i < EBuf; i++) buf[i] = T(0);
+            for (size_t i = 0; i < n; i++) buf[off + i] = letter<T>(i % 8);
+            EXPECT(saberstl::char_simd::length(buf + off) == n);
+            /* A character with a zero low byte is not the end */
+            if (sizeof(T) > 1 && n > 0) {
+                buf[off] = static_cast<T>(0x100);
+                EXPECT(saberstl::char_simd::length(buf + off) == n);
+            }
+        }
+    }
+}
+
+template <class T>
+void test_compare(saberstl::test::rng& rng) {
+    alignas(32) T a[EBuf];
+    alignas(32) T b[EBuf];
+    const size_t lanes = 32 / sizeof(T);
+    for (size_t off = 0; off < lanes; off++) {
+        const size_t off2 = (off * 3 + 1) % lanes;
+        for (size_t n = 0; n < EMaxLen; n++) {
+            for (size_t i = 0; i < n; i++) a[off + i] = b[off2 + i] = letter<T>(rng.below(8));
+            EXPECT(saberstl::char_simd::compare(a + off, b + off2, n) == 0);
+            if (n == 0) continue;
+            const size_t at = rng.below(n);
+            b[off2 + at] = rng.below(2) ? letter<T>(9) : impostor<T>(0);
+            const int expect = scalar_compare(a + off, b + off2, n);
+            EXPECT(expect != 0);
+            EXPECT(saberstl::char_simd::compare(a + off, b + off2, n) == expect);
+            EXPECT(saberstl::char_simd::compare(b + off2, a + off, n) == -expect);
+        }
+    }
+}
+
+template <class T>
+void test_fill() {
+    alignas(32) T buf[EBuf];
+    const size_t lanes = 32 / sizeof(T);
+    for (size_t off = 0; off < lanes; off++) {
+        for (size_t n = 0; n < EMaxLen; n++) {
+            for (size_t i = 0; i < EBuf; i++) buf[i] = letter<T>(0);
+            EXPECT(saberstl::char_simd::fill(buf + off, letter<T>(5), n) == buf + off);
+            for (size_t i = 0; i < EBuf; i++) {
+                const bool inside = i >= off && i < off + n;
+                EXPECT(buf[i] == (inside ? letter<T>(5) : letter<T>(0)));
+            }
+        }
+    }
+}
+
+template <class T>
+void run(const char *type) {
+    saberstl::test::rng rng(sizeof(T));
+    test_find<T>(rng);
+    test_find_of<T>(rng);
+    test_length<T>();
+    test_compare<T>(rng);
+    test_fill<T>();
+    std::printf("  %s: ok\n", type);
+}
+
+} // namespace
+
+int main() {
+#ifdef SABERSTL_SIMD_AVX2
+    std::printf("char_simd (AVX2 when the CPU has it)\n");
+#else
+    std::printf("char_simd (no AVX2)\n");
+#endif
+    run<char>("char");
+    run<char16_t>("char16_t");
+    run<char32_t>("char32_t");
+    return 0;
+}
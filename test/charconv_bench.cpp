@@ -0,0 +1,121 @@
+/*
+ * to_chars and from_chars against snprintf, strtoll and strtod on the
+ * numbers of a metrics exporter: counters of any size and measurements
+ * printed as the shortest text that reads back the same value.
+*/
+
+#include <cstdlib>
+#include <vector>
+
+#include "saber_charconv.h"
+#include "test_util.h"
+
+namespace {
+
+enum { ENumbers = 1 << 16, ERounds = 32 };
+
+} // namespace
+
+int main() {
+    std::vector<long long> ints(ENumbers);
+    std::vector<double> doubles(ENumbers);
+    saberstl::test::rng r;
+    for (int i = 0; i < ENumbers; i++) {
+        /* Numbers of 1 to 19 digits */
+        ints[i] = static_cast<long long>(r.next() >> (1 + r.below(63)));
+        if (r.below(4) == 0) ints[i] = -ints[i];
+        doubles[i] = static_cast<double>(r.next() >> 11) / (1ull << r.below(53)) * (r.below(2) ? 1 : -1);
+    }
+    const double ops = static_cast<double>(ENumbers) * ERounds;
+    char buf[64];
+
+    std::printf("number conversion, %d numbers\n", ENumbers);
+    size_t sum = 0;
+    saberstl::test::timer t;
+    for (int k = 0; k < ERounds; k++) {
+        for (long long v : ints) sum += saberstl::to_chars(buf, buf + sizeof(buf), v).ptr - buf;
+    }
+    saberstl::test::report("to_chars(long long)", t.seconds(), ops);
+    t = saberstl::test::timer();
+    for (int k = 0; k < ERounds; k++) {
+        for (long long v : ints) sum += std::snprintf(buf, sizeof(buf), "%lld", v);
+    }
+    saberstl::test::report("snprintf(\"%lld\")", t.seconds(), ops);
+    t = saberstl::test::timer();
+    for (int k = 0; k < ERounds; k++) {
+        saberstl::string line;
+        line.reserve(ENumbers * 21);
+        for (long long v : ints) saberstl::append_chars(line, v).push_back(',');
+        sum += line.size();
+    }
+    saberstl::test::report("append_chars(string, long long)", t.seconds(), ops);
+
+    t = saberstl::test::timer();
+    for (int k = 0; k < ERounds; k++) {
+        for (double v : doubles) sum += saberstl::to_chars(buf, buf + sizeof(buf), v).ptr - buf;
+    }
+    saberstl::test::report("to_chars(double), shortest", t.seconds(), ops);
+    t = saberstl::test::timer();
+    for (int k = 0; k < ERounds; k++) {
+        for (double v : doubles) sum += std::snprintf(buf, sizeof(buf), "%.17g", v);
+    }
+    saberstl::test::report("snprintf(\"%.17g\")", t.seconds(), ops);
+
+    /* The texts to parse, one buffer with a null after each */
+    std::vector<char> int_text, double_text;
+    for (long long v : ints) {
+        char *end = saberstl::to_chars(buf, buf + sizeof(buf), v).ptr;
+        int_text.insert(int_text.end(), buf, end);
+        int_text.push_back('\0');
+    }
+    for (double v : doubles) {
+        char *end = saberstl::to_chars(buf, buf + sizeof(buf), v).ptr;
+        double_text.insert(double_text.end(), buf, end);
+        double_text.push_back('\0');
+    }
+
+    long long iv = 0;
+    t = saberstl::test::timer();
+    for (int k = 0; k < ERounds; k++) {
+        const char *p = int_text.data(), *end = p + int_text.size();
+        while (p < end) {
+            p = saberstl::from_chars(p, end, iv).ptr + 1;
+            sum += static_cast<size_t>(iv);
+        }
+    }
+    saberstl::test::report("from_chars(long long)", t.seconds(), ops);
+    t = saberstl::test::timer();
+    for (int k = 0; k < ERounds; k++) {
+        const char *p = int_text.data(), *end = p + int_text.size();
+        while (p < end) {
+            char *next;
+            sum += static_cast<size_t>(std::strtoll(p, &next, 10));
+            p = next + 1;
+        }
+    }
+    saberstl::test::report("strtoll", t.seconds(), ops);
+
+    double dv = 0, dsum = 0;
+    t = saberstl::test::timer();
+    for (int k = 0; k < ERounds; k++) {
+        const char *p = double_text.data(), *end = p + double_text.size();
+        while (p < end) {
+            p = saberstl::from_chars(p, end, dv).ptr + 1;
+            dsum += dv;
+        }
+    }
+    saberstl::test::report("from_chars(double)", t.seconds(), ops);
+    t = saberstl::test::timer();
+    for (int k = 0; k < ERounds; k++) {
+        const char *p = double_text.data(), *end = p + double_text.size();
+        while (p < end) {
+            char *next;
+            dsum += std::strtod(p, &next);
+            p = next + 1;
+        }
+    }
+    saberstl::test::report("strtod", t.seconds(), ops);
+    saberstl::test::keep(sum);
+    saberstl::test::keep(dsum);
+    return 0;
+}
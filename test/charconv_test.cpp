@@ -0,0 +1,222 @@
+/*
+ * to_chars and from_chars: random doubles, floats and integers written and
+ * read back unchanged, integers in every base from 2 to 36, the errors for
+ * numbers out of range and for a buffer too short, and inputs of more than
+ * 800 digits, which go through the strtod fallback and must round as if
+ * every digit was kept.
+*/
+
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <system_error>
+
+#include "saber_charconv.h"
+#include "test_util.h"
+
+namespace {
+
+enum { ERandom = 200000 };
+
+template <class T, class Bits>
+T from_bits(Bits bits) {
+    T value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+template <class T>
+bool same_bits(T a, T b) {
+    return std::memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+/* Write then read back, the text must also read the same with strtod */
+template <class T>
+void round_trip(T value) {
+    char buf[saberstl::EMaxDoubleChars + 1];
+    const saberstl::to_chars_result w = saberstl::to_chars(buf, buf + saberstl::EMaxDoubleChars, value);
+    EXPECT(w.ec == std::errc());
+    *w.ptr = '\0';
+    T back = T(-1);
+    const saberstl::from_chars_result r = saberstl::from_chars(buf, w.ptr, back);
+    EXPECT(r.ec == std::errc());
+    EXPECT(r.ptr == w.ptr);
+    EXPECT(same_bits(back, value));
+    EXPECT(same_bits(static_cast<T>(std::is_same<T, float>::value ? std::strtof(buf, nullptr)
+                                                                  : std::strtod(buf, nullptr)), value));
+}
+
+/* The digits of value in base, the way to_chars must write them */
+template <class Int>
+std::string reference(Int value, int base) {
+    typedef typename std::make_unsigned<Int>::type U;
+    const bool neg = value < 0;
+    U u = neg ? static_cast<U>(U(0) - static_cast<U>(value)) : static_cast<U>(value);
+    std::string s;
+    do {
+        s.insert(s.begin(), "0123456789abcdefghijklmnopqrstuvwxyz"[u % base]);
+        u /= base;
+    } while (u != 0);
+    if (neg) s.insert(s.begin(), '-');
+    return s;
+}
+
+template <class Int>
+void int_round_trip(Int value, int base) {
+    char buf[saberstl::EMaxIntegerChars];
+    const saberstl::to_chars_result w = saberstl::to_chars(buf, buf + sizeof(buf), value, base);
+    EXPECT(w.ec == std::errc());
+    EXPECT(std::string(buf, w.ptr) == reference(value, base));
+    Int back = Int(0);
+    const saberstl::from_chars_result r = saberstl::from_chars(buf, w.ptr, back, base);
+    EXPECT(r.ec == std::errc());
+    EXPECT(r.ptr == w.ptr);
+    EXPECT(back == value);
+}
+
+template <class Int>
+void test_ints(saberstl::test::rng& rng) {
+    for (int base = 2; base <= 36; base++) {
+        int_round_trip(std::numeric_limits<Int>::min(), base);
+        int_round_trip(std::numeric_limits<Int>::max(), base);
+        int_round_trip(Int(0), base);
+        for (int i = 0; i < ERandom / 35; i++) {
+            /* Values of every length, not only ones near the top */
+            const uint64_t bits = rng.next() >> rng.below(64);
+            int_round_trip(static_cast<Int>(bits), base);
+        }
+    }
+    /* One past the range */
+    const std::string over = reference(std::numeric_limits<Int>::max(), 10) + "0";
+    Int v = Int(7);
+    saberstl::from_chars_result r = saberstl::from_chars(over.data(), over.data() + over.size(), v);
+    EXPECT(r.ec == std::errc::result_out_of_range);
+    EXPECT(r.ptr == over.data() + over.size());
+    EXPECT(v == Int(7));
+}
+
+/* from_chars reads text as strtod and strtof do, or tells it is out of range */
+template <class T>
+void expect_like_strto(const std::string& text) {
+    errno = 0;
+    const T want = std::is_same<T, float>::value ? std::strtof(text.c_str(), nullptr)
+                                                 : std::strtod(text.c_str(), nullptr);
+    const bool range = errno == ERANGE && (want == T(0) || std::isinf(want));
+    T v = T(7);
+    const saberstl::from_chars_result r = saberstl::from_chars(text.data(), text.data() + text.size(), v);
+    EXPECT(r.ptr == text.data() + text.size());
+    if (range) {
+        EXPECT(r.ec == std::errc::result_out_of_range);
+        EXPECT(v == T(7));
+    } else {
+        EXPECT(r.ec == std::errc());
+        EXPECT(same_bits(v, want));
+    }
+}
+
+} // namespace
+
+int main() {
+    saberstl::test::rng rng(2023);
+    for (int i = 0; i < ERandom; i++) {
+        const double d = from_bits<double>(rng.next());
+        if (std::isfinite(d)) round_trip(d);
+        const float f = from_bits<float>(static_cast<uint32_t>(rng.next()));
+        if (std::isfinite(f)) round_trip(f);
+    }
+    round_trip(std::numeric_limits<double>::min());
+    round_trip(std::numeric_limits<double>::denorm_min());
+    round_trip(std::numeric_limits<double>::max());
+    round_trip(std::numeric_limits<float>::denorm_min());
+    round_trip(std::numeric_limits<float>::max());
+    round_trip(-0.0);
+
+    test_ints<int8_t>(rng);
+    test_ints<uint16_t>(rng);
+    test_ints<int32_t>(rng);
+    test_ints<uint32_t>(rng);
+    test_ints<int64_t>(rng);
+    test_ints<uint64_t>(rng);
+
+    {
+        /* Out of range both ways, the value is left alone */
+        static const char *const huge[] = { "1e400", "-1e400", "1e-400", "1e-400000000", "1e999999999" };
+        for (const char *s : huge) {
+            double v = 7.0;
+            const saberstl::from_chars_result r = saberstl::from_chars(s, s + std::strlen(s), v);
+            EXPECT(r.ec == std::errc::result_out_of_range);
+            EXPECT(r.ptr == s + std::strlen(s));
+            EXPECT(v == 7.0);
+        }
+        float f = 7.0f;
+        const char *s = "1e39";
+        EXPECT(saberstl::from_chars(s, s + 4, f).ec == std::errc::result_out_of_range);
+        EXPECT(f == 7.0f);
+        /* A subnormal result is not out of range */
+        s = "4e-320";
+        double v = 0;
+        EXPECT(saberstl::from_chars(s, s + 6, v).ec == std::errc());
+        EXPECT(v > 0 && v < std::numeric_limits<double>::min());
+    }
+    {
+        /* A buffer one short of the text */
+        char buf[32];
+        const char *const want = "-1.2345678901234567e+300";
+        const double d = std::strtod(want, nullptr);
+        saberstl::to_chars_result w = saberstl::to_chars(buf, buf + sizeof(buf), d);
+        EXPECT(w.ec == std::errc());
+        const ptrdiff_t len = w.ptr - buf;
+        w = saberstl::to_chars(buf, buf + len - 1, d);
+        EXPECT(w.ec == std::errc::value_too_large);
+        EXPECT(w.ptr == buf + len - 1);
+        w = saberstl::to_chars(buf, buf, 0.5);
+        EXPECT(w.ec == std::errc::value_too_large);
+        w = saberstl::to_chars(buf, buf + 2, std::numeric_limits<double>::infinity());
+        EXPECT(w.ec == std::errc::value_too_large);
+        w = saberstl::to_chars(buf, buf + 3, -1234);
+        EXPECT(w.ec == std::errc::value_too_large);
+        w = saberstl::to_chars(buf, buf + 7, 255u, 2);
+        EXPECT(w.ec == std::errc::value_too_large);
+        w = saberstl::to_chars(buf, buf + 8, 255u, 2);
+        EXPECT(w.ec == std::errc() && std::string(buf, w.ptr) == "11111111");
+    }
+    {
+        /* Halfway between two doubles, decided by a digit past the 800th */
+        const std::string zeros(900, '0');
+        const std::string half = "9007199254740993." + zeros;
+        double v = 0;
+        saberstl::from_chars(half.data(), half.data() + half.size(), v);
+        EXPECT(v == 9007199254740992.0);
+        const std::string above = half + "1";
+        saberstl::from_chars(above.data(), above.data() + above.size(), v);
+        EXPECT(v == 9007199254740994.0);
+        const std::string below = "9007199254740992." + std::string(900, '9');
+        saberstl::from_chars(below.data(), below.data() + below.size(), v);
+        EXPECT(v == 9007199254740992.0);
+
+        const std::string fhalf = "16777217." + zeros + "1";
+        float f = 0;
+        saberstl::from_chars(fhalf.data(), fhalf.data() + fhalf.size(), f);
+        EXPECT(f == 16777218.0f);
+
+        /* Long random inputs with and without a point and an exponent */
+        for (int i = 0; i < 2000; i++) {
+            std::string text;
+            const size_t n = 780 + rng.below(200);
+            for (size_t k = 0; k < n; k++) text += static_cast<char>('0' + rng.below(10));
+            switch (rng.below(3)) {
+            case 0: text = "0.000" + text; break;
+            case 1: text.insert(rng.below(n), 1, '.'); break;
+            default: break;
+            }
+            if (rng.below(2)) text += "e" + std::to_string(static_cast<int>(rng.below(2000)) - 1300);
+            expect_like_strto<double>(text);
+            expect_like_strto<float>(text);
+        }
+    }
+    std::printf("charconv: ok\n");
+    return 0;
+}
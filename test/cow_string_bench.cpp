@@ -0,0 +1,69 @@
+/*
+ * Fan-out of read-only strings: a payload copied to many components that
+ * only read it, with cow_string, where a copy shares the buffer, against
+ * the deep copy of basic_string. Also from 4 threads copying the same
+ * string at once, where all the copies hit the same reference count.
+*/
+
+#include <thread>
+#include <vector>
+
+#include "saber_cow_string.h"
+#include "new_counter.h"
+#include "test_util.h"
+
+namespace {
+
+enum { EComponents = 1 << 10, ERounds = 1 << 9, EThreads = 4 };
+
+/* Give every new component a copy of source, then read one character of each */
+template <class String>
+size_t fan_out(const String& source, std::vector<String>& components) {
+    size_t sum = 0;
+    components.reserve(EComponents);
+    for (int r = 0; r < ERounds; r++) {
+        components.clear();
+        for (int i = 0; i < EComponents; i++) components.push_back(source);
+        for (const String& c : components) sum += static_cast<unsigned char>(c.c_str()[r % c.size()]);
+    }
+    return sum;
+}
+
+template <class String>
+void run(const char *type, size_t bytes) {
+    const String source(saberstl::string(bytes, 'x').c_str(), bytes);
+    const double ops = static_cast<double>(EComponents) * ERounds;
+    char name[64];
+
+    std::vector<String> components;
+    size_t allocs = saberstl::test::new_count();
+    saberstl::test::timer t;
+    saberstl::test::keep(fan_out(source, components));
+    std::snprintf(name, sizeof(name), "%s, %zu bytes", type, bytes);
+    saberstl::test::report(name, t.seconds(), ops, saberstl::test::new_count() - allocs);
+
+    allocs = saberstl::test::new_count();
+    t = saberstl::test::timer();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < EThreads; i++) {
+        threads.emplace_back([&source] {
+            std::vector<String> mine;
+            saberstl::test::keep(fan_out(source, mine));
+        });
+    }
+    for (std::thread& th : threads) th.join();
+    std::snprintf(name, sizeof(name), "%s, %zu bytes, %d threads", type, bytes, EThreads);
+    saberstl::test::report(name, t.seconds(), ops * EThreads, saberstl::test::new_count() - allocs);
+}
+
+} // namespace
+
+int main() {
+    std::printf("string fan-out to %d components\n", EComponents);
+    const size_t sizes[] = { 64, 4096 };
+    for (size_t bytes : sizes) {
+        run<saberstl::cow_string>("cow_string", bytes);
+        run<saberstl::string>("basic_string", bytes);
+    }
+    return 0;
+}
@@ -0,0 +1,179 @@
+/*
+ * cow_string: copies share one buffer without an allocation, and a write
+ * to one of them copies it first. A mutable reference leaks the buffer,
+ * so a later copy takes its own and the reference never writes into the
+ * copy. Edits taking their characters from the string itself, shared or
+ * not, in place or through a new buffer, give what std::string does, and
+ * so do random edits of copies. Threads copying one string leave the
+ * count right.
+*/
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "saber_cow_string.h"
+#include "new_counter.h"
+#include "test_util.h"
+
+namespace {
+
+typedef saberstl::cow_string cow;
+typedef saberstl::string_view view;
+
+bool same(const cow& s, const std::string& ref) {
+    return s.view() == view(ref.data(), ref.size()) && s.c_str()[s.size()] == '\0';
+}
+
+} // namespace
+
+int main() {
+    {
+        /* A copy shares, a write detaches */
+        cow a("shared characters");
+        const size_t calls = saberstl::test::new_count();
+        cow b(a);
+        cow c;
+        c = b;
+        EXPECT(saberstl::test::new_count() == calls);
+        EXPECT(a.use_count() == 3 && a.c_str() == b.c_str() && b.c_str() == c.c_str());
+        b.append("!");
+        EXPECT(a.use_count() == 2 && b.use_count() == 1);
+        EXPECT(a == "shared characters" && b == "shared characters!" && c == a);
+        c.clear();
+        EXPECT(c.use_count() == 0 && c.empty() && c.c_str()[0] == '\0');
+        EXPECT(a.use_count() == 1);
+        cow moved(std::move(a));
+        EXPECT(a.use_count() == 0 && moved.use_count() == 1);
+    }
+    {
+        /* A mutable reference leaks the buffer, copies made after take their own */
+        cow s("abcdef");
+        char& r = s[0];
+        cow t(s);
+        EXPECT(t.c_str() != s.c_str());
+        EXPECT(s.use_count() == 1 && t.use_count() == 1);
+        r = 'X';
+        EXPECT(s == "Xbcdef" && t == "abcdef");
+        /* The same for the other mutable accessors */
+        cow u("uvw");
+        char *it = u.begin();
+        cow v = u;
+        *it = 'U';
+        EXPECT(u == "Uvw" && v == "uvw");
+        cow w("wxyz");
+        char *d = w.data();
+        cow x;
+        x = w;
+        d[3] = 'Z';
+        w.at(0) = 'W';
+        EXPECT(w == "WxyZ" && x == "wxyz");
+    }
+    {
+        /* A string shared before the reference detaches to leak */
+        cow s("shared");
+        cow t(s);
+        s.front() = 'S';
+        s.back() = 'D';
+        EXPECT(s == "ShareD" && t == "shared");
+        EXPECT(s.use_count() == 1 && t.use_count() == 1);
+    }
+    {
+        /* Self-aliasing edits: unique with room, shared, and leaked */
+        for (int mode = 0; mode < 3; mode++) {
+            cow s("0123456789");
+            std::string ref("0123456789");
+            cow other;
+            if (mode == 0) s.reserve(200);
+            if (mode == 1) other = s;
+            if (mode == 2) s[0] = '0';
+            s.append(s.view());
+            ref.append(ref);
+            EXPECT(same(s, ref));
+            s.insert(3, s.view().substr(5, 7));
+            ref.insert(3, ref.substr(5, 7));
+            EXPECT(same(s, ref));
+            s.replace(1, 4, s.view());
+            ref.replace(1, 4, std::string(ref));
+            EXPECT(same(s, ref));
+            s += s;
+            ref += std::string(ref);
+            EXPECT(same(s, ref));
+            s.assign(s.view().substr(2, 9));
+            ref.assign(ref.substr(2, 9));
+            EXPECT(same(s, ref));
+            if (mode == 1) EXPECT(other == "0123456789");
+        }
+    }
+    {
+        /* Random edits of a string and its copies against std::string */
+        saberstl::test::rng r;
+        std::vector<cow> strs(4);
+        std::vector<std::string> refs(4);
+        for (int step = 0; step < 20000; step++) {
+            const size_t i = r.below(4);
+            cow& s = strs[i];
+            std::string& ref = refs[i];
+            const size_t pos = r.below(ref.size() + 1);
+            const size_t count = r.below(8);
+            switch (r.below(8)) {
+            case 0: {
+                const size_t j = r.below(4);
+                strs[j] = s;
+                refs[j] = ref;
+                break;
+            }
+            case 1:
+                s.append(count, static_cast<char>('a' + step % 26));
+                ref.append(count, static_cast<char>('a' + step % 26));
+                break;
+            case 2:
+                s.erase(pos, count);
+                ref.erase(pos, count);
+                break;
+            case 3:
+                s.insert(pos, "xyz", count % 4);
+                ref.insert(pos, "xyz", count % 4);
+                break;
+            case 4:
+                s.replace(pos, count, s.view().substr(0, count));
+                ref.replace(pos, count, ref.substr(0, count));
+                break;
+            case 5:
+                if (pos < ref.size()) {
+                    s[pos] = '#';
+                    ref[pos] = '#';
+                }
+                break;
+            case 6:
+                s.push_back('!');
+                ref.push_back('!');
+                break;
+            default:
+                if (ref.size() > 64) {
+                    s.resize(count);
+                    ref.resize(count);
+                }
+                break;
+            }
+            for (size_t k = 0; k < strs.size(); k++) EXPECT(same(strs[k], refs[k]));
+        }
+    }
+    {
+        /* Copies made and dropped by several threads at once */
+        const cow s("a string shared by every thread");
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++) {
+            threads.emplace_back([&s] {
+                for (int i = 0; i < 20000; i++) {
+                    cow copy(s);
+                    EXPECT(copy.size() == s.size());
+                }
+            });
+        }
+        for (std::thread& t : threads) t.join();
+        EXPECT(s.use_count() == 1);
+    }
+    std::printf("cow_string: ok\n");
+    return 0;
+}
@@ -0,0 +1,134 @@
+/*
+ * pmr::string on memory resources: the buffers come from the resource of
+ * the string, a copy takes the default resource, a move between strings
+ * of different resources copies the characters, and the blocks of
+ * numa_resource go back to the node they come from.
+*/
+
+#include <cstring>
+
+#include "saber_memory_resource.h"
+#include "test_util.h"
+
+namespace {
+
+/* Counts the bytes it holds, takes them from new_delete_resource() */
+class counting_resource : public saberstl::memory_resource {
+public:
+    size_t bytes = 0;
+    size_t allocs = 0;
+
+private:
+    void *do_allocate(size_t n, size_t align) override {
+        bytes += n;
+        allocs++;
+        return saberstl::new_delete_resource()->allocate(n, align);
+    }
+
+    void do_deallocate(void *p, size_t n, size_t align) override {
+        bytes -= n;
+        saberstl::new_delete_resource()->deallocate(p, n, align);
+    }
+
+    bool do_is_equal(const saberstl::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+const char *const long_text = "a string too long to live in the object itself";
+
+} // namespace
+
+int main() {
+    /* The default string does not grow by the allocator */
+    EXPECT(sizeof(saberstl::string) == 3 * sizeof(void*));
+
+    counting_resource a, b;
+    {
+        saberstl::pmr::string s(&a);
+        EXPECT(s.get_allocator().resource() == &a);
+        s = "short";
+        EXPECT(a.allocs == 0);
+        for (int i = 0; i < 100; i++) s.append(long_text);
+        EXPECT(a.allocs > 0 && a.bytes >= s.size());
+        EXPECT(b.allocs == 0);
+
+        saberstl::pmr::string sub = s.substr(3, 40);
+        EXPECT(sub.get_allocator().resource() == &a);
+
+        saberstl::pmr::string t(long_text, &b);
+        EXPECT(b.allocs == 1);
+        const size_t a_bytes = a.bytes;
+        t = saberstl::move(s);
+        EXPECT(t.get_allocator().resource() == &b);
+        EXPECT(t.size() == 5 + 100 * std::strlen(long_text));
+        EXPECT(a.bytes == a_bytes);
+
+        saberstl::pmr::string u(long_text, &b);
+        t = saberstl::move(u);
+        EXPECT(u.empty());
+        EXPECT(t == long_text);
+
+        saberstl::pmr::string copy(t);
+        EXPECT(copy.get_allocator().resource() == saberstl::get_default_resource());
+
+        saberstl::pmr::string sum = t + copy;
+        EXPECT(sum.get_allocator().resource() == &b);
+
+        saberstl::pmr::string x(long_text, &a), y(long_text, &b);
+        x.swap(y);
+        EXPECT(x.get_allocator().resource() == &b && y.get_allocator().resource() == &a);
+    }
+    EXPECT(a.bytes == 0 && b.bytes == 0);
+
+    /* A range is copied through the resource of the string it goes into */
+    {
+        counting_resource d;
+        saberstl::memory_resource *old = saberstl::set_default_resource(&d);
+        saberstl::pmr::string s(&a);
+        const char *last = long_text + std::strlen(long_text);
+        s.append(long_text, last);
+        s.insert(s.begin(), long_text, last);
+        EXPECT(s.size() == 2 * std::strlen(long_text));
+        EXPECT(d.allocs == 0);
+        saberstl::set_default_resource(old);
+    }
+    EXPECT(a.bytes == 0);
+
+    /* Strings on an arena and on the pool */
+    {
+        saberstl::arena_resource arena;
+        saberstl::pmr::string s(&arena);
+        for (int i = 0; i < 100; i++) s += long_text;
+        saberstl::pmr::string p(long_text, saberstl::pool_resource());
+        p += s;
+        EXPECT(p.size() == 101 * std::strlen(long_text));
+    }
+
+    /* The resources of the nodes */
+    for (size_t node = 0; node < saberstl::numa_node_count(); node++) {
+        saberstl::memory_resource *r = saberstl::numa_resource(node);
+        EXPECT(*r == *saberstl::numa_resource(node));
+        EXPECT(*r != *saberstl::pool_resource());
+        void *small = r->allocate(48);
+        void *aligned = r->allocate(100, 64);
+        void *large = r->allocate(100000);
+        EXPECT(reinterpret_cast<uintptr_t>(aligned) % 64 == 0);
+        std::memset(small, 1, 48);
+        std::memset(aligned, 2, 100);
+        std::memset(large, 3, 100000);
+        r->deallocate(small, 48);
+        r->deallocate(aligned, 100, 64);
+        r->deallocate(large, 100000);
+
+        saberstl::pmr::string s(long_text, r);
+        for (int i = 0; i < 10; i++) s += s;
+        EXPECT(s.size() == 1024 * std::strlen(long_text));
+    }
+    if (saberstl::numa_node_count() > 1) {
+        EXPECT(*saberstl::numa_resource(0) != *saberstl::numa_resource(1));
+    }
+
+    std::printf("memory resource: ok\n");
+    return 0;
+}
@@ -0,0 +1,45 @@
+#ifndef SABERSTL_NEW_COUNTER_H
+#define SABERSTL_NEW_COUNTER_H
+
+/*
+ * Replaces the global operator new and delete to count the allocations of
+ * a benchmark. Include it in one source of a program only. delete is not
+ * inlined, or GCC takes the free of a block from new for a mismatch.
+*/
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace saberstl {
+namespace test {
+
+inline std::atomic<size_t>& new_calls() {
+    static std::atomic<size_t> calls(0);
+    return calls;
+}
+
+/* Calls of operator new so far */
+inline size_t new_count() {
+    return new_calls().load(std::memory_order_relaxed);
+}
+
+} // namespace test
+} // namespace saberstl
+
+void* operator new(size_t n) {
+    saberstl::test::new_calls().fetch_add(1, std::memory_order_relaxed);
+    void *p = std::malloc(n == 0 ? 1 : n);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+__attribute__((noinline)) void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void *p, size_t) noexcept {
+    std::free(p);
+}
+
+#endif // !SABERSTL_NEW_COUNTER_H
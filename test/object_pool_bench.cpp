@@ -0,0 +1,135 @@
+/*
+ * object_pool against new and delete for 32 byte nodes: churn of a fixed
+ * number of live nodes, one destroyed and one created at random per step;
+ * building and tearing down lists, one node at a time and with clear();
+ * and nodes created by one thread and destroyed by another, then created
+ * again by the first.
+*/
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "saber_object_pool.h"
+#include "test_util.h"
+
+namespace {
+
+enum { ELiveNodes = 1 << 14, EChurnSteps = 1 << 22, EListRounds = 1 << 10, EListLength = 1 << 12,
+       EHandoff = 1 << 20 };
+
+struct node {
+    node *next;
+    node *prev;
+    long key;
+    long value;
+
+    explicit node(long k) : next(nullptr), prev(nullptr), key(k), value(0) {}
+};
+
+typedef saberstl::object_pool<node> node_pool;
+
+/* The pool and new/delete behind one interface */
+struct use_pool {
+    node_pool& pool;
+    node* create(long k) { return pool.create(k); }
+    void destroy(node* p) { pool.destroy(p); }
+};
+
+struct use_new {
+    node* create(long k) { return new node(k); }
+    void destroy(node* p) { delete p; }
+};
+
+template <class Use>
+double churn(Use use) {
+    std::vector<node*> live(ELiveNodes);
+    for (node*& p : live) p = use.create(0);
+    saberstl::test::rng r;
+    saberstl::test::timer t;
+    for (int i = 0; i < EChurnSteps; i++) {
+        node*& p = live[r.below(ELiveNodes)];
+        use.destroy(p);
+        p = use.create(i);
+        saberstl::test::keep(p);
+    }
+    const double seconds = t.seconds();
+    for (node* p : live) use.destroy(p);
+    return seconds;
+}
+
+template <class Use>
+double lists(Use use) {
+    saberstl::test::timer t;
+    for (int round = 0; round < EListRounds; round++) {
+        node *head = nullptr;
+        for (int i = 0; i < EListLength; i++) {
+            node *p = use.create(i);
+            p->next = head;
+            head = p;
+        }
+        saberstl::test::keep(head);
+        while (head != nullptr) {
+            node *next = head->next;
+            use.destroy(head);
+            head = next;
+        }
+    }
+    return t.seconds();
+}
+
+/* The same lists dropped at once with clear() */
+double lists_clear() {
+    node_pool pool;
+    saberstl::test::timer t;
+    for (int round = 0; round < EListRounds; round++) {
+        node *head = nullptr;
+        for (int i = 0; i < EListLength; i++) {
+            node *p = pool.create(i);
+            p->next = head;
+            head = p;
+        }
+        saberstl::test::keep(head);
+        pool.clear();
+    }
+    return t.seconds();
+}
+
+/* Nodes created by this thread and destroyed by another, then created
+   again here, which takes the slots back from the remote list */
+template <class Use>
+void remote(Use use, const char *name) {
+    std::vector<node*> nodes(EHandoff);
+    for (int round = 0; round < 2; round++) {
+        saberstl::test::timer t;
+        for (node*& p : nodes) p = use.create(0);
+        const double create = t.seconds();
+        t = saberstl::test::timer();
+        std::thread other([&nodes, use]() mutable {
+            for (node* p : nodes) use.destroy(p);
+        });
+        other.join();
+        const double destroy = t.seconds();
+        if (round == 0) continue;
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), "create, %s", name);
+        saberstl::test::report(buf, create, EHandoff);
+        std::snprintf(buf, sizeof(buf), "destroy by another thread, %s", name);
+        saberstl::test::report(buf, destroy, EHandoff);
+    }
+}
+
+} // namespace
+
+int main() {
+    std::printf("object_pool against new/delete, 32 byte nodes\n");
+    node_pool& pool = node_pool::local();
+    saberstl::test::report("churn, object_pool", churn(use_pool{ pool }), 2.0 * EChurnSteps);
+    saberstl::test::report("churn, new/delete", churn(use_new()), 2.0 * EChurnSteps);
+    saberstl::test::report("lists, object_pool", lists(use_pool{ pool }), 2.0 * EListRounds * EListLength);
+    saberstl::test::report("lists, object_pool clear()", lists_clear(), 2.0 * EListRounds * EListLength);
+    saberstl::test::report("lists, new/delete", lists(use_new()), 2.0 * EListRounds * EListLength);
+    remote(use_pool{ pool }, "object_pool");
+    remote(use_new(), "new/delete");
+    return 0;
+}
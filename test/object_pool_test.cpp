@@ -0,0 +1,157 @@
+/*
+ * object_pool: freed slots are reused before a new slab is taken, clear()
+ * and the end of a thread destroy the objects still in use through the
+ * bitmap and no others, and objects freed by another thread come back to
+ * the pool that made them.
+*/
+
+#include <atomic>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "saber_object_pool.h"
+#include "test_util.h"
+
+namespace {
+
+std::atomic<int> live(0);
+
+/* Counts the objects alive, and checks it is destroyed once */
+struct tracked {
+    int value;
+    unsigned magic;
+
+    explicit tracked(int v) : value(v), magic(0x5AFEu) { live++; }
+    ~tracked() {
+        EXPECT(magic == 0x5AFEu);
+        magic = 0;
+        live--;
+    }
+};
+
+struct node {
+    node *next;
+    long key;
+};
+
+typedef saberstl::object_pool<tracked> tracked_pool;
+
+} // namespace
+
+int main() {
+    {
+        /* Freed slots are handed out again, in a slab already there */
+        saberstl::object_pool<node> pool;
+        std::vector<node*> nodes;
+        for (int i = 0; i < 1000; i++) nodes.push_back(pool.create(node{ nullptr, i }));
+        EXPECT(pool.size() == 1000);
+        const size_t cap = pool.capacity();
+        EXPECT(cap >= 1000);
+        std::set<node*> first(nodes.begin(), nodes.end());
+        for (node *n : nodes) pool.destroy(n);
+        EXPECT(pool.size() == 0);
+        for (int round = 0; round < 10; round++) {
+            for (node *&n : nodes) {
+                n = pool.create(node{ nullptr, round });
+                EXPECT(first.count(n) == 1);
+            }
+            for (node *n : nodes) pool.destroy(n);
+        }
+        EXPECT(pool.capacity() == cap);
+        pool.clear();
+        EXPECT(pool.capacity() == 0 && pool.size() == 0);
+    }
+    {
+        /* clear() destroys only the objects still in use, over several slabs */
+        tracked_pool pool;
+        std::vector<tracked*> objs;
+        for (int i = 0; i < 5000; i++) objs.push_back(pool.create(i));
+        for (size_t i = 0; i < objs.size(); i += 3) pool.destroy(objs[i]);
+        const int left = live.load();
+        EXPECT(left == 5000 - 1667);
+        EXPECT(pool.size() == static_cast<size_t>(left));
+        for (size_t i = 1; i < objs.size(); i += 3) EXPECT(objs[i]->value == static_cast<int>(i));
+        pool.clear();
+        EXPECT(live == 0);
+        /* The pool is usable again */
+        tracked *t = pool.create(42);
+        EXPECT(t->value == 42 && live == 1);
+    }
+    EXPECT(live == 0);
+    {
+        /* The pool of a thread destroys its objects when the thread exits */
+        std::thread t([] {
+            for (int i = 0; i < 300; i++) tracked_pool::local().create(i);
+            tracked_pool::local().destroy(tracked_pool::local().create(-1));
+            EXPECT(live == 300);
+        });
+        t.join();
+        EXPECT(live == 0);
+    }
+    {
+        /* Objects made by one thread and freed by others */
+        enum { EObjects = 20000, EFreers = 4 };
+        tracked_pool& pool = tracked_pool::local();
+        std::vector<tracked*> objs;
+        for (int i = 0; i < EObjects; i++) objs.push_back(pool.create(i));
+        const size_t cap = pool.capacity();
+        std::set<tracked*> made(objs.begin(), objs.end());
+        std::vector<std::thread> freers;
+        for (int f = 0; f < EFreers; f++) {
+            freers.emplace_back([&objs, f] {
+                for (size_t i = f; i < objs.size(); i += EFreers) tracked_pool::local().destroy(objs[i]);
+                /* The pool of this thread has no slab of its own */
+                EXPECT(tracked_pool::local().capacity() == 0);
+            });
+        }
+        for (std::thread& t : freers) t.join();
+        EXPECT(live == 0);
+        /* The freed slots are taken back before any new slab */
+        for (int i = 0; i < EObjects; i++) {
+            tracked *t = pool.create(i);
+            EXPECT(made.count(t) == 1);
+        }
+        EXPECT(pool.capacity() == cap);
+        EXPECT(pool.size() == EObjects);
+        pool.clear();
+        EXPECT(live == 0);
+    }
+    {
+        /* Frees from another thread while the owner keeps allocating */
+        tracked_pool& pool = tracked_pool::local();
+        std::atomic<tracked*> handoff[64];
+        for (std::atomic<tracked*>& h : handoff) h.store(nullptr);
+        std::atomic<bool> done(false);
+        std::thread freer([&] {
+            for (;;) {
+                const bool finished = done.load(std::memory_order_acquire);
+                bool any = false;
+                for (std::atomic<tracked*>& h : handoff) {
+                    tracked *t = h.exchange(nullptr, std::memory_order_acquire);
+                    if (t != nullptr) {
+                        tracked_pool::local().destroy(t);
+                        any = true;
+                    }
+                }
+                if (!any && finished) break;
+            }
+        });
+        saberstl::test::rng rng;
+        for (int i = 0; i < 200000; i++) {
+            tracked *t = pool.create(i);
+            std::atomic<tracked*>& h = handoff[rng.below(64)];
+            tracked *expected = nullptr;
+            if (!h.compare_exchange_strong(expected, t, std::memory_order_release)) pool.destroy(t);
+        }
+        done.store(true, std::memory_order_release);
+        freer.join();
+        EXPECT(live == 0);
+        EXPECT(pool.capacity() < 200000);
+        /* The slots still on the remote list are not destroyed again */
+        pool.clear();
+        EXPECT(pool.size() == 0);
+    }
+    std::printf("object_pool: ok\n");
+    return 0;
+}
@@ -0,0 +1,99 @@
+/*
+ * basic_rope edited with itself as the argument: the rope given to
+ * insert, replace and append shares the root the edit gives up.
+ * Build with SANITIZE=address to catch a use after free.
+ * Also string literals given to insert and replace, and a run of edits
+ * checked against std::string.
+*/
+
+#include <string>
+
+#include "saber_rope.h"
+#include "test_util.h"
+
+namespace {
+
+std::string text(const saberstl::rope& r) {
+    saberstl::string s = r.flatten();
+    return std::string(s.data(), s.size());
+}
+
+/* A rope of several leaves, so the splits cut inner nodes */
+saberstl::rope make_rope() {
+    saberstl::rope r;
+    for (int i = 0; i < 64; i++) r.append(std::string(40, static_cast<char>('a' + i % 26)).c_str());
+    return r;
+}
+
+} // namespace
+
+int main() {
+    {
+        saberstl::rope r("abcdef");
+        r.insert(3, r);
+        EXPECT(text(r) == "abcabcdefdef");
+    }
+    {
+        saberstl::rope r("abcdef");
+        r.replace(1, 2, r);
+        EXPECT(text(r) == "aabcdefdef");
+    }
+    {
+        saberstl::rope r("abcdef");
+        r.append(r);
+        EXPECT(text(r) == "abcdefabcdef");
+    }
+    {
+        saberstl::rope r = make_rope();
+        const std::string s = text(r);
+        r.insert(1000, r);
+        EXPECT(text(r) == s.substr(0, 1000) + s + s.substr(1000));
+    }
+    {
+        saberstl::rope r = make_rope();
+        const std::string s = text(r);
+        r.replace(500, 1200, r);
+        EXPECT(text(r) == s.substr(0, 500) + s + s.substr(1700));
+        r.replace(0, r.size(), r);
+        EXPECT(text(r) == s.substr(0, 500) + s + s.substr(1700));
+    }
+    {
+        saberstl::rope r = make_rope();
+        const std::string s = text(r);
+        r += r;
+        r.insert(r.size(), r);
+        EXPECT(text(r) == s + s + s + s);
+    }
+    {
+        saberstl::rope r("abcdef");
+        r.insert(2, "xy");
+        EXPECT(text(r) == "abxycdef");
+        r.replace(0, 4, "Q");
+        EXPECT(text(r) == "Qcdef");
+        r.replace(1, 0, saberstl::string_view("--"));
+        EXPECT(text(r) == "Q--cdef");
+        r.insert(r.size(), saberstl::string_view("!"));
+        EXPECT(text(r) == "Q--cdef!");
+    }
+    {
+        /* Small inserts all over a large rope make S_join rebalance */
+        saberstl::rope r = make_rope();
+        std::string s = text(r);
+        saberstl::test::rng rng(7);
+        for (int i = 0; i < 2000; i++) {
+            const size_t pos = rng.below(s.size() + 1);
+            const size_t count = rng.below(8);
+            if (i % 3 == 0) {
+                r.insert(pos, "xyz");
+                s.insert(pos, "xyz");
+            }
+            else {
+                r.replace(pos, count, "k");
+                s.replace(pos, count, "k");
+            }
+        }
+        EXPECT(text(r) == s);
+    }
+    std::printf("rope: ok\n");
+    return 0;
+}
@@ -0,0 +1,85 @@
+/*
+ * Building a large text from many small pieces and numbers: string_builder
+ * with one final str(), with an arena, and written out through iovec,
+ * against repeated appends to basic_string and to std::string. Only the
+ * calls of operator new are counted, the arena takes its blocks from
+ * std::malloc.
+*/
+
+#include <string>
+
+#include "saber_string_builder.h"
+#include "new_counter.h"
+#include "test_util.h"
+
+namespace {
+
+enum { ERecords = 1 << 17, ERounds = 8 };
+
+const char *const keys[] = { "latency_ms", "bytes_in", "bytes_out", "requests" };
+
+/* Time per record and allocations per text built */
+void report(const char *name, double seconds, size_t allocs) {
+    std::printf("  %-44s %10.2f ns/record %8.1f allocs/text\n", name,
+                seconds * 1e9 / (static_cast<double>(ERecords) * ERounds),
+                static_cast<double>(allocs) / ERounds);
+}
+
+} // namespace
+
+int main() {
+    std::printf("string building, %d records of a key, a number and a newline\n", ERecords);
+    size_t sum = 0;
+
+    size_t allocs = saberstl::test::new_count();
+    saberstl::test::timer t;
+    for (int r = 0; r < ERounds; r++) {
+        saberstl::string_builder b;
+        for (int i = 0; i < ERecords; i++) b << keys[i & 3] << '=' << i << '\n';
+        saberstl::string s = b.str();
+        sum += s.size();
+    }
+    report("string_builder, str()", t.seconds(), saberstl::test::new_count() - allocs);
+
+    allocs = saberstl::test::new_count();
+    t = saberstl::test::timer();
+    for (int r = 0; r < ERounds; r++) {
+        saberstl::monotonic_arena arena;
+        saberstl::string_builder b(arena);
+        for (int i = 0; i < ERecords; i++) b << keys[i & 3] << '=' << i << '\n';
+        struct iovec iov[256];
+        const size_t n = b.to_iovec(iov, 256);
+        for (size_t k = 0; k < n; k++) sum += iov[k].iov_len;
+    }
+    report("string_builder on an arena, to_iovec()", t.seconds(), saberstl::test::new_count() - allocs);
+
+    allocs = saberstl::test::new_count();
+    t = saberstl::test::timer();
+    for (int r = 0; r < ERounds; r++) {
+        saberstl::string s;
+        for (int i = 0; i < ERecords; i++) {
+            s.append(keys[i & 3]);
+            s.push_back('=');
+            saberstl::append_chars(s, i);
+            s.push_back('\n');
+        }
+        sum += s.size();
+    }
+    report("saberstl::string appends", t.seconds(), saberstl::test::new_count() - allocs);
+
+    allocs = saberstl::test::new_count();
+    t = saberstl::test::timer();
+    for (int r = 0; r < ERounds; r++) {
+        std::string s;
+        for (int i = 0; i < ERecords; i++) {
+            s.append(keys[i & 3]);
+            s.push_back('=');
+            s.append(std::to_string(i));
+            s.push_back('\n');
+        }
+        sum += s.size();
+    }
+    report("std::string appends", t.seconds(), saberstl::test::new_count() - allocs);
+    saberstl::test::keep(sum);
+    return 0;
+}
@@ -0,0 +1,159 @@
+/*
+ * basic_string_builder across the edges of its chunks: appends that fill
+ * a chunk exactly or spill into the next, append(count, ch) over several
+ * chunks, appendf in the room of a chunk and past it, str() of the exact
+ * size, to_iovec with fewer iovec than chunks, and chunks from an arena.
+*/
+
+#include <cstring>
+#include <string>
+
+#include "saber_string_builder.h"
+#include "test_util.h"
+
+namespace {
+
+std::string text(const saberstl::string_builder& b) {
+    std::string s;
+    b.for_each_chunk([&](saberstl::string_view v) { s.append(v.data(), v.size()); });
+    return s;
+}
+
+std::string joined(const struct iovec* iov, size_t n) {
+    std::string s;
+    for (size_t i = 0; i < n; i++) s.append(static_cast<const char*>(iov[i].iov_base), iov[i].iov_len);
+    return s;
+}
+
+} // namespace
+
+int main() {
+    const size_t first = saberstl::EBuilderInitBytes;
+    {
+        /* Fill the first chunk exactly, then one more character */
+        saberstl::string_builder b;
+        const std::string full(first, 'x');
+        b.append(full.data(), full.size());
+        EXPECT(b.chunk_count() == 1);
+        b.push_back('y');
+        EXPECT(b.chunk_count() == 2);
+        EXPECT(text(b) == full + "y");
+    }
+    {
+        /* A piece larger than the room is split over the two chunks */
+        saberstl::string_builder b;
+        std::string expect(first - 3, 'a');
+        b.append(expect.data(), expect.size());
+        b.append("0123456789");
+        expect += "0123456789";
+        EXPECT(b.chunk_count() == 2);
+        EXPECT(text(b) == expect);
+        /* A piece larger than the next chunk gets a chunk of its own size */
+        const std::string big(first * 8, 'b');
+        b.append(big.data(), big.size());
+        expect += big;
+        EXPECT(text(b) == expect);
+        EXPECT(b.size() == expect.size());
+    }
+    {
+        saberstl::string_builder b;
+        b.append(first - 1, '-');
+        b.append(first * 5, '=');
+        EXPECT(b.chunk_count() >= 2);
+        EXPECT(text(b) == std::string(first - 1, '-') + std::string(first * 5, '='));
+    }
+    {
+        /* str() is the text and no larger */
+        saberstl::string_builder b;
+        std::string expect;
+        for (int i = 0; i < 2000; i++) {
+            b << "item " << i << ';';
+            expect += "item " + std::to_string(i) + ";";
+        }
+        const saberstl::string s = b.str();
+        EXPECT(s.size() == expect.size());
+        EXPECT(s.capacity() == expect.size());
+        EXPECT(std::string(s.data(), s.size()) == expect);
+        EXPECT(s.data()[s.size()] == '\0');
+    }
+    {
+        /* appendf in the room of a chunk, then one that does not fit */
+        saberstl::string_builder b;
+        b.appendf("%s=%d", "answer", 42);
+        EXPECT(b.chunk_count() == 1);
+        std::string expect = "answer=42";
+        b.append(first - expect.size() - 4, '.');
+        expect += std::string(first - expect.size() - 4, '.');
+        b.appendf("%08.3f", 3.14159);
+        expect += "0003.142";
+        EXPECT(b.chunk_count() == 2);
+        b.appendf("%s", "");
+        b.appendf("%c", '!');
+        expect += "!";
+        const std::string wide(first * 3, 'w');
+        b.appendf("[%s]", wide.c_str());
+        expect += "[" + wide + "]";
+        EXPECT(text(b) == expect);
+        EXPECT(b.size() == expect.size());
+    }
+    {
+        /* appendf that exactly fills the room needs a new chunk for the null */
+        saberstl::string_builder b;
+        b.append(first - 4, 'z');
+        b.appendf("%d", 1234);
+        EXPECT(b.chunk_count() == 2);
+        EXPECT(text(b) == std::string(first - 4, 'z') + "1234");
+        b.appendf("%d", 5);
+        EXPECT(b.chunk_count() == 2);
+    }
+    {
+        /* to_iovec fills at most count entries, in order */
+        saberstl::string_builder b;
+        for (int i = 0; i < 20000; i++) b << i << ',';
+        const size_t chunks = b.chunk_count();
+        EXPECT(chunks > 3);
+        struct iovec iov[64];
+        EXPECT(b.to_iovec(iov, 64) == chunks);
+        const std::string all = text(b);
+        EXPECT(joined(iov, chunks) == all);
+        EXPECT(b.to_iovec(iov, 2) == 2);
+        const std::string two = joined(iov, 2);
+        EXPECT(all.compare(0, two.size(), two) == 0);
+        EXPECT(two.size() < all.size());
+        EXPECT(b.to_iovec(iov, 0) == 0);
+    }
+    {
+        /* The chunks of an arena are left to it */
+        saberstl::monotonic_arena arena;
+        std::string expect;
+        {
+            saberstl::string_builder b(arena);
+            for (int i = 0; i < 5000; i++) {
+                b << "k" << i << ' ';
+                expect += "k" + std::to_string(i) + " ";
+            }
+            b.appendf("%s", "end");
+            expect += "end";
+            EXPECT(text(b) == expect);
+            EXPECT(arena.bytes_used() >= expect.size());
+            const saberstl::string s = b.str();
+            EXPECT(std::string(s.data(), s.size()) == expect);
+        }
+        const size_t used = arena.bytes_used();
+        EXPECT(used >= expect.size());
+        saberstl::string_builder again(arena);
+        again.append("more");
+        EXPECT(arena.bytes_used() > used);
+        EXPECT(text(again) == "more");
+    }
+    {
+        saberstl::wstring_builder b;
+        b.append(first, L'w');
+        b << 12345;
+        EXPECT(b.size() == first + 5);
+        const saberstl::wstring s = b.str();
+        EXPECT(s.size() == first + 5 && s[first] == L'1' && s[first + 4] == L'5');
+    }
+    std::printf("string_builder: ok\n");
+    return 0;
+}
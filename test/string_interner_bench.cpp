@@ -0,0 +1,108 @@
+/*
+ * string_interner: the memory of many copies of a few distinct tags,
+ * interned against kept as basic_string, the throughput of interning tags
+ * already in the pool from 1 to 4 threads, and equality and hashing of
+ * handles against basic_string.
+*/
+
+#include <thread>
+#include <vector>
+
+#include "saber_string_interner.h"
+#include "test_util.h"
+
+namespace {
+
+enum { EDistinct = 1 << 17, ETags = 1 << 21, ELookups = 1 << 21 };
+
+/* Tags such as "service.region.host.metric_1234", 24 to 40 characters */
+std::vector<saberstl::string> make_distinct() {
+    static const char *const parts[] = { "frontend", "backend", "eu-west", "us-east",
+                                         "host", "db", "latency", "requests" };
+    std::vector<saberstl::string> tags(EDistinct);
+    saberstl::test::rng r;
+    for (int i = 0; i < EDistinct; i++) {
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), "%s.%s.%s.metric_%d", parts[r.below(8)],
+                      parts[r.below(8)], parts[r.below(8)], i);
+        tags[i] = buf;
+    }
+    return tags;
+}
+
+/* Bytes of a basic_string and of its buffer, if the buffer is not inline */
+size_t string_bytes(const saberstl::string& s) {
+    const char *self = reinterpret_cast<const char*>(&s);
+    const bool inline_buffer = s.data() >= self && s.data() < self + sizeof(s);
+    return sizeof(s) + (inline_buffer ? 0 : s.capacity() + 1);
+}
+
+} // namespace
+
+int main() {
+    const std::vector<saberstl::string> distinct = make_distinct();
+    std::vector<size_t> picks(ETags);
+    saberstl::test::rng r;
+    for (size_t& p : picks) p = r.below(EDistinct);
+
+    std::printf("string_interner, %d tags of %d distinct\n", ETags, EDistinct);
+
+    /* Memory */
+    saberstl::string_interner pool;
+    std::vector<saberstl::interned_string> handles(ETags);
+    saberstl::test::timer t;
+    for (int i = 0; i < ETags; i++) handles[i] = pool.intern(distinct[picks[i]]);
+    saberstl::test::report("intern, mostly known tags", t.seconds(), ETags);
+
+    std::vector<saberstl::string> copies(ETags);
+    size_t copy_bytes = 0;
+    for (int i = 0; i < ETags; i++) {
+        copies[i] = distinct[picks[i]];
+        copy_bytes += string_bytes(copies[i]);
+    }
+    std::printf("  %-44s %10.2f MiB\n", "kept as basic_string",
+                copy_bytes / 1048576.0);
+    std::printf("  %-44s %10.2f MiB\n", "interned, handles and pool",
+                (ETags * sizeof(saberstl::interned_string) + pool.bytes_reserved()) / 1048576.0);
+
+    /* Lookup throughput from several threads */
+    char name[64];
+    for (unsigned n = 1; n <= 4; n <<= 1) {
+        std::vector<std::thread> threads;
+        saberstl::test::timer tt;
+        for (unsigned id = 0; id < n; id++) {
+            threads.emplace_back([id, &pool, &distinct, &picks] {
+                size_t sum = 0;
+                for (int i = 0; i < ELookups; i++) {
+                    sum += pool.intern(distinct[picks[(i + id * 7919) % ETags]]).hash();
+                }
+                saberstl::test::keep(sum);
+            });
+        }
+        for (std::thread& th : threads) th.join();
+        std::snprintf(name, sizeof(name), "intern known tags, %u threads", n);
+        saberstl::test::report(name, tt.seconds(), static_cast<double>(ELookups) * n);
+    }
+
+    /* Equality and hashing */
+    const saberstl::interned_string handle_target = handles[0];
+    const saberstl::string& string_target = copies[0];
+    size_t matches = 0;
+    t = saberstl::test::timer();
+    for (int i = 0; i < ETags; i++) matches += handles[i] == handle_target;
+    saberstl::test::report("== of handles", t.seconds(), ETags);
+    t = saberstl::test::timer();
+    for (int i = 0; i < ETags; i++) matches += copies[i] == string_target;
+    saberstl::test::report("== of basic_string", t.seconds(), ETags);
+
+    size_t sum = 0;
+    t = saberstl::test::timer();
+    for (int i = 0; i < ETags; i++) sum += saberstl::hash<saberstl::interned_string>()(handles[i]);
+    saberstl::test::report("hash of handles", t.seconds(), ETags);
+    t = saberstl::test::timer();
+    for (int i = 0; i < ETags; i++) sum += saberstl::hash<saberstl::string>()(copies[i]);
+    saberstl::test::report("hash of basic_string", t.seconds(), ETags);
+    saberstl::test::keep(matches);
+    saberstl::test::keep(sum);
+    return 0;
+}
@@ -0,0 +1,110 @@
+/*
+ * string_interner: a string interned twice, from any form, gives the same
+ * handle, distinct strings give distinct ones, and the handles stay valid
+ * while the tables grow. find never adds, and interning a string already
+ * there never grows a table. Threads interning the same strings at once
+ * all get the same handles.
+*/
+
+#include <thread>
+#include <vector>
+
+#include "saber_string_interner.h"
+#include "test_util.h"
+
+namespace {
+
+enum { EStrings = 2000, EThreads = 4 };
+
+typedef saberstl::string_interner interner;
+typedef saberstl::interned_string handle;
+typedef saberstl::string_view view;
+
+saberstl::string name(int i) {
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "tag-%d", i * 7919);
+    return saberstl::string(buf);
+}
+
+} // namespace
+
+int main() {
+    {
+        /* One record per distinct string */
+        interner pool;
+        const handle a = pool.intern("alpha");
+        EXPECT(pool.intern(view("alpha")) == a);
+        EXPECT(pool.intern(saberstl::string("alpha")) == a);
+        EXPECT(pool.intern(view("alphabet").substr(0, 5)) == a);
+        const handle b = pool.intern("beta");
+        EXPECT(a != b);
+        EXPECT(pool.size() == 2);
+        EXPECT(a.view() == view("alpha") && a.size() == 5 && a.c_str()[5] == '\0');
+        EXPECT(a.hash() == saberstl::hash<view>()(view("alpha")));
+        EXPECT(saberstl::hash<handle>()(b) == saberstl::hash<view>()(view("beta")));
+        /* The empty string is the default handle, with no record */
+        EXPECT(pool.intern("") == handle());
+        EXPECT(handle().empty() && handle().size() == 0 && handle().c_str()[0] == '\0');
+        EXPECT(handle().hash() == saberstl::hash<view>()(view()));
+        EXPECT(pool.size() == 2);
+    }
+    {
+        /* find hits only what was interned, and never adds */
+        interner pool;
+        EXPECT(pool.find("nothing") == handle());
+        const handle a = pool.intern("here");
+        EXPECT(pool.find("here") == a);
+        EXPECT(pool.find("her") == handle());
+        EXPECT(pool.find("here!") == handle());
+        EXPECT(pool.find("") == handle());
+        EXPECT(pool.size() == 1);
+    }
+    {
+        /* Handles survive the growth of the tables; a string already there
+           does not grow one, even when its shard is at the grow point */
+        interner pool;
+        std::vector<handle> handles;
+        for (int i = 0; i < EStrings; i++) {
+            handles.push_back(pool.intern(name(i)));
+            const size_t reserved = pool.bytes_reserved();
+            EXPECT(pool.intern(name(i)) == handles.back());
+            EXPECT(pool.bytes_reserved() == reserved);
+        }
+        EXPECT(pool.size() == EStrings);
+        for (int i = 0; i < EStrings; i++) {
+            EXPECT(handles[i].view() == view(name(i)));
+            EXPECT(pool.find(name(i)) == handles[i]);
+        }
+        EXPECT(pool.bytes_used() <= pool.bytes_reserved());
+    }
+    {
+        /* The same strings interned by several threads at once */
+        interner pool;
+        std::vector<std::vector<handle>> got(EThreads, std::vector<handle>(EStrings));
+        std::vector<std::thread> threads;
+        for (int t = 0; t < EThreads; t++) {
+            threads.emplace_back([&pool, &got, t] {
+                /* Each thread walks the strings in its own order, by a
+                   step prime to EStrings */
+                static const int steps[EThreads] = { 1, 3, 7, 9 };
+                for (int k = 0; k < EStrings; k++) {
+                    const int i = (k * steps[t] + t * 101) % EStrings;
+                    got[t][i] = pool.intern(name(i));
+                }
+            });
+        }
+        for (std::thread& t : threads) t.join();
+        EXPECT(pool.size() == EStrings);
+        for (int i = 0; i < EStrings; i++) {
+            for (int t = 1; t < EThreads; t++) EXPECT(got[t][i] == got[0][i]);
+            EXPECT(got[0][i].view() == view(name(i)));
+        }
+    }
+    {
+        saberstl::wstring_interner pool;
+        EXPECT(pool.intern(L"wide") == pool.intern(saberstl::wstring(L"wide")));
+        EXPECT(pool.intern(L"wide") != pool.intern(L"wider"));
+    }
+    std::printf("string_interner: ok\n");
+    return 0;
+}
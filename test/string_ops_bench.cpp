@@ -0,0 +1,82 @@
+/*
+ * Text assembly with basic_string against std::string: appends of short
+ * pieces with and without reserve, operator+ chains, and insert, erase
+ * and replace in the middle of a line.
+*/
+
+#include <string>
+#include <vector>
+
+#include "saber_basic_string.h"
+#include "new_counter.h"
+#include "test_util.h"
+
+namespace {
+
+enum { ELines = 1 << 16, EPiecesPerLine = 16, ERounds = 16 };
+
+const char *const pieces[] = { "GET ", "/api/v1/items", "?id=", "1234567", " HTTP/1.1", "\r\n",
+                               "host: ", "example.org", "user-agent: ", "bench/1.0" };
+enum { EPieceKinds = sizeof(pieces) / sizeof(pieces[0]) };
+
+template <class String>
+void run(const char *type) {
+    char name[64];
+    const String a("timestamp=1700000000"), b(" level=info"), c(" component=frontend"),
+                 d(" message=request served");
+
+    size_t allocs = saberstl::test::new_count();
+    saberstl::test::timer t;
+    for (int r = 0; r < ERounds; r++) {
+        String out;
+        for (int i = 0; i < ELines * EPiecesPerLine; i++) out.append(pieces[i % EPieceKinds]);
+        saberstl::test::keep(out);
+    }
+    std::snprintf(name, sizeof(name), "%s append", type);
+    saberstl::test::report(name, t.seconds(), static_cast<double>(ERounds) * ELines * EPiecesPerLine,
+                           saberstl::test::new_count() - allocs);
+
+    allocs = saberstl::test::new_count();
+    t = saberstl::test::timer();
+    for (int r = 0; r < ERounds; r++) {
+        String out;
+        out.reserve(static_cast<size_t>(ELines) * EPiecesPerLine * 8);
+        for (int i = 0; i < ELines * EPiecesPerLine; i++) out.append(pieces[i % EPieceKinds]);
+        saberstl::test::keep(out);
+    }
+    std::snprintf(name, sizeof(name), "%s append after reserve", type);
+    saberstl::test::report(name, t.seconds(), static_cast<double>(ERounds) * ELines * EPiecesPerLine,
+                           saberstl::test::new_count() - allocs);
+
+    allocs = saberstl::test::new_count();
+    t = saberstl::test::timer();
+    for (int i = 0; i < ELines * ERounds / 4; i++) {
+        String line = a + b + c + d + "\n";
+        saberstl::test::keep(line);
+    }
+    std::snprintf(name, sizeof(name), "%s a + b + c + d + \"\\n\"", type);
+    saberstl::test::report(name, t.seconds(), ELines * ERounds / 4.0,
+                           saberstl::test::new_count() - allocs);
+
+    allocs = saberstl::test::new_count();
+    t = saberstl::test::timer();
+    String line = a + b + c + d;
+    for (int i = 0; i < ELines * ERounds / 4; i++) {
+        line.insert(20, " host=web-01");
+        line.replace(26, 6, "db-02");
+        line.erase(20, 11);
+        saberstl::test::keep(line);
+    }
+    std::snprintf(name, sizeof(name), "%s insert, replace, erase", type);
+    saberstl::test::report(name, t.seconds(), 3.0 * ELines * ERounds / 4,
+                           saberstl::test::new_count() - allocs);
+}
+
+} // namespace
+
+int main() {
+    std::printf("string modifying operations\n");
+    run<saberstl::string>("saberstl::string");
+    run<std::string>("std::string");
+    return 0;
+}
@@ -0,0 +1,89 @@
+/*
+ * Short identifiers in basic_string, which fit the inline buffer and take
+ * no allocation, against std::string: construction from a C string, copy,
+ * move and swap of 6 to 22 character keys such as "metric_1234".
+*/
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "saber_basic_string.h"
+#include "new_counter.h"
+#include "test_util.h"
+
+namespace {
+
+enum { EKeys = 1 << 12, ERounds = 256 };
+
+/* Keys of 6 to 22 characters */
+std::vector<std::vector<char>> make_keys() {
+    static const char *const prefixes[] = { "id_", "metric_", "user.session_", "http.request.path_" };
+    std::vector<std::vector<char>> keys(EKeys);
+    saberstl::test::rng r;
+    for (std::vector<char>& key : keys) {
+        char buf[32];
+        const int n = std::snprintf(buf, sizeof(buf), "%s%u", prefixes[r.below(4)],
+                                    static_cast<unsigned>(r.below(100000)));
+        key.assign(buf, buf + (n < 22 ? n : 22));
+        key.push_back('\0');
+    }
+    return keys;
+}
+
+template <class String>
+void run(const char *type, const std::vector<std::vector<char>>& keys) {
+    const double ops = static_cast<double>(EKeys) * ERounds;
+    char name[64];
+    std::vector<String> a(EKeys), b(EKeys);
+
+    size_t allocs = saberstl::test::new_count();
+    saberstl::test::timer t;
+    for (int r = 0; r < ERounds; r++) {
+        for (int i = 0; i < EKeys; i++) a[i] = String(keys[i].data());
+        saberstl::test::keep(a);
+    }
+    std::snprintf(name, sizeof(name), "%s construct", type);
+    saberstl::test::report(name, t.seconds(), ops, saberstl::test::new_count() - allocs);
+
+    allocs = saberstl::test::new_count();
+    t = saberstl::test::timer();
+    for (int r = 0; r < ERounds; r++) {
+        for (int i = 0; i < EKeys; i++) b[i] = a[i];
+        saberstl::test::keep(b);
+    }
+    std::snprintf(name, sizeof(name), "%s copy", type);
+    saberstl::test::report(name, t.seconds(), ops, saberstl::test::new_count() - allocs);
+
+    allocs = saberstl::test::new_count();
+    t = saberstl::test::timer();
+    for (int r = 0; r < ERounds; r++) {
+        for (int i = 0; i < EKeys; i++) {
+            String tmp(std::move(a[i]));
+            a[i] = std::move(b[i]);
+            b[i] = std::move(tmp);
+        }
+        saberstl::test::keep(a);
+    }
+    std::snprintf(name, sizeof(name), "%s move", type);
+    saberstl::test::report(name, t.seconds(), 3 * ops, saberstl::test::new_count() - allocs);
+
+    allocs = saberstl::test::new_count();
+    t = saberstl::test::timer();
+    for (int r = 0; r < ERounds; r++) {
+        for (int i = 0; i < EKeys; i++) a[i].swap(b[EKeys - 1 - i]);
+        saberstl::test::keep(a);
+    }
+    std::snprintf(name, sizeof(name), "%s swap", type);
+    saberstl::test::report(name, t.seconds(), ops, saberstl::test::new_count() - allocs);
+}
+
+} // namespace
+
+int main() {
+    const std::vector<std::vector<char>> keys = make_keys();
+    std::printf("short strings, %d keys of 6 to 22 characters\n", EKeys);
+    run<saberstl::string>("saberstl::string", keys);
+    run<std::string>("std::string", keys);
+    return 0;
+}
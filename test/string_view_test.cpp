@@ -0,0 +1,129 @@
+/*
+ * basic_string_view: find, rfind, find_first_of and find_first_not_of
+ * agree with std::string at every position of short haystacks, past the
+ * end and at npos, for needles and sets of 0 to 3 characters; substr and
+ * at throw past the end. The view overloads of basic_string give the same
+ * result as their std::string counterparts, also when the view refers to
+ * the string itself.
+*/
+
+#include <stdexcept>
+#include <string>
+
+#include "saber_basic_string.h"
+#include "test_util.h"
+
+namespace {
+
+typedef saberstl::string_view view;
+typedef saberstl::string string;
+
+const size_t npos = view::npos;
+
+/* Haystacks with repeats, to hit the candidate loops of find and rfind */
+const char *const haystacks[] = { "", "a", "ab", "aaa", "abab", "abcabcab", "aabaabaaab", "xyz" };
+const char *const needles[] = { "", "a", "b", "ab", "ba", "aab", "abc", "bab", "z", "xyz" };
+
+void check_search(const char *h, const char *n) {
+    const std::string sh(h);
+    const view vh(h);
+    const size_t count = std::char_traits<char>::length(n);
+    for (size_t pos = 0; pos <= sh.size() + 2; pos++) {
+        EXPECT(vh.find(n, pos, count) == sh.find(n, pos, count));
+        EXPECT(vh.rfind(n, pos, count) == sh.rfind(n, pos, count));
+        EXPECT(vh.find_first_of(n, pos, count) == sh.find_first_of(n, pos, count));
+        EXPECT(vh.find_first_not_of(n, pos, count) == sh.find_first_not_of(n, pos, count));
+        if (count > 0) {
+            EXPECT(vh.find(n[0], pos) == sh.find(n[0], pos));
+            EXPECT(vh.rfind(n[0], pos) == sh.rfind(n[0], pos));
+            EXPECT(vh.find_first_not_of(n[0], pos) == sh.find_first_not_of(n[0], pos));
+        }
+        /* A count of 0 with any needle, not only the empty one */
+        EXPECT(vh.find(n, pos, 0) == sh.find(n, pos, 0));
+        EXPECT(vh.rfind(n, pos, 0) == sh.rfind(n, pos, 0));
+    }
+    EXPECT(vh.find(n, npos, count) == sh.find(n, npos, count));
+    EXPECT(vh.rfind(n, npos, count) == sh.rfind(n, npos, count));
+    EXPECT(vh.rfind(n) == sh.rfind(n));
+    EXPECT(vh.find(view(n)) == sh.find(n));
+    EXPECT(vh.find_first_of(view(n), npos) == npos);
+    EXPECT(vh.find_first_not_of(view(n), npos) == npos);
+}
+
+template <class F>
+bool throws_out_of_range(F f) {
+    try {
+        f();
+    } catch (const std::out_of_range&) {
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+int main() {
+    for (const char *h : haystacks) {
+        for (const char *n : needles) check_search(h, n);
+    }
+    {
+        /* substr, compare and the prefix/suffix checks */
+        const view v("hello world");
+        EXPECT(v.substr(6) == "world");
+        EXPECT(v.substr(11).empty());
+        EXPECT(v.substr(3, 2) == "lo");
+        EXPECT(v.substr(0, npos).size() == 11);
+        EXPECT(throws_out_of_range([&v] { v.substr(12); }));
+        EXPECT(throws_out_of_range([&v] { v.at(11); }));
+        EXPECT(v.compare("hello") > 0 && v.compare("hello world!") < 0 && v.compare("hello world") == 0);
+        EXPECT(v.compare(0, 5, "hello") == 0);
+        EXPECT(v.starts_with("hello") && v.starts_with('h') && !v.starts_with("world"));
+        EXPECT(v.ends_with("world") && v.ends_with('d') && !v.ends_with("hello"));
+        EXPECT(view().starts_with("") && !view().ends_with('x'));
+        EXPECT(view("abc") < view("abd") && view("ab") < view("abc"));
+    }
+    {
+        /* The view overloads of basic_string */
+        std::string ref("0123456789");
+        string s(view("0123456789"));
+        const view mid = view("abcdef").substr(1, 3);      // "bcd"
+        s.append(mid);
+        ref.append("bcd");
+        s.insert(2, mid);
+        ref.insert(2, "bcd");
+        s.replace(5, 4, mid);
+        ref.replace(5, 4, "bcd");
+        s += view("!");
+        ref += "!";
+        s.append(view("xyz"), 1, npos);
+        ref.append("yz");
+        EXPECT(view(s) == view(ref.data(), ref.size()));
+        EXPECT(s.find(mid) == ref.find("bcd"));
+        EXPECT(s.rfind(mid) == ref.rfind("bcd"));
+        EXPECT(s.find_first_of(view("yz")) == ref.find_first_of("yz"));
+        EXPECT(s.find_first_not_of(view("0123")) == ref.find_first_not_of("0123"));
+        EXPECT(s.compare(view(ref.data(), ref.size())) == 0);
+        EXPECT(s.compare(0, 2, view("01")) == 0);
+        EXPECT(saberstl::hash<string>()(s) == saberstl::hash<view>()(view(s)));
+        s = view("assigned");
+        EXPECT(s == "assigned");
+        s.assign(view("reassigned"), 2, 6);
+        EXPECT(s == "assign");
+        EXPECT(throws_out_of_range([&s] { s.insert(s.size() + 1, view("x")); }));
+        EXPECT(throws_out_of_range([&s] { s.replace(s.size() + 1, 0, view("x")); }));
+    }
+    {
+        /* A view of the string itself, through a reallocation */
+        string s("abcdefgh");
+        for (int i = 0; i < 6; i++) s.append(view(s));
+        EXPECT(s.size() == 8u << 6);
+        for (size_t i = 0; i < s.size(); i++) EXPECT(s[i] == "abcdefgh"[i % 8]);
+        string t("0123456789");
+        t.insert(3, view(t).substr(5));
+        EXPECT(t == "01256789" "3456789");
+        t.replace(0, 2, view(t));
+        EXPECT(t == "012567893456789" "2567893456789");
+    }
+    std::printf("string_view: ok\n");
+    return 0;
+}
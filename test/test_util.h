@@ -0,0 +1,78 @@
+#ifndef SABERSTL_TEST_UTIL_H
+#define SABERSTL_TEST_UTIL_H
+
+/*
+ * Helpers shared by the tests and the benchmarks under test/.
+ * A test exits with 1 at the first failed EXPECT, a benchmark prints one
+ * line per case.
+*/
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#define EXPECT(cond)                                                        \
+    do {                                                                    \
+        if (!(cond)) {                                                      \
+            std::fprintf(stderr, "%s:%d: expect failed: %s\n",              \
+                         __FILE__, __LINE__, #cond);                        \
+            std::exit(1);                                                   \
+        }                                                                   \
+    } while (0)
+
+namespace saberstl {
+namespace test {
+
+/* Seconds since the timer was made */
+class timer {
+private:
+    std::chrono::steady_clock::time_point start_;
+
+public:
+    timer() : start_(std::chrono::steady_clock::now()) {}
+
+    double seconds() const {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    }
+};
+
+/* A xorshift generator, the same numbers on every system */
+class rng {
+private:
+    uint64_t state_;
+
+public:
+    explicit rng(uint64_t seed = 0x9E3779B97F4A7C15ull) : state_(seed | 1) {}
+
+    uint64_t next() {
+        state_ ^= state_ << 13;
+        state_ ^= state_ >> 7;
+        state_ ^= state_ << 17;
+        return state_;
+    }
+
+    /* A number in [0, n) */
+    size_t below(size_t n) { return static_cast<size_t>(next() % n); }
+};
+
+/* Print a case of a benchmark as nanoseconds per operation */
+inline void report(const char *name, double seconds, double ops) {
+    std::printf("  %-44s %10.2f ns/op\n", name, seconds * 1e9 / ops);
+}
+
+/* The same with the allocations per operation */
+inline void report(const char *name, double seconds, double ops, size_t allocs) {
+    std::printf("  %-44s %10.2f ns/op %8.2f allocs/op\n", name, seconds * 1e9 / ops, allocs / ops);
+}
+
+/* Keep the compiler from dropping a result */
+template <class T>
+inline void keep(const T& value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+} // namespace test
+} // namespace saberstl
+
+#endif // !SABERSTL_TEST_UTIL_H